@@ -5,149 +5,321 @@
 #include <algorithm>
 #include <stdexcept>
 #include <cmath>
-#include <numeric>
+#include <span>
+#include <chrono>
+#include <thread>
+#include <utility>
+#include <iterator>
+#include <filesystem>
+#include <functional>
+#include <cstdint>
 #include "PositioningSystem.hpp"
 #include "Utils.hpp"
+#include "ThreadPool.hpp"
+#include "Kernels.hpp"
+#include "Matrix.hpp"
+#include "Gemm.hpp"
+#include "VectorExpressions.hpp"
+#include "ModelFile.hpp"
+#include "Activations.hpp"
+#include "FlatDataSet.hpp"
+#include "SampleFile.hpp"
+#include "Optimizers.hpp"
+#include "Profiling.hpp"
 
 namespace CognitiveSystems {
     enum class NeuronType {
         Input, Normal, Output
     };
 
-    class Neuron {
+    namespace Activations = ::NeuralNetwork::Activations;
+
+    /*!
+    * View of a single neuron of a layer. It is cheap to copy and stays valid as long as the layer lives.
+    * BasicNeuron<const Layer> is the read-only variant.
+    */
+    template<class LayerType>
+    class BasicNeuron {
     public:
-        Neuron(size_t inputNeuronNumber, NeuronType type)
-            : type(type), output(-1.f), delta(-1.f) {
-            weights.resize(inputNeuronNumber, 1);
+        static constexpr bool isModifiable = !std::is_const_v<LayerType>;
+
+        BasicNeuron(LayerType& layer, size_t index) noexcept : layer(&layer), index(index) {}
+
+        std::span<const float> getWeights() const noexcept {
+            return std::as_const(*layer).getWeights().row(index);
         }
 
-        const std::vector<float>& getWeights() const noexcept {
-            return weights;
+        std::span<float> getModifiableWeights() const noexcept requires isModifiable {
+            return layer->getModifiableWeights().row(index);
         }
 
-        float getWeight(size_t index) const noexcept {
-            if (index >= weights.size())
+        float getWeight(size_t weightIndex) const {
+            if (weightIndex >= layer->getWeights().cols())
                 throw std::runtime_error("Weights number is less the index provided");
-            return weights[index];
+            return layer->getWeights()(index, weightIndex);
         }
 
         NeuronType getNeuronType() const noexcept {
-            return type;
+            return layer->getNeuronType();
         }
 
-        void learn(float error, float learningRate) {
-            static const auto sigm = [](float x) { return 1 / (1 + exp(-x)); };
-            if (type == NeuronType::Input)
-                return;
-
-            if (weights.size() != inputs.size())
-                throw std::runtime_error("width mismatch!");
-
-            delta = error * (sigm(output) / (1 - sigm(output)));
-
-            for (int i = 0; i < weights.size(); ++i) {
-                auto weight = weights[i];
-                auto input = inputs[i];
-                auto newWeight = weight - input * delta * learningRate;
-                weights[i] = newWeight;
-            }
+        void learn(float error, float learningRate) const requires isModifiable {
+            layer->learn(index, error, learningRate);
         }
 
         float getOutput() const noexcept {
-            return output;
+            return layer->getOutputs()[index];
         }
 
-        float getDelta() const {
-            return delta;
+        float getDelta() const noexcept {
+            return layer->getDeltas()[index];
         }
 
-        float feedForward(const std::vector<float>& inputs) const {
+        /*! Computes the output without remembering anything, so it is safe to call from many threads. */
+        float activate(std::span<const float> inputs) const {
+            const auto weights = getWeights();
             if (weights.size() != inputs.size())
                 throw std::runtime_error("input signals number is no equal to the weights number");
-            Neuron::inputs = inputs;
 
-            float sum = std::inner_product(weights.begin(), weights.end(), inputs.begin(), 0.f);
+            float sum = ::NeuralNetwork::Kernels::dot(weights.data(), inputs.data(), weights.size());
 
-            return output = type == NeuronType::Input? sum : (1 / (1 + exp(-sum)));
+            return getNeuronType() == NeuronType::Input? sum : std::remove_const_t<LayerType>::Activation::activate(sum);
         }
 
     private:
-        std::vector<float> weights;
-        mutable std::vector<float> inputs;
-        NeuronType type;
-        float delta;
-        mutable float output;
+        LayerType* layer;
+        size_t index;
     };
 
-    class Layer {
+    /*!
+    * Layer stores its neurons as a structure of arrays: one weight matrix (a row per neuron),
+    * one input buffer shared by all neurons and arrays of outputs and deltas.
+    * Neurons are thin views over a row of these arrays.
+    * Outputs of normal and output neurons go through ActivationFunction, and deltas are computed
+    * from these cached outputs, so learning does not evaluate the activation again.
+    */
+    template<Activations::Activation ActivationFunction>
+    class BasicLayer {
     public:
-        using LayerIterator = std::vector<Neuron>::iterator;
-        using ReverseLayerIterator = std::vector<Neuron>::reverse_iterator;
+        using Activation = ActivationFunction;
+        using Neuron = BasicNeuron<BasicLayer>;
+        using ConstNeuron = BasicNeuron<const BasicLayer>;
+
+        template<class LayerType>
+        class Iterator {
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using iterator_concept = std::bidirectional_iterator_tag;
+            using difference_type = std::ptrdiff_t;
+            using value_type = BasicNeuron<LayerType>;
+            using reference = value_type;
+            using pointer = void;
+
+            Iterator() noexcept : layer(nullptr), index(0) {}
+            Iterator(LayerType* layer, size_t index) noexcept : layer(layer), index(index) {}
+
+            value_type operator*() const noexcept {
+                return value_type(*layer, index);
+            }
+
+            Iterator& operator++() noexcept {
+                ++index;
+                return *this;
+            }
+
+            Iterator operator++(int) noexcept {
+                auto tmp = *this;
+                ++index;
+                return tmp;
+            }
+
+            Iterator& operator--() noexcept {
+                --index;
+                return *this;
+            }
+
+            Iterator operator--(int) noexcept {
+                auto tmp = *this;
+                --index;
+                return tmp;
+            }
+
+            bool operator==(const Iterator& iterator) const noexcept = default;
+
+        private:
+            LayerType* layer;
+            size_t index;
+        };
+
+        using LayerIterator = Iterator<BasicLayer>;
+        using ReverseLayerIterator = std::reverse_iterator<LayerIterator>;
 
     public:
-        Layer(const int neuronsInLayer, const int eachNeuronsInputsNumber, NeuronType layerNeuronsType)
-            : type(layerNeuronsType) {
-            neurons.resize(neuronsInLayer, Neuron(eachNeuronsInputsNumber, layerNeuronsType));
-        }
+        BasicLayer(const int neuronsInLayer, const int eachNeuronsInputsNumber, NeuronType layerNeuronsType)
+            : weights(neuronsInLayer, eachNeuronsInputsNumber, 1.f),
+              inputs(eachNeuronsInputsNumber, 0.f),
+              outputs(neuronsInLayer, -1.f),
+              deltas(neuronsInLayer, -1.f),
+              type(layerNeuronsType) {}
 
-        const std::vector<Neuron>& getNeurons() const noexcept {
+        /*! Layer over already existing weights (a row per neuron), e.g. mapped from a model file. */
+        BasicLayer(::NeuralNetwork::Matrix<float>&& layerWeights, NeuronType layerNeuronsType)
+            : weights(std::move(layerWeights)),
+              inputs(weights.cols(), 0.f),
+              outputs(weights.rows(), -1.f),
+              deltas(weights.rows(), -1.f),
+              type(layerNeuronsType) {}
+
+        std::vector<ConstNeuron> getNeurons() const {
+            std::vector<ConstNeuron> neurons;
+            neurons.reserve(weights.rows());
+            for (size_t k = 0; k < weights.rows(); ++k) {
+                neurons.emplace_back(*this, k);
+            }
             return neurons;
         }
 
-        std::vector<Neuron>& getModifiableNeurons() noexcept {
+        std::vector<Neuron> getModifiableNeurons() {
+            std::vector<Neuron> neurons;
+            neurons.reserve(weights.rows());
+            for (size_t k = 0; k < weights.rows(); ++k) {
+                neurons.emplace_back(*this, k);
+            }
             return neurons;
         }
 
-        Neuron& getNeuron(const size_t index) noexcept {
-            if (neurons.size() <= index) {
+        Neuron getNeuron(const size_t index) {
+            if (getSize() <= index) {
                 throw std::runtime_error("Neurons number in layer is less than index provided");
             }
-            return neurons[index];
+            return Neuron(*this, index);
         }
 
         int getSize() const noexcept {
-            return static_cast<int>(neurons.size());
+            return static_cast<int>(weights.rows());
+        }
+
+        int getInputsNumber() const noexcept {
+            return static_cast<int>(weights.cols());
+        }
+
+        NeuronType getNeuronType() const noexcept {
+            return type;
+        }
+
+        const ::NeuralNetwork::Matrix<float>& getWeights() const noexcept {
+            return weights;
+        }
+
+        ::NeuralNetwork::Matrix<float>& getModifiableWeights() noexcept {
+            return weights;
         }
 
         LayerIterator begin() noexcept {
-            return neurons.begin();
+            return { this, 0 };
         }
 
         LayerIterator end() noexcept {
-            return neurons.end();
+            return { this, weights.rows() };
         }
 
-        ReverseLayerIterator rbegin()noexcept {
-            return neurons.rbegin();
+        ReverseLayerIterator rbegin() noexcept {
+            return ReverseLayerIterator(end());
         }
 
         ReverseLayerIterator rend() noexcept {
-            return neurons.rend();
+            return ReverseLayerIterator(begin());
+        }
+
+        std::vector<float> getSignals() const {
+            return outputs;
+        }
+
+        const std::vector<float>& getInputs() const noexcept {
+            return inputs;
+        }
+
+        const std::vector<float>& getOutputs() const noexcept {
+            return outputs;
+        }
+
+        const std::vector<float>& getDeltas() const noexcept {
+            return deltas;
+        }
+
+        /*! Computes outputs for `layerInputs` without remembering anything, so it is safe to call from many threads. */
+        void activate(std::span<const float> layerInputs, std::span<float> layerOutputs) const {
+            if (type == NeuronType::Input) {
+                if (layerInputs.size() != weights.rows() || layerOutputs.size() != weights.rows())
+                    throw std::runtime_error("input signals number is not equal to the input layer neurons number");
+                for (size_t k = 0; k < weights.rows(); ++k) {
+                    layerOutputs[k] = layerInputs[k] * weights(k, 0);
+                }
+                return;
+            }
+
+            if (layerInputs.size() != weights.cols() || layerOutputs.size() != weights.rows())
+                throw std::runtime_error("input signals number is no equal to the weights number");
+            const auto& kernels = ::NeuralNetwork::Kernels::getBestKernels();
+            for (size_t k = 0; k < weights.rows(); ++k) {
+                layerOutputs[k] = kernels.dot(weights.row(k).data(), layerInputs.data(), weights.cols());
+            }
+            ActivationFunction::activate(layerOutputs.data(), layerOutputs.size());
+        }
+
+        /*! Computes outputs and remembers inputs and outputs for learn. */
+        const std::vector<float>& feedForward(std::span<const float> layerInputs) {
+            activate(layerInputs, outputs);
+            inputs.assign(layerInputs.begin(), layerInputs.end());
+            return outputs;
         }
 
-        std::vector<float> getSignals() const noexcept {
-            std::vector<float> signals;
-            for (auto& neuron : neurons) {
-                signals.push_back(neuron.getOutput());
+        /*! Corrects weights of all neurons by their errors on the last feedForward. */
+        void learn(std::span<const float> errors, float learningRate) {
+            if (type == NeuronType::Input)
+                return;
+            if (errors.size() != weights.rows())
+                throw std::runtime_error("errors number is not equal to the neurons number");
+
+            for (size_t k = 0; k < weights.rows(); ++k) {
+                learn(k, errors[k], learningRate);
             }
-            return signals;
+        }
+
+        /*! Corrects weights of one neuron by its error on the last feedForward. */
+        void learn(size_t index, float error, float learningRate) {
+            if (type == NeuronType::Input)
+                return;
+
+            deltas[index] = error * ActivationFunction::derivative(outputs[index]);
+            auto neuronWeights = weights.row(index);
+            ::NeuralNetwork::Expressions::assign(neuronWeights, neuronWeights - inputs * deltas[index] * learningRate);
         }
 
     private:
-        std::vector<Neuron> neurons;
+        ::NeuralNetwork::Matrix<float> weights;
+        std::vector<float> inputs;
+        std::vector<float> outputs;
+        std::vector<float> deltas;
         NeuronType type;
     };
 
+    using Layer = BasicLayer<Activations::Sigmoid>;
+    using Neuron = Layer::Neuron;
+
+    template<Activations::Activation ActivationFunction>
+    class BasicNeuralNetwork;
+
     class Topology {
     public:
         Topology(int inputNeuronsNumber, std::initializer_list<int> hiddenLayersNeuronsNumbers, int outputNeuronsNumber)
             : inputNumber(inputNeuronsNumber), hiddenLayers(hiddenLayersNeuronsNumbers), outputNumber(outputNeuronsNumber) {}
 
         Topology(int inputNeuronsNumber, const std::vector<int>& hiddenLayersNeuronsNumeber, int outputNeuronsNumber)
-            : inputNumber(inputNeuronsNumber), hiddenLayers(hiddenLayers), outputNumber(outputNeuronsNumber) {}
+            : inputNumber(inputNeuronsNumber), hiddenLayers(hiddenLayersNeuronsNumeber), outputNumber(outputNeuronsNumber) {}
 
         Topology(int inputNeuronsNumber, std::vector<int>&& hiddenLayersNeuronsNumeber, int outputNeuronsNumber)
-            : inputNumber(inputNeuronsNumber), hiddenLayers(std::move(hiddenLayers)), outputNumber(outputNeuronsNumber) {}
+            : inputNumber(inputNeuronsNumber), hiddenLayers(std::move(hiddenLayersNeuronsNumeber)), outputNumber(outputNeuronsNumber) {}
 
         int getInputNumber() const noexcept {
             return inputNumber;
@@ -167,24 +339,139 @@ namespace CognitiveSystems {
         int outputNumber;
     };
 
-    class NeuralNetwork {
+    /*!
+    * Signals of every layer for one pass through a network. It is owned by the caller,
+    * so one network can serve many threads at once, each with its own workspace.
+    */
+    class Workspace {
+    public:
+        const std::vector<float>& getSignals(size_t layer) const {
+            if (layer >= signals.size())
+                throw std::runtime_error("workspace has no signals for the layer");
+            return signals[layer];
+        }
+
+    private:
+        template<Activations::Activation>
+        friend class BasicNeuralNetwork;
+
+        std::vector<std::vector<float>> signals;
+    };
+
+    /*!
+    * Buffers of the batched forward and backward passes. Reusing one workspace for batches of the
+    * same size makes computeGradients allocation free, which matters when many threads train at once.
+    */
+    class BatchWorkspace {
+    private:
+        template<Activations::Activation>
+        friend class BasicNeuralNetwork;
+
+        std::vector<::NeuralNetwork::Matrix<float>> activations;
+        ::NeuralNetwork::Matrix<float> deltas;
+        ::NeuralNetwork::Matrix<float> previousDeltas;
+    };
+
+    /*!
+    * Sums of weight gradients over a number of samples: one matrix per layer (rows are neurons,
+    * columns are their inputs) and the sum of squared errors of every output.
+    */
+    class Gradients {
     public:
+        void clear() noexcept {
+            for (auto& layer : layers) {
+                layer.fill(0.f);
+            }
+            std::fill(errors.begin(), errors.end(), 0.f);
+            samples = 0;
+        }
+
+        Gradients& operator+=(const Gradients& other) {
+            if (other.layers.size() != layers.size())
+                throw std::runtime_error("gradients of different networks cannot be added");
+            for (size_t l = 0; l < layers.size(); ++l) {
+                ::NeuralNetwork::Gemm::axpy(1.f, other.layers[l].getData(), layers[l].getData(), layers[l].size());
+            }
+            ::NeuralNetwork::Expressions::assign(errors, errors + other.errors);
+            samples += other.samples;
+            return *this;
+        }
+
+        const std::vector<float>& getErrors() const noexcept {
+            return errors;
+        }
+
+        size_t getSamplesNumber() const noexcept {
+            return samples;
+        }
+
+    private:
+        template<Activations::Activation>
+        friend class BasicNeuralNetwork;
+
+        std::vector<::NeuralNetwork::Matrix<float>> layers;
+        std::vector<float> errors;
+        size_t samples = 0;
+    };
+
+    struct ParallelTrainingOptions {
+        /*! Threads used for training, including the calling one. */
+        size_t threadsNumber = std::thread::hardware_concurrency();
+        /*! Samples whose gradients are applied together. */
+        size_t batchSize = 256;
+        /*! Samples processed by one task; also the granularity of the deterministic reduction. */
+        size_t shardSize = 32;
+        /*! Lock-free mode: threads apply their updates to the shared weights without synchronisation. */
+        bool hogwild = false;
+        /*!
+        * Samples read from a sample file at once. Batches do not cross chunks, so when this is a multiple
+        * of batchSize, training from a file gives the same weights as training on the same samples in memory.
+        */
+        size_t streamingChunkSize = 65536;
+        /*!
+        * Optimizer applying the gradients of every mini-batch instead of plain SGD with the learning rate passed to learn.
+        * It keeps state between batches, so it cannot be combined with hogwild.
+        */
+        ::NeuralNetwork::Optimizers::IOptimizer* optimizer = nullptr;
+        /*!
+        * Called after every epoch with its number, counted from 1, and the mean squared error of every output over it;
+        * returning false ends training there. The thread pool and shard buffers of learn are kept for all epochs,
+        * so a long run with checks between epochs (see BasicTrainer) should be one learn call with this callback.
+        */
+        std::function<bool(size_t epoch, const std::vector<float>& errors)> onEpoch;
+    };
+
+    struct TrainingStatistics {
+        /*! Mean squared error of every output over the last epoch. */
+        std::vector<float> errors;
+        size_t samples = 0;
+        double seconds = 0;
+        double samplesPerSecond = 0;
+    };
+
+    /*! Fully connected network; ActivationFunction is applied by every layer except the input one. */
+    template<Activations::Activation ActivationFunction>
+    class BasicNeuralNetwork {
+    public:
+        using Activation = ActivationFunction;
+        using Layer = BasicLayer<ActivationFunction>;
         using DataSet = std::vector<
                             std::tuple<
                                 std::vector<float>,
                                 std::vector<float>
                             >
                         >;
-    
+        using Batch = ::NeuralNetwork::Matrix<float>;
+
     public:
-        NeuralNetwork(const Topology& topology)
+        BasicNeuralNetwork(const Topology& topology)
             : topology(topology) {
             createInputLayer();
             createHiddenLayers();
             createOutputLayer();
         }
 
-        NeuralNetwork(Topology&& topology)
+        BasicNeuralNetwork(Topology&& topology)
             : topology(std::move(topology)) {
             createInputLayer();
             createHiddenLayers();
@@ -199,64 +486,367 @@ namespace CognitiveSystems {
             return layers;
         }
 
+        std::vector<Layer>& getModifiableLayers() noexcept {
+            return layers;
+        }
+
+        /*! Saves weights, neuron types and the activation of every layer to a binary model file, see ModelFile.hpp. */
+        void save(const std::filesystem::path& path) const {
+            std::vector<::NeuralNetwork::ModelFile::LayerBlob> blobs;
+            blobs.reserve(layers.size());
+            for (const auto& layer : layers) {
+                blobs.push_back({ layer.getWeights().view(), static_cast<std::uint32_t>(layer.getNeuronType()), ActivationFunction::IDENTIFIER });
+            }
+            ::NeuralNetwork::ModelFile::write(path, ::NeuralNetwork::ModelFile::ModelKind::CognitiveLayers, blobs);
+        }
+
+        /*!
+        * Maps a model file saved by `save`. Weights are used in place, without parsing or copying,
+        * so thousands of networks can be started from one file in milliseconds. Training the loaded
+        * network copies only the pages it changes and never modifies the file. The checksum, which reads
+        * the whole file, is verified only with `verifyChecksum`, e.g. once before starting the copies.
+        */
+        static BasicNeuralNetwork load(const std::filesystem::path& path, bool verifyChecksum = false) {
+            const ::NeuralNetwork::ModelFile::MappedModel model(path, ::NeuralNetwork::ModelFile::ModelKind::CognitiveLayers, verifyChecksum);
+            if (model.getLayersNumber() < 2)
+                throw std::runtime_error("model file has to contain input and output layers");
+
+            std::vector<Layer> layers;
+            layers.reserve(model.getLayersNumber());
+            std::vector<int> hiddenLayers;
+            for (size_t l = 0; l < model.getLayersNumber(); ++l) {
+                const auto type = static_cast<NeuronType>(model.getLayerType(l));
+                const auto expectedType = l == 0 ? NeuronType::Input : l + 1 == model.getLayersNumber() ? NeuronType::Output : NeuronType::Normal;
+                auto weights = model.getWeights(l);
+                const size_t expectedInputs = l == 0 ? 1 : layers.back().getSize();
+                if (type != expectedType || weights.cols() != expectedInputs)
+                    throw std::runtime_error("model file has layers that do not form a network");
+                if (model.getLayerActivation(l) != ActivationFunction::IDENTIFIER)
+                    throw std::runtime_error("model file was saved from a network with a different activation function");
+                if (expectedType == NeuronType::Normal)
+                    hiddenLayers.push_back(static_cast<int>(weights.rows()));
+                layers.emplace_back(std::move(weights), type);
+            }
+
+            Topology loadedTopology(layers.front().getSize(), std::move(hiddenLayers), layers.back().getSize());
+            return BasicNeuralNetwork(std::move(loadedTopology), std::move(layers));
+        }
+
+        /*! Runs signals through the network, remembering inputs and outputs of every layer for backPropagation. */
         std::vector<float> feedForward(const std::vector<float>& inputSignals) {
-            auto& inputLayer = layers.front();
-            if (inputSignals.size() != inputLayer.getSize())
+            std::span<const float> previousLayerSignals = inputSignals;
+            for (size_t l = 0; l < layers.size(); ++l) {
+                NEURAL_NETWORK_PROFILE("CognitiveNetwork", l, Forward, 2 * layers[l].getWeights().size(), getLayerBytes(layers[l], 1));
+                previousLayerSignals = layers[l].feedForward(previousLayerSignals);
+            }
+            return { previousLayerSignals.begin(), previousLayerSignals.end() };
+        }
+
+        /*!
+        * Runs signals through the network using only the caller's workspace. The network is not modified,
+        * so concurrent calls are safe as long as every thread passes its own workspace.
+        * Returns the outputs, which stay valid until the next call with the same workspace.
+        */
+        const std::vector<float>& feedForward(const std::vector<float>& inputSignals, Workspace& workspace) const {
+            workspace.signals.resize(layers.size());
+            std::span<const float> previousLayerSignals = inputSignals;
+            for (size_t l = 0; l < layers.size(); ++l) {
+                NEURAL_NETWORK_PROFILE("CognitiveNetwork", l, Forward, 2 * layers[l].getWeights().size(), getLayerBytes(layers[l], 1));
+                auto& layerSignals = workspace.signals[l];
+                layerSignals.resize(layers[l].getSize());
+                layers[l].activate(previousLayerSignals, layerSignals);
+                previousLayerSignals = layerSignals;
+            }
+            return workspace.signals.back();
+        }
+
+        std::vector<float> backPropagation(const std::vector<float>& expected, const std::vector<float>& inputs, const float learningRate) {
+            std::vector<float> diffs = trainStep(expected, inputs, learningRate);
+            std::transform(diffs.begin(), diffs.end(), diffs.begin(), [](float flt) {return flt * flt; });
+            return diffs;
+        }
+
+        /*!
+        * One training step on a single sample, the same as backPropagation. Every buffer it needs lives in
+        * the layers and the network, so after the first call it does no heap allocations.
+        * Returns differences between actual and expected outputs, valid until the next call.
+        */
+        const std::vector<float>& trainStep(const std::vector<float>& expected, const std::vector<float>& inputs, const float learningRate) {
+            std::span<const float> actuals = inputs;
+            for (size_t l = 0; l < layers.size(); ++l) {
+                NEURAL_NETWORK_PROFILE("CognitiveNetwork", l, Forward, 2 * layers[l].getWeights().size(), getLayerBytes(layers[l], 1));
+                actuals = layers[l].feedForward(actuals);
+            }
+
+            auto& lastLayer = layers.back();
+            if (static_cast<size_t>(lastLayer.getSize()) != expected.size())
+                throw std::runtime_error("differences and neuron counts mismatch!");
+
+            stepDiffs.resize(expected.size());
+            ::NeuralNetwork::Expressions::assign(stepDiffs, actuals - expected);
+            {
+                NEURAL_NETWORK_PROFILE("CognitiveNetwork", layers.size() - 1, Update, 3 * lastLayer.getWeights().size(), getLayerBytes(lastLayer, 1) + sizeof(float) * lastLayer.getWeights().size());
+                lastLayer.learn(stepDiffs, learningRate);
+            }
+
+            for (size_t l = layers.size() - 2; l > 0; --l) {
+                const auto& nextLayer = layers[l + 1];
+                const auto& nextWeights = nextLayer.getWeights();
+                {
+                    NEURAL_NETWORK_PROFILE("CognitiveNetwork", l, Backward, 2 * nextWeights.size(), getLayerBytes(nextLayer, 1));
+                    stepErrors.assign(layers[l].getSize(), 0.f);
+                    for (int k = 0; k < nextLayer.getSize(); ++k) {
+                        ::NeuralNetwork::Gemm::axpy(nextLayer.getDeltas()[k], nextWeights.row(k).data(), stepErrors.data(), stepErrors.size());
+                    }
+                }
+                NEURAL_NETWORK_PROFILE("CognitiveNetwork", l, Update, 3 * layers[l].getWeights().size(), getLayerBytes(layers[l], 1) + sizeof(float) * layers[l].getWeights().size());
+                layers[l].learn(stepErrors, learningRate);
+            }
+            return stepDiffs;
+        }
+
+        /*!
+        * Mean squared error of every output over the dataset, without changing the network.
+        * Samples are run through in batches of `batchSize` straight from the dataset's buffers.
+        */
+        std::vector<float> evaluate(const ::NeuralNetwork::FlatDataSet& dataset, size_t batchSize = 256) const {
+            std::vector<float> errors(layers.back().getSize(), 0.f);
+            if (dataset.empty())
+                return errors;
+            if (dataset.getExpectedNumber() != errors.size())
+                throw std::runtime_error("differences and neuron counts mismatch!");
+
+            std::vector<Batch> activations;
+            for (size_t begin = 0; begin < dataset.size(); begin += batchSize) {
+                const size_t end = std::min(begin + batchSize, dataset.size());
+                feedForwardBatch(dataset.getInputs(begin, end), activations);
+                const auto& actuals = activations.back();
+                const auto expected = dataset.getExpected(begin, end);
+                for (size_t n = 0; n < actuals.rows(); ++n) {
+                    for (size_t k = 0; k < actuals.cols(); ++k) {
+                        const float diff = actuals(n, k) - expected(n, k);
+                        errors[k] += diff * diff;
+                    }
+                }
+            }
+            for (auto& error : errors) {
+                error /= dataset.size();
+            }
+            return errors;
+        }
+
+        /*! Runs a batch of samples (one per row) through the network and returns one row of outputs per sample. */
+        Batch feedForward(const Batch& batch) const {
+            std::vector<Batch> activations;
+            feedForwardBatch(batch.view(), activations);
+            return std::move(activations.back());
+        }
+
+        /*!
+        * Runs a batch of samples (one per row) through the network using only the caller's workspace,
+        * so concurrent calls are safe and repeated calls with batches of the same size do not allocate.
+        * Returns one row of outputs per sample, valid until the next call with the same workspace.
+        */
+        const Batch& feedForward(::NeuralNetwork::MatrixView<const float> batch, BatchWorkspace& workspace) const {
+            feedForwardBatch(batch, workspace.activations);
+            return workspace.activations.back();
+        }
+
+        /*!
+        * Runs row n of `batch` through networks[n], which all need the same layer sizes, e.g. the brains of a population.
+        * Samples of all networks go through a layer together; adjacent rows of the same network are one block,
+        * so its weights are loaded once for all of them. Like feedForward, it only uses the caller's workspace.
+        */
+        static const Batch& feedForwardEach(std::span<const BasicNeuralNetwork* const> networks,
+                                            ::NeuralNetwork::MatrixView<const float> batch, BatchWorkspace& workspace) {
+            if (networks.empty() || networks.size() != batch.rows())
+                throw std::runtime_error("every sample needs a network");
+            const auto& first = *networks.front();
+            for (const auto* network : networks) {
+                if (!haveSameLayerSizes(*network, first))
+                    throw std::runtime_error("networks of a batch have different topologies");
+            }
+            if (batch.cols() != static_cast<size_t>(first.layers.front().getSize()))
                 throw std::runtime_error("input signals number is not equal to the input layer neurons number");
 
-            std::vector<float> previousLayerSignals(inputLayer.getSize(), 0.f);
+            auto& activations = workspace.activations;
+            activations.resize(first.layers.size());
+            activations[0].resize(batch.rows(), batch.cols());
+            for (size_t n = 0; n < batch.rows(); ++n) {
+                networks[n]->layers.front().activate(batch.row(n), activations[0].row(n));
+            }
+
+            for (size_t l = 1; l < first.layers.size(); ++l) {
+                const auto& layerInputs = activations[l - 1];
+                auto& layerOutputs = activations[l];
+                layerOutputs.resize(batch.rows(), first.layers[l].getSize(), 0.f);
+                for (size_t begin = 0, end = 0; begin < batch.rows(); begin = end) {
+                    while (end < batch.rows() && networks[end] == networks[begin]) {
+                        ++end;
+                    }
+                    ::NeuralNetwork::Gemm::multiplyTransposed(
+                        { layerInputs.getData() + begin * layerInputs.cols(), end - begin, layerInputs.cols() },
+                        networks[begin]->layers[l].getWeights().view(),
+                        { layerOutputs.getData() + begin * layerOutputs.cols(), end - begin, layerOutputs.cols() });
+                }
+                ActivationFunction::activate(layerOutputs.getData(), layerOutputs.size());
+            }
+            return activations.back();
+        }
+
+        /*! Whether the networks have layers of the same sizes, so their samples can share a feedForwardEach batch. */
+        static bool haveSameLayerSizes(const BasicNeuralNetwork& a, const BasicNeuralNetwork& b) noexcept {
+            return std::equal(a.layers.begin(), a.layers.end(), b.layers.begin(), b.layers.end(), [](const Layer& left, const Layer& right) {
+                return left.getSize() == right.getSize();
+            });
+        }
 
-            //TODO... Throw to a separate functoins
+        /*!
+        * Trains the network on a mini-batch: `inputs` and `expected` hold one sample per row.
+        * Forward and backward passes are done with matrix-matrix products, gradients are
+        * averaged over the batch and applied once. Returns the mean squared error of every output.
+        */
+        std::vector<float> trainBatch(const Batch& inputs, const Batch& expected, const float learningRate) {
+            ::NeuralNetwork::Optimizers::SGD optimizer(learningRate);
+            return trainBatch(inputs, expected, optimizer);
+        }
 
-            std::transform(inputLayer.begin(), inputLayer.end(),
-                           inputSignals.begin(), previousLayerSignals.begin(),
-                           [](Neuron& neuron, float signal) {
-                                return neuron.feedForward({ signal });
-                           });
+        /*! trainBatch that lets `optimizer` turn the averaged gradients into weight updates, one step per batch. */
+        std::vector<float> trainBatch(const Batch& inputs, const Batch& expected, ::NeuralNetwork::Optimizers::IOptimizer& optimizer) {
+            Gradients gradients = createGradients();
+            computeGradients(inputs, expected, gradients);
+            applyGradients(gradients, optimizer);
 
-            for (auto layerIter = layers.begin() + 1; layerIter != layers.end(); ++layerIter) {
-                auto& layer = *layerIter;
-                std::vector<float> currentLayerSignals(layer.getSize(), 0.f);
-                std::transform(layer.begin(), layer.end(),
-                               currentLayerSignals.begin(),
-                               [&previousLayerSignals](Neuron& neuron) {
-                                    return neuron.feedForward(previousLayerSignals);
-                               });
+            auto errors = gradients.getErrors();
+            for (auto& error : errors) {
+                error /= inputs.rows();
+            }
+            return errors;
+        }
 
-                previousLayerSignals = std::move(currentLayerSignals);
+        /*! Creates zeroed gradient buffers shaped for this network. */
+        Gradients createGradients() const {
+            Gradients gradients;
+            gradients.layers.resize(layers.size());
+            for (size_t l = 1; l < layers.size(); ++l) {
+                gradients.layers[l].resize(layers[l].getSize(), layers[l - 1].getSize(), 0.f);
             }
-            
-            return previousLayerSignals;
+            gradients.errors.assign(layers.back().getSize(), 0.f);
+            return gradients;
+        }
+
+        /*!
+        * Adds gradients of the batch to `gradients` without changing the network,
+        * so several threads can compute gradients of different samples at once.
+        */
+        void computeGradients(const Batch& inputs, const Batch& expected, Gradients& gradients) const {
+            BatchWorkspace workspace;
+            computeGradients(inputs, expected, gradients, workspace);
         }
 
-        std::vector<float> backPropagation(const std::vector<float>& expected, const std::vector<float>& inputs, const float learningRate) noexcept {
-            std::vector<float> actuals = feedForward(inputs);
-            std::vector<float> diffs(expected.size(), 0.f);
-            
-            std::transform(actuals.begin(), actuals.end(), expected.begin(), diffs.begin(), [](const auto& t1, const auto& t2) { return t1 - t2; });
-            auto& lastLayerNeurons = layers.back().getModifiableNeurons();
+        /*! computeGradients that takes its buffers from `workspace`. */
+        void computeGradients(const Batch& inputs, const Batch& expected, Gradients& gradients, BatchWorkspace& workspace) const {
+            computeGradients(inputs.view(), expected.view(), gradients, workspace);
+        }
 
-            if (lastLayerNeurons.size() != diffs.size())
+        /*! computeGradients over samples that live elsewhere, e.g. a range of a FlatDataSet. */
+        void computeGradients(::NeuralNetwork::MatrixView<const float> inputs, ::NeuralNetwork::MatrixView<const float> expected,
+                              Gradients& gradients, BatchWorkspace& workspace) const {
+            if (inputs.rows() != expected.rows())
+                throw std::runtime_error("inputs and expected values have different number of samples");
+
+            auto& activations = workspace.activations;
+            feedForwardBatch(inputs, activations);
+            const auto& actuals = activations.back();
+            if (expected.cols() != actuals.cols())
                 throw std::runtime_error("differences and neuron counts mismatch!");
 
-            for (int i = 0; i < diffs.size(); i++) {
-                lastLayerNeurons[i].learn(diffs[i], 0.01);
-            }
-            
-            for (auto layer = layers.rbegin() + 1; layer != layers.rend(); ++layer){
-                auto previousLayer = layer - 1;
-                for (int i = 0; i < layer->getSize(); ++i) {
-                    auto& neuron = layer->getNeuron(i);
-                    for (int j = 0; j < previousLayer->getSize(); ++j){
-                        auto& previousNeuron = previousLayer->getNeuron(j);
-                        auto error = previousNeuron.getWeight(i) * previousNeuron.getDelta();
-                        neuron.learn(error, learningRate);
+            const size_t batchSize = inputs.rows();
+            auto& deltas = workspace.deltas;
+            auto& previousDeltas = workspace.previousDeltas;
+            deltas.resize(batchSize, actuals.cols());
+            for (size_t n = 0; n < batchSize; ++n) {
+                for (size_t k = 0; k < actuals.cols(); ++k) {
+                    const float diff = actuals(n, k) - expected(n, k);
+                    gradients.errors[k] += diff * diff;
+                    deltas(n, k) = diff * ActivationFunction::derivative(actuals(n, k));
+                }
+            }
+
+            for (size_t l = layers.size() - 1; l > 0; --l) {
+                const auto& weights = layers[l].getWeights();
+                const auto& layerInputs = activations[l - 1];
+                NEURAL_NETWORK_PROFILE("CognitiveNetwork", l, Backward, (l > 1 ? 4 : 2) * batchSize * weights.size(),
+                                       getLayerBytes(layers[l], batchSize) + sizeof(float) * weights.size());
+
+                ::NeuralNetwork::Gemm::transposedMultiply(deltas.view(), layerInputs.view(), gradients.layers[l].view());
+
+                if (l > 1) {
+                    previousDeltas.resize(batchSize, layerInputs.cols(), 0.f);
+                    ::NeuralNetwork::Gemm::multiply(deltas.view(), weights.view(), previousDeltas.view());
+                    for (size_t n = 0; n < batchSize; ++n) {
+                        for (size_t j = 0; j < layerInputs.cols(); ++j) {
+                            previousDeltas(n, j) *= ActivationFunction::derivative(layerInputs(n, j));
+                        }
                     }
+                    std::swap(deltas, previousDeltas);
                 }
             }
+            gradients.samples += batchSize;
+        }
 
-            std::for_each(diffs.begin(), diffs.end(), [](float flt) {return flt * flt; });
-            return diffs;
+        /*! Moves weights against the gradients averaged over the samples they were computed from. */
+        void applyGradients(const Gradients& gradients, const float learningRate) {
+            ::NeuralNetwork::Optimizers::SGD optimizer(learningRate);
+            applyGradients(gradients, optimizer);
+        }
+
+        /*! Makes one `optimizer` step with the gradients of every layer. */
+        void applyGradients(const Gradients& gradients, ::NeuralNetwork::Optimizers::IOptimizer& optimizer) {
+            if (gradients.samples == 0)
+                return;
+            optimizer.beginStep();
+            for (size_t l = 1; l < layers.size(); ++l) {
+                auto& weights = layers[l].getModifiableWeights();
+                const auto& layerGradients = gradients.layers[l];
+                NEURAL_NETWORK_PROFILE("CognitiveNetwork", l, Update, 2 * weights.size(), 3 * sizeof(float) * weights.size());
+                optimizer.update(l, { weights.getData(), weights.size() }, { layerGradients.getData(), layerGradients.size() }, gradients.samples);
+            }
+        }
+
+        /*!
+        * Data-parallel training. In the default mode every mini-batch is split into shards of
+        * `options.shardSize` samples, shards are spread over the thread pool, and their gradients are
+        * summed in shard order before being applied once. The shard layout does not depend on the
+        * number of threads, so the trained weights are bit-identical for any `threadsNumber`.
+        *
+        * With `options.hogwild` every thread trains on its own slice of the dataset and applies
+        * its updates to the shared weights straight away, without any synchronisation. Updates of
+        * different threads may overwrite each other; the result depends on scheduling.
+        */
+        TrainingStatistics learn(const DataSet& dataset, const size_t epoch, const float learningRate, const ParallelTrainingOptions& options) {
+            return train(epoch, learningRate, options, [&](auto&& trainOn) { trainOn(dataset); });
+        }
+
+        /*! Parallel learn over a columnar dataset: shards are views into its buffers, nothing is copied. */
+        TrainingStatistics learn(const ::NeuralNetwork::FlatDataSet& dataset, const size_t epoch, const float learningRate, const ParallelTrainingOptions& options) {
+            return train(epoch, learningRate, options, [&](auto&& trainOn) { trainOn(dataset); });
+        }
+
+        /*!
+        * Parallel learn streaming samples from a file, `options.streamingChunkSize` samples at a time,
+        * so the dataset does not have to fit in memory. Every epoch reads the file once, front to back.
+        */
+        TrainingStatistics learn(::NeuralNetwork::SampleFile::Reader& reader, const size_t epoch, const float learningRate, const ParallelTrainingOptions& options) {
+            if (options.streamingChunkSize == 0)
+                throw std::runtime_error("streaming chunk size must be positive");
+            ::NeuralNetwork::FlatDataSet chunk(reader.getInputsNumber(), reader.getExpectedNumber());
+            return train(epoch, learningRate, options, [&](auto&& trainOn) {
+                reader.rewind();
+                while (reader.read(chunk, options.streamingChunkSize)) {
+                    trainOn(chunk);
+                }
+            });
         }
 
         std::vector<float> learn(DataSet& dataset, const size_t epoch, const float learningRate) {
@@ -273,11 +863,166 @@ namespace CognitiveSystems {
                 }
             }
 
-            std::for_each(errors.begin(), errors.end(), [epoch](float flt) {return flt / epoch; });
+            std::transform(errors.begin(), errors.end(), errors.begin(), [epoch](float flt) {return flt / epoch; });
             return errors;
         }
 
     private:
+        BasicNeuralNetwork(Topology&& topology, std::vector<Layer>&& layers)
+            : topology(std::move(topology)), layers(std::move(layers)) {}
+
+        /*! Buffers of one shard of a mini-batch in data-parallel training. */
+        struct Shard {
+            Batch inputs;
+            Batch expected;
+            Gradients gradients;
+            BatchWorkspace workspace;
+            std::vector<float> errors;
+        };
+
+        /*! Copies samples [begin, end) of the dataset into the shard's matrices and returns views of them. */
+        static std::pair<::NeuralNetwork::MatrixView<const float>, ::NeuralNetwork::MatrixView<const float>>
+            getSamples(const DataSet& dataset, size_t begin, size_t end, Shard& shard) {
+            const auto& [firstInputs, firstExpected] = dataset[begin];
+            shard.inputs.resize(end - begin, firstInputs.size());
+            shard.expected.resize(end - begin, firstExpected.size());
+            for (size_t n = begin; n < end; ++n) {
+                const auto& [sampleInputs, sampleExpected] = dataset[n];
+                if (sampleInputs.size() != shard.inputs.cols() || sampleExpected.size() != shard.expected.cols())
+                    throw std::runtime_error("samples of the dataset have different sizes");
+                std::copy(sampleInputs.begin(), sampleInputs.end(), shard.inputs.row(n - begin).begin());
+                std::copy(sampleExpected.begin(), sampleExpected.end(), shard.expected.row(n - begin).begin());
+            }
+            return { shard.inputs.view(), shard.expected.view() };
+        }
+
+        static std::pair<::NeuralNetwork::MatrixView<const float>, ::NeuralNetwork::MatrixView<const float>>
+            getSamples(const ::NeuralNetwork::FlatDataSet& dataset, size_t begin, size_t end, Shard&) {
+            return { dataset.getInputs(begin, end), dataset.getExpected(begin, end) };
+        }
+
+        /*!
+        * Common part of the parallel learn overloads. `forEachPart` is called once per epoch with a function
+        * that trains on a dataset; it passes the whole epoch to that function, at once or in parts.
+        */
+        template<class EpochParts>
+        TrainingStatistics train(const size_t epoch, const float learningRate, const ParallelTrainingOptions& options, EpochParts&& forEachPart) {
+            if (options.batchSize == 0 || options.shardSize == 0)
+                throw std::runtime_error("batch and shard sizes must be positive");
+            if (options.hogwild && options.optimizer != nullptr)
+                throw std::runtime_error("optimizers with state cannot be shared by hogwild threads");
+
+            ::NeuralNetwork::Optimizers::SGD sgd(learningRate);
+            auto& optimizer = options.optimizer != nullptr ? *options.optimizer : sgd;
+            TrainingStatistics statistics;
+            statistics.errors.assign(layers.back().getSize(), 0.f);
+
+            Utils::ThreadPool pool(options.threadsNumber);
+            const size_t shardsPerBatch = (options.batchSize + options.shardSize - 1) / options.shardSize;
+            std::vector<Shard> shards(std::max(shardsPerBatch, pool.getThreadsNumber()));
+            for (auto& shard : shards) {
+                shard.gradients = createGradients();
+            }
+            Gradients total = createGradients();
+
+            size_t epochSamples = 0;
+            const auto start = std::chrono::steady_clock::now();
+            for (size_t e = 0; e < epoch; ++e) {
+                std::fill(statistics.errors.begin(), statistics.errors.end(), 0.f);
+                epochSamples = 0;
+                forEachPart([&](const auto& dataset) {
+                    trainOn(dataset, optimizer, options, pool, shards, total, statistics.errors);
+                    epochSamples += dataset.size();
+                });
+                statistics.samples += epochSamples;
+                for (auto& error : statistics.errors) {
+                    error = epochSamples > 0 ? error / epochSamples : 0.f;
+                }
+                if (options.onEpoch && !options.onEpoch(e + 1, statistics.errors))
+                    break;
+            }
+
+            statistics.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            statistics.samplesPerSecond = statistics.seconds > 0 ? statistics.samples / statistics.seconds : 0;
+            return statistics;
+        }
+
+        /*! One pass over `dataset`, adding squared errors of every output to `errors`. */
+        template<class Samples>
+        void trainOn(const Samples& dataset, ::NeuralNetwork::Optimizers::IOptimizer& optimizer, const ParallelTrainingOptions& options,
+                     Utils::ThreadPool& pool, std::vector<Shard>& shards, Gradients& total, std::vector<float>& errors) {
+            if (dataset.empty())
+                return;
+
+            if (options.hogwild) {
+                const size_t threads = pool.getThreadsNumber();
+                pool.run(threads, [&](size_t t) {
+                    auto& shard = shards[t];
+                    shard.errors.assign(errors.size(), 0.f);
+                    const size_t sliceEnd = dataset.size() * (t + 1) / threads;
+                    for (size_t begin = dataset.size() * t / threads; begin < sliceEnd; begin += options.shardSize) {
+                        const auto [inputs, expected] = getSamples(dataset, begin, std::min(begin + options.shardSize, sliceEnd), shard);
+                        shard.gradients.clear();
+                        computeGradients(inputs, expected, shard.gradients, shard.workspace);
+                        applyGradients(shard.gradients, optimizer);
+                        ::NeuralNetwork::Expressions::assign(shard.errors, shard.errors + shard.gradients.errors);
+                    }
+                });
+                for (size_t t = 0; t < threads; ++t) {
+                    ::NeuralNetwork::Expressions::assign(errors, errors + shards[t].errors);
+                }
+                return;
+            }
+
+            for (size_t batchBegin = 0; batchBegin < dataset.size(); batchBegin += options.batchSize) {
+                const size_t batchEnd = std::min(batchBegin + options.batchSize, dataset.size());
+                const size_t shardsNumber = (batchEnd - batchBegin + options.shardSize - 1) / options.shardSize;
+                pool.run(shardsNumber, [&](size_t s) {
+                    auto& shard = shards[s];
+                    const size_t begin = batchBegin + s * options.shardSize;
+                    const auto [inputs, expected] = getSamples(dataset, begin, std::min(begin + options.shardSize, batchEnd), shard);
+                    shard.gradients.clear();
+                    computeGradients(inputs, expected, shard.gradients, shard.workspace);
+                });
+
+                total.clear();
+                for (size_t s = 0; s < shardsNumber; ++s) {
+                    total += shards[s].gradients;
+                }
+                applyGradients(total, optimizer);
+                ::NeuralNetwork::Expressions::assign(errors, errors + total.errors);
+            }
+        }
+
+        /*! Fills `activations` with outputs of every layer for the batch. */
+        void feedForwardBatch(::NeuralNetwork::MatrixView<const float> batch, std::vector<Batch>& activations) const {
+            const auto& inputLayer = layers.front();
+            if (batch.cols() != static_cast<size_t>(inputLayer.getSize()))
+                throw std::runtime_error("input signals number is not equal to the input layer neurons number");
+
+            activations.resize(layers.size());
+            {
+                NEURAL_NETWORK_PROFILE("CognitiveNetwork", 0, Forward, batch.rows() * batch.cols(), getLayerBytes(inputLayer, batch.rows()));
+                activations[0].resize(batch.rows(), batch.cols());
+                for (size_t n = 0; n < batch.rows(); ++n) {
+                    inputLayer.activate(batch.row(n), activations[0].row(n));
+                }
+            }
+
+            for (size_t l = 1; l < layers.size(); ++l) {
+                NEURAL_NETWORK_PROFILE("CognitiveNetwork", l, Forward, 2 * batch.rows() * layers[l].getWeights().size(), getLayerBytes(layers[l], batch.rows()));
+                auto& layerOutputs = activations[l];
+                layerOutputs.resize(batch.rows(), layers[l].getSize(), 0.f);
+                ::NeuralNetwork::Gemm::multiplyTransposed(activations[l - 1].view(), layers[l].getWeights().view(), layerOutputs.view());
+                ActivationFunction::activate(layerOutputs.getData(), layerOutputs.size());
+            }
+        }
+
+        /*! Bytes of the layer's weights and of `samples` rows of its inputs and outputs, for profiling. */
+        static size_t getLayerBytes(const Layer& layer, size_t samples) noexcept {
+            return sizeof(float) * (layer.getWeights().size() + samples * (layer.getInputsNumber() + layer.getSize()));
+        }
+
         void createInputLayer() {
             layers.emplace_back(topology.getInputNumber(), 1, NeuronType::Input);
         }
@@ -299,8 +1044,13 @@ namespace CognitiveSystems {
     private:
         Topology topology;
         std::vector<Layer> layers;
+        /*! Buffers of trainStep, kept between calls so that training does not allocate. */
+        std::vector<float> stepDiffs;
+        std::vector<float> stepErrors;
     };
 
+    using NeuralNetwork = BasicNeuralNetwork<Activations::Sigmoid>;
+
     void foo() {
         std::vector<int> f{ 1, 2, 3, 4 };
         Topology top(1, f, 3);
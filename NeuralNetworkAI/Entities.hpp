@@ -0,0 +1,453 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "PositioningSystem.hpp"
+#include "Food.hpp"
+
+/*!
+* Data-oriented storage of the simulation world. Every kind of entity (worms, food, walls) has its own table,
+* and every component of a table (coordinates, health, energy, nutrition, ...) is a separate packed array,
+* so systems that update one component of all entities of a kind walk linear memory, and compilers can vectorize them.
+* Entities are values in these tables, never Object2D subclasses stored by value, so nothing is sliced, and behaviour
+* is selected by Kind instead of typeid and dynamic_cast.
+*
+* Rows are packed: destroying an entity moves the last row of its table into its place. Entity handles stay valid
+* because they point to a slot that knows the current row, and the generation of the slot tells dead handles apart
+* from the entity that reuses the slot.
+*/
+namespace Entities {
+	/*! Generational handle of an entity. A handle of a destroyed entity stays invalid, even when its slot is reused. */
+	struct Entity {
+		static constexpr std::uint32_t INVALID_INDEX = std::numeric_limits<std::uint32_t>::max();
+
+		std::uint32_t index = INVALID_INDEX;
+		std::uint32_t generation = 0;
+
+		friend bool operator==(const Entity&, const Entity&) noexcept = default;
+	};
+
+	enum class Kind : unsigned char {
+		Worm, Food, Wall
+	};
+
+	namespace Detail {
+		template<typename Column>
+		void swapRemove(Column& column, size_t row) {
+			column[row] = std::move(column.back());
+			column.pop_back();
+		}
+	}
+
+	/*! Characteristics of a new worm, the same ones as of Bodies::SimpleBody and DigestiveSystems::SimpleDigestiveSystem. */
+	struct WormTraits {
+		int health = 100;
+		int speed = 1;
+		int damage = 10;
+		int regenerationSpeed = 1;
+		int energy = 100;
+		/*! Which brain of the simulator decides for the worm, see Simulator::setBrains. */
+		std::uint32_t brain = 0;
+	};
+
+	struct WormTable {
+		std::vector<Entity> entities;
+		std::vector<int> x;
+		std::vector<int> y;
+		/*! Offset applied by the movement system every tick. */
+		std::vector<int> velocityX;
+		std::vector<int> velocityY;
+		std::vector<int> health;
+		std::vector<int> maxHealth;
+		std::vector<int> regenerationSpeed;
+		std::vector<int> speed;
+		std::vector<int> damage;
+		std::vector<int> energy;
+		std::vector<std::uint32_t> brain;
+
+		size_t size() const noexcept {
+			return entities.size();
+		}
+
+		Positioning::Coordinates getCoordinates(size_t row) const noexcept {
+			return { x[row], y[row] };
+		}
+
+	private:
+		friend class World;
+
+		void add(Entity entity, Positioning::Coordinates coords, const WormTraits& traits) {
+			entities.push_back(entity);
+			x.push_back(coords.x);
+			y.push_back(coords.y);
+			velocityX.push_back(0);
+			velocityY.push_back(0);
+			health.push_back(traits.health);
+			maxHealth.push_back(traits.health);
+			regenerationSpeed.push_back(traits.regenerationSpeed);
+			speed.push_back(traits.speed);
+			damage.push_back(traits.damage);
+			energy.push_back(traits.energy);
+			brain.push_back(traits.brain);
+		}
+
+		void remove(size_t row) {
+			Detail::swapRemove(entities, row);
+			Detail::swapRemove(x, row);
+			Detail::swapRemove(y, row);
+			Detail::swapRemove(velocityX, row);
+			Detail::swapRemove(velocityY, row);
+			Detail::swapRemove(health, row);
+			Detail::swapRemove(maxHealth, row);
+			Detail::swapRemove(regenerationSpeed, row);
+			Detail::swapRemove(speed, row);
+			Detail::swapRemove(damage, row);
+			Detail::swapRemove(energy, row);
+			Detail::swapRemove(brain, row);
+		}
+	};
+
+	struct FoodTable {
+		std::vector<Entity> entities;
+		std::vector<int> x;
+		std::vector<int> y;
+		std::vector<int> nutrition;
+		std::vector<Objects::Food::FoodType> foodType;
+
+		size_t size() const noexcept {
+			return entities.size();
+		}
+
+		Positioning::Coordinates getCoordinates(size_t row) const noexcept {
+			return { x[row], y[row] };
+		}
+
+	private:
+		friend class World;
+
+		void add(Entity entity, Positioning::Coordinates coords, int foodNutrition, Objects::Food::FoodType type) {
+			entities.push_back(entity);
+			x.push_back(coords.x);
+			y.push_back(coords.y);
+			nutrition.push_back(foodNutrition);
+			foodType.push_back(type);
+		}
+
+		void remove(size_t row) {
+			Detail::swapRemove(entities, row);
+			Detail::swapRemove(x, row);
+			Detail::swapRemove(y, row);
+			Detail::swapRemove(nutrition, row);
+			Detail::swapRemove(foodType, row);
+		}
+	};
+
+	struct WallTable {
+		std::vector<Entity> entities;
+		std::vector<int> x;
+		std::vector<int> y;
+
+		size_t size() const noexcept {
+			return entities.size();
+		}
+
+		Positioning::Coordinates getCoordinates(size_t row) const noexcept {
+			return { x[row], y[row] };
+		}
+
+	private:
+		friend class World;
+
+		void add(Entity entity, Positioning::Coordinates coords) {
+			entities.push_back(entity);
+			x.push_back(coords.x);
+			y.push_back(coords.y);
+		}
+
+		void remove(size_t row) {
+			Detail::swapRemove(entities, row);
+			Detail::swapRemove(x, row);
+			Detail::swapRemove(y, row);
+		}
+	};
+
+	/*!
+	* World owns the tables of all entities and the slots that map entity handles to rows.
+	* Systems get the tables and work on their columns directly; handles are for the code that keeps
+	* references to single entities across ticks (targets, owners, ...).
+	*/
+	class World {
+	public:
+		Entity createWorm(Positioning::Coordinates coords, const WormTraits& traits) {
+			if (traits.health <= 0) {
+				throw std::runtime_error("World: worm health can't be 0.");
+			}
+			if (traits.regenerationSpeed <= 0) {
+				throw std::runtime_error("World: regeneration speed cannot be 0");
+			}
+			const auto entity = allocate(Kind::Worm, worms.size());
+			worms.add(entity, coords, traits);
+			return entity;
+		}
+
+		Entity createFood(Positioning::Coordinates coords, int nutrition, Objects::Food::FoodType foodType = Objects::Food::FoodType::SoftFood) {
+			const auto entity = allocate(Kind::Food, food.size());
+			food.add(entity, coords, nutrition, foodType);
+			return entity;
+		}
+
+		Entity createWall(Positioning::Coordinates coords) {
+			const auto entity = allocate(Kind::Wall, walls.size());
+			walls.add(entity, coords);
+			return entity;
+		}
+
+		/*! Destroys the entity and moves the last row of its table into its row. Does nothing for dead handles. */
+		void destroy(Entity entity) {
+			if (!isAlive(entity)) {
+				return;
+			}
+			const size_t row = slots[entity.index].row;
+			switch (slots[entity.index].kind) {
+			case Kind::Worm:
+				moveLastRowTo(worms.entities, row);
+				worms.remove(row);
+				break;
+			case Kind::Food:
+				moveLastRowTo(food.entities, row);
+				food.remove(row);
+				break;
+			case Kind::Wall:
+				moveLastRowTo(walls.entities, row);
+				walls.remove(row);
+				break;
+			}
+			// Handles of the destroyed entity no longer match the slot.
+			++slots[entity.index].generation;
+			freeSlots.push_back(entity.index);
+			--entitiesNumber;
+		}
+
+		bool isAlive(Entity entity) const noexcept {
+			return entity.index < slots.size() && slots[entity.index].generation == entity.generation;
+		}
+
+		Kind getKind(Entity entity) const {
+			return getSlot(entity).kind;
+		}
+
+		/*! Row of the entity in the table of its kind. Rows change when other entities are destroyed, handles don't. */
+		size_t getRow(Entity entity) const {
+			return getSlot(entity).row;
+		}
+
+		Positioning::Coordinates getCoordinates(Entity entity) const {
+			const auto& slot = getSlot(entity);
+			switch (slot.kind) {
+			case Kind::Worm:
+				return worms.getCoordinates(slot.row);
+			case Kind::Food:
+				return food.getCoordinates(slot.row);
+			default:
+				return walls.getCoordinates(slot.row);
+			}
+		}
+
+		void setLocation(Entity entity, Positioning::Coordinates coords) {
+			const auto& slot = getSlot(entity);
+			switch (slot.kind) {
+			case Kind::Worm:
+				worms.x[slot.row] = coords.x;
+				worms.y[slot.row] = coords.y;
+				break;
+			case Kind::Food:
+				food.x[slot.row] = coords.x;
+				food.y[slot.row] = coords.y;
+				break;
+			case Kind::Wall:
+				walls.x[slot.row] = coords.x;
+				walls.y[slot.row] = coords.y;
+				break;
+			}
+		}
+
+		size_t size() const noexcept {
+			return entitiesNumber;
+		}
+
+		WormTable& getWorms() noexcept {
+			return worms;
+		}
+
+		const WormTable& getWorms() const noexcept {
+			return worms;
+		}
+
+		FoodTable& getFood() noexcept {
+			return food;
+		}
+
+		const FoodTable& getFood() const noexcept {
+			return food;
+		}
+
+		WallTable& getWalls() noexcept {
+			return walls;
+		}
+
+		const WallTable& getWalls() const noexcept {
+			return walls;
+		}
+
+	private:
+		struct Slot {
+			std::uint32_t generation = 0;
+			std::uint32_t row = 0;
+			Kind kind = Kind::Wall;
+		};
+
+		Entity allocate(Kind kind, size_t row) {
+			std::uint32_t index;
+			if (!freeSlots.empty()) {
+				index = freeSlots.back();
+				freeSlots.pop_back();
+			}
+			else {
+				if (slots.size() >= Entity::INVALID_INDEX) {
+					throw std::runtime_error("World: too many entities.");
+				}
+				index = static_cast<std::uint32_t>(slots.size());
+				slots.emplace_back();
+			}
+			auto& slot = slots[index];
+			slot.row = static_cast<std::uint32_t>(row);
+			slot.kind = kind;
+			++entitiesNumber;
+			return { index, slot.generation };
+		}
+
+		/*! Points the slot of the last row of a table to `row`, which is about to receive that row. */
+		void moveLastRowTo(const std::vector<Entity>& entities, size_t row) {
+			slots[entities.back().index].row = static_cast<std::uint32_t>(row);
+		}
+
+		const Slot& getSlot(Entity entity) const {
+			if (!isAlive(entity)) {
+				throw std::runtime_error("World: the entity was destroyed.");
+			}
+			return slots[entity.index];
+		}
+
+	private:
+		/*! Reads and replaces all columns of a world at once, for snapshots, see Snapshot.hpp. */
+		friend struct WorldColumns;
+
+		WormTable worms;
+		FoodTable food;
+		WallTable walls;
+		std::vector<Slot> slots;
+		std::vector<std::uint32_t> freeSlots;
+		size_t entitiesNumber = 0;
+	};
+
+
+	/*!
+	* Systems: each of them updates some components of all entities of a kind in one pass over their columns.
+	*/
+	namespace Systems {
+		/*! Energy that regeneration costs, the same as for Bodies::SimpleBody. */
+		constexpr int ENERGY_REQUIRED_FOR_REGENERATION = 14;
+
+		/*! Regenerates the health of every damaged worm at the expense of its energy, see Bodies::SimpleBody::regenerate. */
+		inline void regenerate(WormTable& worms) noexcept {
+			int* const health = worms.health.data();
+			int* const energy = worms.energy.data();
+			const int* const maxHealth = worms.maxHealth.data();
+			const int* const regenerationSpeed = worms.regenerationSpeed.data();
+			for (size_t i = 0; i < worms.size(); ++i) {
+				const bool regenerates = health[i] < maxHealth[i] && energy[i] >= ENERGY_REQUIRED_FOR_REGENERATION;
+				const int regenerated = std::min(health[i] + regenerationSpeed[i], maxHealth[i]);
+				health[i] = regenerates ? regenerated : health[i];
+				energy[i] -= regenerates ? ENERGY_REQUIRED_FOR_REGENERATION : 0;
+			}
+		}
+
+		/*! Regenerates the worm in `row`, if it's damaged and has enough energy. */
+		inline void regenerate(WormTable& worms, size_t row) noexcept {
+			if (worms.health[row] < worms.maxHealth[row] && worms.energy[row] >= ENERGY_REQUIRED_FOR_REGENERATION) {
+				worms.health[row] = std::min(worms.health[row] + worms.regenerationSpeed[row], worms.maxHealth[row]);
+				worms.energy[row] -= ENERGY_REQUIRED_FOR_REGENERATION;
+			}
+		}
+
+		/*! Moves every worm by its velocity. */
+		inline void move(WormTable& worms) noexcept {
+			int* const x = worms.x.data();
+			int* const y = worms.y.data();
+			const int* const velocityX = worms.velocityX.data();
+			const int* const velocityY = worms.velocityY.data();
+			for (size_t i = 0; i < worms.size(); ++i) {
+				x[i] += velocityX[i];
+				y[i] += velocityY[i];
+			}
+		}
+
+		/*! Sets the velocity of the worm in `row` so it goes towards `target` at its speed, without overshooting it. */
+		inline void steerTowards(WormTable& worms, size_t row, Positioning::Coordinates target) noexcept {
+			const auto offset = Positioning::Coordinates{ target.x - worms.x[row], target.y - worms.y[row] };
+			const double distance = std::sqrt(static_cast<double>(offset.getSquaredDistance({ 0, 0 })));
+			if (distance <= worms.speed[row]) {
+				worms.velocityX[row] = offset.x;
+				worms.velocityY[row] = offset.y;
+				return;
+			}
+			worms.velocityX[row] = static_cast<int>(std::lround(offset.x * worms.speed[row] / distance));
+			worms.velocityY[row] = static_cast<int>(std::lround(offset.y * worms.speed[row] / distance));
+		}
+
+		/*!
+		* What the worm does with an object it met, dispatched by the kind of the object:
+		* it eats food and regenerates, regenerates at walls and damages other worms.
+		*/
+		inline void interact(World& world, Entity worm, Entity object) {
+			auto& worms = world.getWorms();
+			const size_t row = world.getRow(worm);
+			switch (world.getKind(object)) {
+			case Kind::Food: {
+				auto& food = world.getFood();
+				const size_t foodRow = world.getRow(object);
+				worms.energy[row] += food.nutrition[foodRow];
+				world.destroy(object);
+				[[fallthrough]];
+			}
+			case Kind::Wall:
+				regenerate(worms, row);
+				break;
+			case Kind::Worm: {
+				const size_t targetRow = world.getRow(object);
+				worms.health[targetRow] = std::max(worms.health[targetRow] - worms.damage[row], 0);
+				break;
+			}
+			}
+		}
+
+		/*! Destroys the worms without health. Returns how many died. */
+		inline size_t removeDead(World& world) {
+			auto& worms = world.getWorms();
+			size_t dead = 0;
+			// Backwards, so the rows moved into the place of destroyed ones were already checked.
+			for (size_t i = worms.size(); i-- > 0;) {
+				if (worms.health[i] == 0) {
+					world.destroy(worms.entities[i]);
+					++dead;
+				}
+			}
+			return dead;
+		}
+	}
+}
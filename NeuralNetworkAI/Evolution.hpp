@@ -0,0 +1,380 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "CognitiveSystem.hpp"
+#include "Simulator.hpp"
+#include "ThreadPool.hpp"
+
+/*!
+* Neuroevolution of worm brains: a population of genomes (the weights of a brain, flattened) is evaluated
+* in headless worlds, and the next generation is bred from the fittest ones by selection, crossover and
+* mutation applied to the flat weight buffers directly.
+*/
+namespace Evolution {
+	using Brain = Entities::Simulator::Brain;
+
+	namespace Detail {
+		/*! SplitMix64: a tiny generator that can be seeded per child without the cost of seeding a Mersenne Twister. */
+		class Random {
+		public:
+			using result_type = std::uint64_t;
+
+			explicit Random(std::uint64_t seed) noexcept : state(seed) {}
+
+			static constexpr result_type min() noexcept {
+				return 0;
+			}
+
+			static constexpr result_type max() noexcept {
+				return std::numeric_limits<result_type>::max();
+			}
+
+			result_type operator()() noexcept {
+				std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+				z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+				z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+				return z ^ (z >> 31);
+			}
+
+			/*! Uniform in [0, 1). */
+			float uniform() noexcept {
+				return static_cast<float>((*this)() >> 40) * (1.f / 16777216.f);
+			}
+
+			size_t below(size_t bound) noexcept {
+				return static_cast<size_t>((*this)() % bound);
+			}
+
+		private:
+			std::uint64_t state;
+		};
+
+		/*! Seed of a stream that only depends on its inputs, so results don't depend on which thread used it. */
+		inline std::uint64_t mix(std::uint64_t seed, std::uint64_t a, std::uint64_t b) noexcept {
+			Random random(seed ^ (a * 0xD1B54A32D192ED03ull) ^ (b * 0x8CB92BA72F3D8DD7ull));
+			return random();
+		}
+	}
+
+	/*! Number of weights of a brain with the topology: all layers but the input one, which has no trainable weights. */
+	inline size_t getGenomeSize(const CognitiveSystems::Topology& topology) {
+		size_t size = 0;
+		int inputs = topology.getInputNumber();
+		for (const int neurons : topology.getHiddenLayers()) {
+			size += size_t(neurons) * inputs;
+			inputs = neurons;
+		}
+		return size + size_t(topology.getOutputNumber()) * inputs;
+	}
+
+	/*! Copies the genome into the weights of the brain, layer after layer, row after row. */
+	inline void loadGenome(std::span<const float> genome, Brain& brain) {
+		auto& layers = brain.getModifiableLayers();
+		for (size_t l = 1; l < layers.size(); ++l) {
+			auto& weights = layers[l].getModifiableWeights();
+			if (genome.size() < weights.size())
+				throw std::runtime_error("Evolution: genome is smaller than the brain.");
+			std::copy(genome.begin(), genome.begin() + weights.size(), weights.getData());
+			genome = genome.subspan(weights.size());
+		}
+		if (!genome.empty())
+			throw std::runtime_error("Evolution: genome is larger than the brain.");
+	}
+
+	inline void storeGenome(const Brain& brain, std::span<float> genome) {
+		const auto& layers = brain.getLayers();
+		for (size_t l = 1; l < layers.size(); ++l) {
+			const auto& weights = layers[l].getWeights();
+			if (genome.size() < weights.size())
+				throw std::runtime_error("Evolution: genome is smaller than the brain.");
+			std::copy(weights.getData(), weights.getData() + weights.size(), genome.begin());
+			genome = genome.subspan(weights.size());
+		}
+	}
+
+	/*!
+	* Arena of a population: genomes are the rows of one contiguous matrix, next to their fitness.
+	* Breeding writes the children into a second arena of the same shape and the two are swapped,
+	* so generations after the first one don't allocate.
+	*/
+	class Population {
+	public:
+		Population(size_t size, size_t genomeSize) : genomes(size, genomeSize), fitness(size, 0.f) {}
+
+		size_t size() const noexcept {
+			return genomes.rows();
+		}
+
+		size_t getGenomeSize() const noexcept {
+			return genomes.cols();
+		}
+
+		std::span<float> getGenome(size_t index) noexcept {
+			return genomes.row(index);
+		}
+
+		std::span<const float> getGenome(size_t index) const noexcept {
+			return genomes.row(index);
+		}
+
+		float getFitness(size_t index) const noexcept {
+			return fitness[index];
+		}
+
+		void setFitness(size_t index, float value) noexcept {
+			fitness[index] = value;
+		}
+
+		const std::vector<float>& getFitness() const noexcept {
+			return fitness;
+		}
+
+		void swap(Population& other) noexcept {
+			std::swap(genomes, other.genomes);
+			std::swap(fitness, other.fitness);
+		}
+
+	private:
+		::NeuralNetwork::Matrix<float> genomes;
+		std::vector<float> fitness;
+	};
+
+	struct EvolutionOptions {
+		size_t populationSize = 64;
+		/*! The fittest genomes, copied into the next generation unchanged. */
+		size_t elites = 2;
+		size_t tournamentSize = 3;
+		/*! Probability that a child mixes two parents; otherwise it is a copy of one before mutation. */
+		float crossoverRate = 0.7f;
+		/*! Probability that a weight of a child is mutated. */
+		float mutationRate = 0.05f;
+		/*! Standard deviation of the noise added to mutated weights; 0 disables mutation. */
+		float mutationStrength = 0.3f;
+		/*! Weights of the first generation are uniform in [-initialWeightRange, initialWeightRange]. */
+		float initialWeightRange = 1.f;
+		size_t threadsNumber = std::thread::hardware_concurrency();
+		std::uint64_t seed = 1;
+	};
+
+	/*! A headless world in which a brain is evaluated: worms with the brain among food, for some ticks. */
+	struct WorldOptions {
+		size_t worms = 16;
+		size_t food = 64;
+		int worldSize = 1000;
+		size_t ticks = 200;
+		Entities::WormTraits traits{ 100, 5, 10, 1, 50 };
+		Entities::TickOptions tick{ 250.0, 256 };
+	};
+
+	struct GenerationReport {
+		size_t generation = 0;
+		float bestFitness = 0;
+		float meanFitness = 0;
+		/*! Index of the best genome in the evaluated population; it is elite 0 of the next one. */
+		size_t bestGenome = 0;
+		double seconds = 0;
+	};
+
+	/*!
+	* Evolves brains of one topology. Every generation is evaluated in parallel, one genome per task, each on its own
+	* brain and in its own world, so evaluation keeps all threads busy without sharing anything but the read-only genomes.
+	* Children are bred in parallel as well, each from its own random stream seeded by the generation and its index,
+	* so the population after any number of generations is the same for any number of threads.
+	*/
+	class Engine {
+	public:
+		/*! Fitness of a brain, the higher the better. `seed` is the same for all genomes of a generation. Called concurrently. */
+		using FitnessFunction = std::function<float(const Brain& brain, std::uint64_t seed)>;
+
+		/*! Fitness is the number of food eaten by worms with the brain in a world generated from the seed. */
+		static FitnessFunction makeWorldFitness(WorldOptions options) {
+			return [options](const Brain& brain, std::uint64_t seed) {
+				Entities::World world;
+				Detail::Random random(seed);
+				const auto coordinate = [&] {
+					return static_cast<int>(random.below(size_t(options.worldSize) + 1));
+				};
+				for (size_t i = 0; i < options.worms; ++i) {
+					world.createWorm({ coordinate(), coordinate() }, options.traits);
+				}
+				for (size_t i = 0; i < options.food; ++i) {
+					world.createFood({ coordinate(), coordinate() }, 10);
+				}
+
+				Entities::Simulator simulator(1, options.tick);
+				simulator.setBrains({ &brain });
+				size_t eaten = 0;
+				for (size_t tick = 0; tick < options.ticks && world.getWorms().size() > 0; ++tick) {
+					eaten += simulator.tick(world).eaten;
+				}
+				return static_cast<float>(eaten);
+			};
+		}
+
+		Engine(CognitiveSystems::Topology topology, EvolutionOptions options, FitnessFunction fitness)
+			: options(options), fitnessFunction(std::move(fitness)), pool(options.threadsNumber),
+			  population(options.populationSize, getGenomeSize(topology)), offspring(options.populationSize, getGenomeSize(topology)) {
+			if (options.populationSize == 0 || options.elites > options.populationSize)
+				throw std::runtime_error("Evolution: population must have at least one genome and at least as many genomes as elites.");
+			if (!(options.mutationStrength >= 0.f))
+				throw std::runtime_error("Evolution: mutation strength must not be negative.");
+			if (options.tournamentSize == 0)
+				throw std::runtime_error("Evolution: tournament must have at least one genome.");
+
+			brains.reserve(pool.getThreadsNumber());
+			for (size_t t = 0; t < pool.getThreadsNumber(); ++t) {
+				brains.emplace_back(topology);
+				freeBrains.push_back(t);
+			}
+			ranking.resize(options.populationSize);
+
+			Detail::Random random(options.seed);
+			for (size_t g = 0; g < population.size(); ++g) {
+				for (auto& weight : population.getGenome(g)) {
+					weight = (2.f * random.uniform() - 1.f) * options.initialWeightRange;
+				}
+			}
+		}
+
+		/*! Evaluates the current generation and replaces it with its children. */
+		GenerationReport step() {
+			const auto start = std::chrono::steady_clock::now();
+			evaluate();
+			GenerationReport report;
+			report.generation = generation;
+			report.bestGenome = ranking.front();
+			report.bestFitness = population.getFitness(ranking.front());
+			report.meanFitness = std::accumulate(population.getFitness().begin(), population.getFitness().end(), 0.f) / population.size();
+			bestGenome.assign(population.getGenome(ranking.front()).begin(), population.getGenome(ranking.front()).end());
+			breed();
+			report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			return report;
+		}
+
+		/*! Computes the fitness of every genome of the current generation, in parallel, and ranks them. */
+		void evaluate() {
+			generationSeed = Detail::mix(options.seed, generation, 0);
+			pool.run(population.size(), [this](size_t g) {
+				const size_t b = acquireBrain();
+				try {
+					loadGenome(population.getGenome(g), brains[b]);
+					population.setFitness(g, fitnessFunction(brains[b], generationSeed));
+				}
+				catch (...) {
+					releaseBrain(b);
+					throw;
+				}
+				releaseBrain(b);
+			});
+
+			std::iota(ranking.begin(), ranking.end(), size_t(0));
+			std::stable_sort(ranking.begin(), ranking.end(), [this](size_t a, size_t b) {
+				return population.getFitness(a) > population.getFitness(b);
+			});
+		}
+
+		/*!
+		* Replaces the evaluated generation with the next one: elites are copied, every other child gets two parents
+		* chosen by tournaments, uniform crossover with probability crossoverRate and gaussian mutation. Doesn't allocate.
+		*/
+		void breed() {
+			pool.run(offspring.size(), [this](size_t child) {
+				auto genome = offspring.getGenome(child);
+				if (child < options.elites) {
+					const auto elite = population.getGenome(ranking[child]);
+					std::copy(elite.begin(), elite.end(), genome.begin());
+					return;
+				}
+
+				Detail::Random random(Detail::mix(options.seed, generation + 1, child + 1));
+				const auto first = population.getGenome(select(random));
+				const auto second = population.getGenome(select(random));
+				if (random.uniform() < options.crossoverRate) {
+					for (size_t w = 0; w < genome.size(); ++w) {
+						genome[w] = (random() & 1) ? first[w] : second[w];
+					}
+				}
+				else {
+					std::copy(first.begin(), first.end(), genome.begin());
+				}
+
+				if (options.mutationStrength == 0.f)
+					return;
+				std::normal_distribution<float> noise(0.f, options.mutationStrength);
+				for (auto& weight : genome) {
+					if (random.uniform() < options.mutationRate) {
+						weight += noise(random);
+					}
+				}
+			});
+			population.swap(offspring);
+			++generation;
+		}
+
+		const Population& getPopulation() const noexcept {
+			return population;
+		}
+
+		size_t getGeneration() const noexcept {
+			return generation;
+		}
+
+		/*! Puts the weights of the best genome of the last evaluated generation into the brain. */
+		void loadBest(Brain& brain) const {
+			if (bestGenome.empty())
+				throw std::runtime_error("Evolution: no generation was evaluated yet.");
+			loadGenome(bestGenome, brain);
+		}
+
+	private:
+		/*! Tournament selection: the fittest of tournamentSize random genomes. */
+		size_t select(Detail::Random& random) const noexcept {
+			size_t best = random.below(population.size());
+			for (size_t i = 1; i < options.tournamentSize; ++i) {
+				const size_t candidate = random.below(population.size());
+				if (population.getFitness(candidate) > population.getFitness(best)) {
+					best = candidate;
+				}
+			}
+			return best;
+		}
+
+		size_t acquireBrain() {
+			std::lock_guard lock(brainsMutex);
+			const size_t b = freeBrains.back();
+			freeBrains.pop_back();
+			return b;
+		}
+
+		void releaseBrain(size_t b) {
+			std::lock_guard lock(brainsMutex);
+			freeBrains.push_back(b);
+		}
+
+	private:
+		EvolutionOptions options;
+		FitnessFunction fitnessFunction;
+		Utils::ThreadPool pool;
+		Population population;
+		Population offspring;
+		/*! One brain per thread: genomes are loaded into them to be evaluated. */
+		std::vector<Brain> brains;
+		std::vector<size_t> freeBrains;
+		std::mutex brainsMutex;
+		std::vector<size_t> ranking;
+		std::vector<float> bestGenome;
+		size_t generation = 0;
+		std::uint64_t generationSeed = 0;
+	};
+}
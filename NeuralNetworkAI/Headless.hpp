@@ -0,0 +1,235 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include "Entities.hpp"
+#include "Simulator.hpp"
+#include "Snapshot.hpp"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <fstream>
+#include <unistd.h>
+#endif
+
+namespace Entities {
+	/*! Resident memory of the process in bytes, or 0 where it can't be read. */
+	inline size_t getResidentMemory() noexcept {
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters;
+		if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+			return counters.WorkingSetSize;
+		return 0;
+#else
+		std::ifstream statm("/proc/self/statm");
+		size_t pages = 0, residentPages = 0;
+		if (!(statm >> pages >> residentPages))
+			return 0;
+		return residentPages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+	}
+
+	struct HeadlessOptions {
+		std::uint64_t ticks = 1'000'000;
+		/*!
+		* Seed of the initial world and of the food put back during the run: a run is reproducible from it,
+		* and a run resumed from a snapshot goes on as it would have without the interruption.
+		*/
+		std::uint64_t seed = 1;
+		size_t worms = 10'000;
+		size_t food = 20'000;
+		size_t walls = 0;
+		/*! Entities are put in [0, worldSize] x [0, worldSize]. */
+		int worldSize = 10'000;
+		/*! Food put back at random places every tick while there is less than `food`, so long runs don't run out of it. */
+		size_t foodPerTick = 10;
+		int nutrition = 10;
+		WormTraits traits{ 100, 5, 10, 1, 100 };
+		/*! Simulated seconds per tick. Ticks are run as fast as possible, the timestep only gives the simulated time. */
+		double timestep = 1.0 / 60;
+		/*! A report every this many ticks; 0 reports only at the end. */
+		std::uint64_t reportEvery = 10'000;
+		size_t threadsNumber = std::thread::hardware_concurrency();
+		TickOptions tick;
+		/*! A snapshot of the world is written to snapshotPath every this many ticks, on a background thread; 0 never writes one. */
+		std::uint64_t snapshotEvery = 0;
+		std::filesystem::path snapshotPath;
+	};
+
+	struct HeadlessReport {
+		std::uint64_t tick = 0;
+		double simulatedSeconds = 0;
+		double elapsedSeconds = 0;
+		/*! Throughput since the previous report. */
+		double ticksPerSecond = 0;
+		/*! Worm updates per second since the previous report. */
+		double agentsPerSecond = 0;
+		size_t worms = 0;
+		size_t food = 0;
+		size_t residentBytes = 0;
+		/*! Totals since the start of the run. */
+		TickStatistics statistics;
+	};
+
+	/*!
+	* Runs a world with a fixed timestep and nothing but the simulation: no rendering, and no output on the hot path.
+	* The only work besides ticks is the food put back every tick; clocks and memory are read when a report is due,
+	* and the report callback is the only place where anything gets printed.
+	*/
+	class HeadlessRunner {
+	public:
+		using ReportFunction = std::function<void(const HeadlessReport& report)>;
+
+		explicit HeadlessRunner(HeadlessOptions options, ReportFunction report = {})
+			: options(options), report(std::move(report)), simulator(options.threadsNumber, options.tick) {
+			if (options.worldSize <= 0)
+				throw std::runtime_error("HeadlessRunner: world size must be positive.");
+			if (options.timestep <= 0)
+				throw std::runtime_error("HeadlessRunner: timestep must be positive.");
+			if (options.snapshotEvery != 0) {
+				if (options.snapshotPath.empty())
+					throw std::runtime_error("HeadlessRunner: snapshots need a path.");
+				snapshots = std::make_unique<Snapshot::Writer>(options.snapshotPath);
+			}
+		}
+
+		/*! Fills the world with the worms, food and walls of the options, at places generated from the seed. */
+		void populate(World& world) {
+			std::mt19937_64 random(options.seed);
+			for (size_t i = 0; i < options.walls; ++i) {
+				world.createWall(randomCoordinates(random));
+			}
+			for (size_t i = 0; i < options.worms; ++i) {
+				world.createWorm(randomCoordinates(random), options.traits);
+			}
+			for (size_t i = 0; i < options.food; ++i) {
+				world.createFood(randomCoordinates(random), options.nutrition);
+			}
+		}
+
+		/*!
+		* Replaces the world with a snapshot and makes the worms decide with its brains, if it has any.
+		* The next run goes on from the tick of the snapshot. Returns that tick.
+		*/
+		std::uint64_t resume(const std::filesystem::path& path, World& world) {
+			auto restored = Snapshot::restore(path, world);
+			brains = std::move(restored.brains);
+			std::vector<const Simulator::Brain*> brainPointers;
+			for (const auto& brain : brains) {
+				brainPointers.push_back(&brain);
+			}
+			simulator.setBrains(std::move(brainPointers));
+			firstTick = restored.tick;
+			return firstTick;
+		}
+
+		/*!
+		* Ticks the world until tick `ticks` (counted from the start of the first run, see resume), or until no worm is left.
+		* Returns the final report, whose throughput is that of the whole run. Waits for the last snapshot to be written.
+		*/
+		HeadlessReport run(World& world) {
+			const auto start = Clock::now();
+			Interval sinceLastReport{ start, firstTick, 0 };
+			Interval sinceStart{ start, firstTick, 0 };
+			TickStatistics total;
+
+			std::uint64_t tick = firstTick;
+			while (tick < options.ticks && world.getWorms().size() > 0) {
+				sinceLastReport.wormTicks += world.getWorms().size();
+				const auto statistics = simulator.tick(world);
+				total.eaten += statistics.eaten;
+				total.attacks += statistics.attacks;
+				total.died += statistics.died;
+				if (options.foodPerTick != 0 && world.getFood().size() < options.food) {
+					// Seeded by the tick, so that it doesn't matter whether the run was resumed.
+					std::mt19937_64 random(options.seed ^ ((tick + 1) * 0x9E3779B97F4A7C15ull));
+					for (size_t i = 0; i < options.foodPerTick && world.getFood().size() < options.food; ++i) {
+						world.createFood(randomCoordinates(random), options.nutrition);
+					}
+				}
+				++tick;
+				if (snapshots && tick % options.snapshotEvery == 0) {
+					snapshots->submit(world, simulator.getBrains(), tick);
+				}
+				if (options.reportEvery != 0 && tick % options.reportEvery == 0 && report) {
+					sinceStart.wormTicks += sinceLastReport.wormTicks;
+					report(makeReport(world, tick, start, sinceLastReport, total));
+					sinceLastReport = { Clock::now(), tick, 0 };
+				}
+			}
+
+			if (snapshots) {
+				snapshots->wait();
+			}
+			firstTick = tick;
+			sinceStart.wormTicks += sinceLastReport.wormTicks;
+			const auto result = makeReport(world, tick, start, sinceStart, total);
+			if (report && sinceLastReport.firstTick != tick) {
+				report(makeReport(world, tick, start, sinceLastReport, total));
+			}
+			return result;
+		}
+
+		Simulator& getSimulator() noexcept {
+			return simulator;
+		}
+
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		/*! Ticks run since `begin`, for the throughput of a report. */
+		struct Interval {
+			Clock::time_point begin;
+			std::uint64_t firstTick;
+			std::uint64_t wormTicks;
+		};
+
+		HeadlessReport makeReport(const World& world, std::uint64_t tick, Clock::time_point start, const Interval& interval,
+								  const TickStatistics& statistics) const {
+			const auto now = Clock::now();
+			const double seconds = std::chrono::duration<double>(now - interval.begin).count();
+			HeadlessReport result;
+			result.tick = tick;
+			result.simulatedSeconds = tick * options.timestep;
+			result.elapsedSeconds = std::chrono::duration<double>(now - start).count();
+			if (seconds > 0) {
+				result.ticksPerSecond = (tick - interval.firstTick) / seconds;
+				result.agentsPerSecond = interval.wormTicks / seconds;
+			}
+			result.worms = world.getWorms().size();
+			result.food = world.getFood().size();
+			result.residentBytes = getResidentMemory();
+			result.statistics = statistics;
+			return result;
+		}
+
+		Positioning::Coordinates randomCoordinates(std::mt19937_64& random) const {
+			std::uniform_int_distribution<int> coordinate(0, options.worldSize);
+			const int x = coordinate(random);
+			return { x, coordinate(random) };
+		}
+
+	private:
+		HeadlessOptions options;
+		ReportFunction report;
+		Simulator simulator;
+		std::unique_ptr<Snapshot::Writer> snapshots;
+		/*! Brains restored from a snapshot, used by the simulator. */
+		std::vector<Simulator::Brain> brains;
+		std::uint64_t firstTick = 0;
+	};
+}
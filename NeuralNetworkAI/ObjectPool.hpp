@@ -0,0 +1,196 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace Utils {
+	/*! Generational handle of an object in an ObjectPool. A handle of a despawned object stays stale, even when its slot is reused. */
+	template<typename T>
+	struct Handle {
+		static constexpr std::uint32_t INVALID_INDEX = std::numeric_limits<std::uint32_t>::max();
+
+		std::uint32_t index = INVALID_INDEX;
+		std::uint32_t generation = 0;
+
+		friend bool operator==(const Handle&, const Handle&) noexcept = default;
+	};
+
+	/*!
+	* Pool of objects of one type (e.g. Food) stored in slabs of SLAB_SIZE slots.
+	* Spawning takes a slot from the free list, or from a new slab when there is none, and despawning destroys the object
+	* and returns its slot to the free list, both in O(1). Slabs are never moved or freed while the pool lives,
+	* so objects keep their addresses (they can be put in a Positioning::SpatialGrid) and memory stops growing once
+	* the pool holds as many slots as the most objects that were alive at the same time.
+	* Code that keeps an object across ticks should keep its Handle: get returns nullptr once the object is gone.
+	*/
+	template<typename T, size_t SLAB_SIZE = 256>
+	class ObjectPool {
+	public:
+		using Handle = Utils::Handle<T>;
+
+		ObjectPool() = default;
+		ObjectPool(const ObjectPool&) = delete;
+		ObjectPool& operator=(const ObjectPool&) = delete;
+
+		~ObjectPool() {
+			clear();
+		}
+
+		template<typename... Args>
+		Handle spawn(Args&&... args) {
+			if (freeSlots.empty()) {
+				addSlab();
+			}
+			const auto index = freeSlots.back();
+			auto& slot = getSlot(index);
+			new (slot.storage) T(std::forward<Args>(args)...);
+			freeSlots.pop_back();
+			slot.alive = true;
+			++objectsNumber;
+			return { index, slot.generation };
+		}
+
+		/*! Destroys the object. Does nothing for stale handles. */
+		void despawn(Handle handle) noexcept {
+			if (!isAlive(handle)) {
+				return;
+			}
+			release(handle.index);
+		}
+
+		/*! Despawns every object for which `predicate(object)` is true, e.g. the Object2D's that shallDestruct. Returns how many. */
+		template<typename Predicate>
+		size_t despawnIf(Predicate&& predicate) {
+			size_t despawned = 0;
+			for (std::uint32_t index = 0; index < getCapacity(); ++index) {
+				auto& slot = getSlot(index);
+				if (slot.alive && predicate(*slot.get())) {
+					release(index);
+					++despawned;
+				}
+			}
+			return despawned;
+		}
+
+		bool isAlive(Handle handle) const noexcept {
+			if (handle.index >= getCapacity()) {
+				return false;
+			}
+			const auto& slot = getSlot(handle.index);
+			return slot.alive && slot.generation == handle.generation;
+		}
+
+		/*! The object, or nullptr if the handle is stale. */
+		T* get(Handle handle) noexcept {
+			return isAlive(handle) ? getSlot(handle.index).get() : nullptr;
+		}
+
+		const T* get(Handle handle) const noexcept {
+			return isAlive(handle) ? getSlot(handle.index).get() : nullptr;
+		}
+
+		/*! Handle of an object of this pool, e.g. of a pointer returned by a sensor system. Throws for objects that aren't in the pool. */
+		Handle getHandle(const T& object) const {
+			const auto address = reinterpret_cast<std::uintptr_t>(&object);
+			for (const auto& slab : slabs) {
+				const auto first = reinterpret_cast<std::uintptr_t>(slab.get());
+				if (address < first || address >= first + SLAB_SIZE * sizeof(Slot)) {
+					continue;
+				}
+				const auto& slot = slab[(address - first) / sizeof(Slot)];
+				if (slot.get() != &object || !slot.alive) {
+					break;
+				}
+				return { slot.index, slot.generation };
+			}
+			throw std::runtime_error("ObjectPool: the object is not in the pool.");
+		}
+
+		/*! Calls `visitor(object)` for every alive object, in slot order. */
+		template<typename Visitor>
+		void forEach(Visitor&& visitor) {
+			for (std::uint32_t index = 0; index < getCapacity(); ++index) {
+				auto& slot = getSlot(index);
+				if (slot.alive) {
+					visitor(*slot.get());
+				}
+			}
+		}
+
+		void clear() noexcept {
+			for (std::uint32_t index = 0; index < getCapacity(); ++index) {
+				if (getSlot(index).alive) {
+					release(index);
+				}
+			}
+		}
+
+		size_t size() const noexcept {
+			return objectsNumber;
+		}
+
+		/*! Number of slots, alive or free. */
+		std::uint32_t getCapacity() const noexcept {
+			return static_cast<std::uint32_t>(slabs.size() * SLAB_SIZE);
+		}
+
+	private:
+		struct Slot {
+			alignas(T) unsigned char storage[sizeof(T)];
+			std::uint32_t index = 0;
+			std::uint32_t generation = 0;
+			bool alive = false;
+
+			T* get() noexcept {
+				return std::launder(reinterpret_cast<T*>(storage));
+			}
+
+			const T* get() const noexcept {
+				return std::launder(reinterpret_cast<const T*>(storage));
+			}
+		};
+
+		Slot& getSlot(std::uint32_t index) noexcept {
+			return slabs[index / SLAB_SIZE][index % SLAB_SIZE];
+		}
+
+		const Slot& getSlot(std::uint32_t index) const noexcept {
+			return slabs[index / SLAB_SIZE][index % SLAB_SIZE];
+		}
+
+		void addSlab() {
+			if (getCapacity() > Handle::INVALID_INDEX - SLAB_SIZE) {
+				throw std::runtime_error("ObjectPool: too many objects.");
+			}
+			const auto first = getCapacity();
+			slabs.push_back(std::make_unique<Slot[]>(SLAB_SIZE));
+			// Room for every slot, so that release never allocates however many objects are despawned.
+			freeSlots.reserve(getCapacity());
+			// Pushed in reverse, so slots are handed out in address order.
+			for (std::uint32_t i = SLAB_SIZE; i-- > 0;) {
+				slabs.back()[i].index = first + i;
+				freeSlots.push_back(first + i);
+			}
+		}
+
+		void release(std::uint32_t index) noexcept {
+			auto& slot = getSlot(index);
+			slot.get()->~T();
+			slot.alive = false;
+			// Handles of the despawned object no longer match the slot.
+			++slot.generation;
+			freeSlots.push_back(index);
+			--objectsNumber;
+		}
+
+	private:
+		std::vector<std::unique_ptr<Slot[]>> slabs;
+		std::vector<std::uint32_t> freeSlots;
+		size_t objectsNumber = 0;
+	};
+}
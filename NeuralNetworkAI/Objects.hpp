@@ -35,7 +35,16 @@ namespace Objects {
 		* with walls. If it's another warm - we try to damage/kill it.
 		*/
 		void makeNextMove(std::vector<Positioning::Object2D>& objects) {
-			auto visibleObjects = sensorSystem->analyze(getCoordinates(), objects);
+			_actOn(sensorSystem->analyze(getCoordinates(), objects));
+		}
+
+		/*! Same as above, but the sensors only look at the objects near the worm. */
+		void makeNextMove(const Positioning::SpatialGrid& grid) {
+			_actOn(sensorSystem->analyze(getCoordinates(), grid));
+		}
+
+	private:
+		void _actOn(const std::vector<Positioning::Object2D*>& visibleObjects) { /*! Selects the target among visible objects and moves towards it */
 			auto selected = brain->desideWhereToGo(visibleObjects);
 			auto distance = getDistance(selected);
 			auto direction = ((selected.getCoordinates() - getCoordinates()) / distance) * body->getMovementSpeedValue();
@@ -48,7 +57,6 @@ namespace Objects {
 			}
 		}
 
-	private:
 		void _handleObject(Positioning::Object2D& object) { /*! Defines action what to do with the object we just met */
 			const auto& objectType = typeid(object);
 
@@ -1,4 +1,3 @@
-#include <cmath>
 #include <stdexcept>
 #include "PositioningSystem.hpp"
 
@@ -53,12 +52,4 @@ namespace Positioning {
 		res /= num;
 		return res;
 	}
-	
-	double Coordinates::getDistance(const Object2D& object) const noexcept {
-		return sqrt(pow(x - object.getX(), 2) + pow(y - object.getY(), 2));
-	}
-	
-	double Coordinates::getDistance(const Coordinates& objectCoordinates) const noexcept {
-		return sqrt(pow(x - objectCoordinates.x, 2) + pow(y - objectCoordinates.y, 2));
-	}
 }
\ No newline at end of file
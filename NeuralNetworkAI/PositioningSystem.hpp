@@ -1,4 +1,11 @@
 #pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace Positioning {
 	/*!
@@ -6,6 +13,7 @@ namespace Positioning {
 	* for example +, -, *, /.
 	*/
 	class Object2D;
+	class SpatialGrid;
 
 	struct Coordinates {
 		int x;
@@ -29,7 +37,16 @@ namespace Positioning {
 
 		double getDistance(const Object2D& object) const noexcept;
 
-		double getDistance(const Coordinates& objectCoordinates) const noexcept;
+		double getDistance(const Coordinates& objectCoordinates) const noexcept {
+			return std::sqrt(static_cast<double>(getSquaredDistance(objectCoordinates)));
+		}
+
+		/*! Square of the distance, exact and without sqrt: compare it with the squared range instead of the distance with the range. */
+		std::int64_t getSquaredDistance(const Coordinates& objectCoordinates) const noexcept {
+			const std::int64_t dx = std::int64_t(x) - objectCoordinates.x;
+			const std::int64_t dy = std::int64_t(y) - objectCoordinates.y;
+			return dx * dx + dy * dy;
+		}
 	};
 
 
@@ -38,7 +55,16 @@ namespace Positioning {
 	*/
 	class Object2D {
 	public:
-		virtual ~Object2D() = default;
+		/*! A copy is at the same place, but is not in the spatial grid of the original. */
+		Object2D(const Object2D& object) noexcept : coords(object.coords), shallBeDestructed(object.shallBeDestructed) {}
+
+		Object2D& operator=(const Object2D& object) noexcept {
+			relocate(object.coords);
+			shallBeDestructed = object.shallBeDestructed;
+			return *this;
+		}
+
+		virtual ~Object2D();
 
 		virtual bool shallDestruct() const noexcept final {
 			return shallBeDestructed;
@@ -53,21 +79,19 @@ namespace Positioning {
 		}
 
 		virtual void move(int offsetX, int offsetY) noexcept final {
-			coords.x += offsetX;
-			coords.y += offsetY;
+			relocate({ coords.x + offsetX, coords.y + offsetY });
 		}
 
 		virtual void move(Coordinates offsets) noexcept final {
-			coords += offsets;
+			relocate({ coords.x + offsets.x, coords.y + offsets.y });
 		}
 
 		virtual void setLocation(int newX, int newY) noexcept final {
-			coords.x = newX;
-			coords.y = newY;
+			relocate({ newX, newY });
 		}
 
 		virtual void setLocation(Coordinates newCoords) noexcept final {
-			coords = newCoords;
+			relocate(newCoords);
 		}
 
 		virtual int getX() const noexcept final {
@@ -75,7 +99,7 @@ namespace Positioning {
 		}
 
 		virtual int getY() const noexcept final {
-			return coords.x;
+			return coords.y;
 		}
 
 		virtual Coordinates getCoordinates() const noexcept final {
@@ -91,8 +115,172 @@ namespace Positioning {
 			shallBeDestructed = true;
 		}
 
+	private:
+		friend class SpatialGrid;
+
+		/*!
+		* Moves the object and, if it's in a spatial grid, tells the grid about it.
+		* Entering a cell for the first time, or one fuller than ever before, allocates; that is not expected to fail,
+		* and if it does the program terminates instead of leaving the object outside the grid.
+		*/
+		void relocate(Coordinates newCoords) noexcept;
+
 	private:
 		Coordinates coords;
 		bool shallBeDestructed;
+		SpatialGrid* grid = nullptr;
+	};
+
+
+	/*!
+	* SpatialGrid is a uniform grid over the map that finds the objects near a point without looking at all of them.
+	* Objects are kept in the cell they are in, and cells are hashed, so the map has no bounds and empty areas cost nothing.
+	* Inserted objects keep their cell up to date by themselves: move and setLocation tell the grid, which only
+	* does some work when the object crossed into another cell. Objects leave the grid when they are destroyed.
+	* A query looks at the cells covered by its radius, so the best cell size is close to the usual radius.
+	*/
+	class SpatialGrid {
+	public:
+		explicit SpatialGrid(int cellSize) : cellSize(cellSize) {
+			if (cellSize <= 0) {
+				throw std::runtime_error("SpatialGrid: cell size must be positive.");
+			}
+		}
+
+		SpatialGrid(const SpatialGrid&) = delete;
+		SpatialGrid& operator=(const SpatialGrid&) = delete;
+
+		~SpatialGrid() {
+			for (auto& [key, cell] : cells) {
+				for (auto* object : cell) {
+					object->grid = nullptr;
+				}
+			}
+		}
+
+		/*! The object has to stay at the same address while it's in the grid. */
+		void insert(Object2D& object) {
+			if (object.grid == this) {
+				return;
+			}
+			if (object.grid != nullptr) {
+				throw std::runtime_error("SpatialGrid: the object is already in another grid.");
+			}
+			cells[getKey(object.coords)].push_back(&object);
+			object.grid = this;
+			++objectsNumber;
+		}
+
+		void remove(Object2D& object) noexcept {
+			if (object.grid != this) {
+				return;
+			}
+			erase(getKey(object.coords), object);
+			object.grid = nullptr;
+			--objectsNumber;
+		}
+
+		size_t size() const noexcept {
+			return objectsNumber;
+		}
+
+		int getCellSize() const noexcept {
+			return cellSize;
+		}
+
+		/*! Calls `visitor` with every object that is at most `radius` away from `center`. */
+		template<typename Visitor>
+		void forEachInRadius(const Coordinates& center, double radius, Visitor&& visitor) const {
+			if (radius < 0) {
+				return;
+			}
+			const double squaredRadius = radius * radius;
+			const int reach = static_cast<int>(std::ceil(radius));
+			const int lastX = getCell(center.x + reach);
+			const int lastY = getCell(center.y + reach);
+			for (int cellX = getCell(center.x - reach); cellX <= lastX; ++cellX) {
+				for (int cellY = getCell(center.y - reach); cellY <= lastY; ++cellY) {
+					const auto cell = cells.find(getKey(cellX, cellY));
+					if (cell == cells.end()) {
+						continue;
+					}
+					for (auto* object : cell->second) {
+						if (static_cast<double>(center.getSquaredDistance(object->coords)) <= squaredRadius) {
+							visitor(*object);
+						}
+					}
+				}
+			}
+		}
+
+		/*! Appends the objects that are at most `radius` away from `center` to `result`. */
+		void query(const Coordinates& center, double radius, std::vector<Object2D*>& result) const {
+			forEachInRadius(center, radius, [&result](Object2D& object) {
+				result.push_back(&object);
+			});
+		}
+
+	private:
+		friend class Object2D;
+
+		/*! Only allocates when the new cell is new or full, see Object2D::relocate. */
+		void update(Object2D& object, const Coordinates& oldCoords) noexcept {
+			const auto oldKey = getKey(oldCoords);
+			const auto newKey = getKey(object.coords);
+			if (oldKey == newKey) {
+				return;
+			}
+			erase(oldKey, object);
+			cells[newKey].push_back(&object);
+		}
+
+		void erase(std::uint64_t key, const Object2D& object) noexcept {
+			auto& cell = cells.find(key)->second;
+			for (auto& cellObject : cell) {
+				if (cellObject == &object) {
+					// Empty cells are kept, so objects walking around don't allocate them again and again.
+					std::swap(cellObject, cell.back());
+					cell.pop_back();
+					return;
+				}
+			}
+		}
+
+		/*! Index of the cell with the coordinate, rounded towards negative infinity. */
+		int getCell(int coordinate) const noexcept {
+			return coordinate >= 0 ? coordinate / cellSize : -1 - (-1 - coordinate) / cellSize;
+		}
+
+		std::uint64_t getKey(const Coordinates& coords) const noexcept {
+			return getKey(getCell(coords.x), getCell(coords.y));
+		}
+
+		static std::uint64_t getKey(int cellX, int cellY) noexcept {
+			return (std::uint64_t(std::uint32_t(cellX)) << 32) | std::uint32_t(cellY);
+		}
+
+	private:
+		const int cellSize;
+		size_t objectsNumber = 0;
+		std::unordered_map<std::uint64_t, std::vector<Object2D*>> cells;
 	};
+
+
+	inline double Coordinates::getDistance(const Object2D& object) const noexcept {
+		return getDistance(object.getCoordinates());
+	}
+
+	inline Object2D::~Object2D() {
+		if (grid != nullptr) {
+			grid->remove(*this);
+		}
+	}
+
+	inline void Object2D::relocate(Coordinates newCoords) noexcept {
+		const auto oldCoords = coords;
+		coords = newCoords;
+		if (grid != nullptr) {
+			grid->update(*this, oldCoords);
+		}
+	}
 }
@@ -0,0 +1,118 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+#include "CognitiveSystem.hpp"
+#include "Quantization.hpp"
+
+namespace CognitiveSystems {
+    using ::NeuralNetwork::Quantization::ScaleGranularity;
+
+    /*! How far the quantized network is from the float one it was made from. */
+    struct QuantizationReport {
+        float maxAbsoluteError = 0;
+        float meanAbsoluteError = 0;
+        size_t samples = 0;
+        size_t floatWeightsBytes = 0;
+        size_t quantizedWeightsBytes = 0;
+    };
+
+    /*! Buffers of one pass through a QuantizedNeuralNetwork, owned by the caller like Workspace. */
+    class QuantizedWorkspace {
+    private:
+        template<Activations::Activation>
+        friend class BasicQuantizedNeuralNetwork;
+
+        std::vector<std::vector<float>> signals;
+        std::vector<int8_t> quantizedSignals;
+    };
+
+    /*!
+    * Inference-only copy of a trained NeuralNetwork with int8 weights. Signals entering every layer
+    * are quantized on the fly with a scale picked from their range, dot products are accumulated
+    * in int32 and scaled back to float before the activation. The input layer, which has a single
+    * weight per neuron, stays in float.
+    */
+    template<Activations::Activation ActivationFunction>
+    class BasicQuantizedNeuralNetwork {
+    public:
+        explicit BasicQuantizedNeuralNetwork(const BasicNeuralNetwork<ActivationFunction>& network, ScaleGranularity granularity = ScaleGranularity::PerRow) {
+            const auto& networkLayers = network.getLayers();
+            const auto& inputWeights = networkLayers.front().getWeights();
+            inputLayerWeights.assign(inputWeights.getData(), inputWeights.getData() + inputWeights.size());
+            layers.reserve(networkLayers.size() - 1);
+            for (size_t l = 1; l < networkLayers.size(); ++l) {
+                layers.emplace_back(networkLayers[l].getWeights().view(), granularity);
+            }
+        }
+
+        /*! Bytes taken by the weights of all layers. */
+        size_t getMemorySize() const noexcept {
+            size_t size = inputLayerWeights.size() * sizeof(float);
+            for (const auto& layer : layers) {
+                size += layer.getMemorySize();
+            }
+            return size;
+        }
+
+        /*! Same contract as NeuralNetwork::feedForward with a workspace: const and safe to call from many threads. */
+        const std::vector<float>& feedForward(const std::vector<float>& inputSignals, QuantizedWorkspace& workspace) const {
+            if (inputSignals.size() != inputLayerWeights.size())
+                throw std::runtime_error("input signals number is not equal to the input layer neurons number");
+
+            workspace.signals.resize(layers.size() + 1);
+            auto& inputLayerSignals = workspace.signals.front();
+            inputLayerSignals.resize(inputLayerWeights.size());
+            for (size_t k = 0; k < inputLayerWeights.size(); ++k) {
+                inputLayerSignals[k] = inputSignals[k] * inputLayerWeights[k];
+            }
+
+            for (size_t l = 0; l < layers.size(); ++l) {
+                const auto& previousLayerSignals = workspace.signals[l];
+                auto& layerSignals = workspace.signals[l + 1];
+                workspace.quantizedSignals.resize(previousLayerSignals.size());
+                layerSignals.resize(layers[l].rows());
+
+                const float scale = ::NeuralNetwork::Quantization::quantizeSignals(previousLayerSignals, workspace.quantizedSignals);
+                layers[l].multiply(workspace.quantizedSignals, scale, layerSignals);
+                ActivationFunction::activate(layerSignals.data(), layerSignals.size());
+            }
+            return workspace.signals.back();
+        }
+
+        /*! Runs `inputs` through both networks and reports how much the quantized outputs drift. */
+        QuantizationReport compare(const BasicNeuralNetwork<ActivationFunction>& network, const std::vector<std::vector<float>>& inputs) const {
+            QuantizationReport report;
+            for (const auto& layer : network.getLayers()) {
+                report.floatWeightsBytes += layer.getWeights().size() * sizeof(float);
+            }
+            report.quantizedWeightsBytes = getMemorySize();
+
+            Workspace workspace;
+            QuantizedWorkspace quantizedWorkspace;
+            double errorsSum = 0;
+            size_t outputsNumber = 0;
+            for (const auto& sampleInputs : inputs) {
+                const auto& expected = network.feedForward(sampleInputs, workspace);
+                const auto& actual = feedForward(sampleInputs, quantizedWorkspace);
+                for (size_t k = 0; k < expected.size(); ++k) {
+                    const float error = std::abs(actual[k] - expected[k]);
+                    report.maxAbsoluteError = std::max(report.maxAbsoluteError, error);
+                    errorsSum += error;
+                }
+                outputsNumber += expected.size();
+            }
+            report.samples = inputs.size();
+            report.meanAbsoluteError = outputsNumber > 0 ? static_cast<float>(errorsSum / outputsNumber) : 0.f;
+            return report;
+        }
+
+    private:
+        std::vector<float> inputLayerWeights;
+        std::vector<::NeuralNetwork::Quantization::QuantizedMatrix> layers;
+    };
+
+    using QuantizedNeuralNetwork = BasicQuantizedNeuralNetwork<Activations::Sigmoid>;
+}
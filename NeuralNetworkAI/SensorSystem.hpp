@@ -12,13 +12,24 @@ namespace SensorSystems {
 			std::vector<Positioning::Object2D*> visibleObjects;
 			visibleObjects.reserve(objects.size());
 
+			const double squaredRange = visibleRange * visibleRange;
 			for (auto& object : objects) {
-				if (currentPosition.getDistance(object) <= visibleRange) {
+				if (static_cast<double>(currentPosition.getSquaredDistance(object.getCoordinates())) <= squaredRange) {
 					visibleObjects.push_back(&object);
 				}
 			}
 
-			return std::move(visibleObjects);
+			return visibleObjects;
+		}
+
+		const std::vector<Positioning::Object2D*> analyze(const Positioning::Coordinates& currentPosition, const Positioning::SpatialGrid& grid) override {
+			std::vector<Positioning::Object2D*> visibleObjects;
+			grid.query(currentPosition, visibleRange, visibleObjects);
+			return visibleObjects;
+		}
+
+		double getVisibleRange() const noexcept {
+			return visibleRange;
 		}
 		
 	private:
@@ -0,0 +1,570 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "Entities.hpp"
+#include "ThreadPool.hpp"
+#include "CognitiveSystem.hpp"
+
+namespace Entities {
+	/*! An entity seen by a worm: what it is and where it was at the start of the tick. */
+	struct Sighting {
+		Entity entity;
+		Kind kind = Kind::Wall;
+		Positioning::Coordinates coordinates{ 0, 0 };
+	};
+
+	/*!
+	* CellIndex is a spatial index of all entities of a world, rebuilt from their columns every tick.
+	* Entities are counting-sorted into the cells of a dense grid over their bounding box, so building it
+	* is linear, queries read contiguous memory, and the order of entities in a cell (worms, food, walls,
+	* each in row order) is the same on every run.
+	*/
+	class CellIndex {
+	public:
+		/*! Cells are `cellSize` wide, or wider when the world is so sparse that the grid would have many more cells than entities. */
+		void build(const World& world, int cellSize) {
+			if (cellSize <= 0) {
+				throw std::runtime_error("CellIndex: cell size must be positive.");
+			}
+			sightings.clear();
+			append(world.getWorms(), Kind::Worm);
+			append(world.getFood(), Kind::Food);
+			append(world.getWalls(), Kind::Wall);
+
+			int minX = 0, minY = 0, maxX = 0, maxY = 0;
+			if (!sightings.empty()) {
+				minX = maxX = sightings.front().coordinates.x;
+				minY = maxY = sightings.front().coordinates.y;
+				for (const auto& sighting : sightings) {
+					minX = std::min(minX, sighting.coordinates.x);
+					maxX = std::max(maxX, sighting.coordinates.x);
+					minY = std::min(minY, sighting.coordinates.y);
+					maxY = std::max(maxY, sighting.coordinates.y);
+				}
+			}
+			originX = minX;
+			originY = minY;
+			const std::int64_t maxCells = 4 * std::int64_t(sightings.size()) + 1024;
+			std::int64_t size = cellSize;
+			while (getCellsNumber(minX, maxX, size) * getCellsNumber(minY, maxY, size) > maxCells) {
+				size *= 2;
+			}
+			this->cellSize = static_cast<int>(std::min<std::int64_t>(size, std::numeric_limits<int>::max()));
+			width = static_cast<int>(getCellsNumber(minX, maxX, size));
+			height = static_cast<int>(getCellsNumber(minY, maxY, size));
+
+			cellStarts.assign(size_t(width) * height + 1, 0);
+			cells.resize(sightings.size());
+			for (size_t i = 0; i < sightings.size(); ++i) {
+				cells[i] = getCell(sightings[i].coordinates);
+				++cellStarts[cells[i] + 1];
+			}
+			for (size_t c = 1; c < cellStarts.size(); ++c) {
+				cellStarts[c] += cellStarts[c - 1];
+			}
+			sorted.resize(sightings.size());
+			positions.assign(cellStarts.begin(), cellStarts.end() - 1);
+			for (size_t i = 0; i < sightings.size(); ++i) {
+				sorted[positions[cells[i]]++] = sightings[i];
+			}
+		}
+
+		size_t size() const noexcept {
+			return sorted.size();
+		}
+
+		/*!
+		* Appends every entity at most `radius` away from `center` to `result`, in the same order on every run.
+		* Entities of a cell are copied without branching on the distance, so the test doesn't cost branch mispredictions.
+		*/
+		void query(const Positioning::Coordinates& center, double radius, std::vector<Sighting>& result) const {
+			if (radius < 0 || sorted.empty()) {
+				return;
+			}
+			const double squaredRadius = radius * radius;
+			const std::int64_t reach = static_cast<std::int64_t>(std::ceil(radius));
+			const std::int64_t firstX = std::max<std::int64_t>(getCellIndex(center.x - reach, originX), 0);
+			const std::int64_t lastX = std::min<std::int64_t>(getCellIndex(center.x + reach, originX), width - 1);
+			const std::int64_t firstY = std::max<std::int64_t>(getCellIndex(center.y - reach, originY), 0);
+			const std::int64_t lastY = std::min<std::int64_t>(getCellIndex(center.y + reach, originY), height - 1);
+			if (firstX > lastX) {
+				return;
+			}
+			for (std::int64_t cellY = firstY; cellY <= lastY; ++cellY) {
+				// Cells of a row of the grid are contiguous in `sorted`.
+				const size_t rowStart = size_t(cellY) * width;
+				const auto begin = cellStarts[rowStart + size_t(firstX)];
+				const auto end = cellStarts[rowStart + size_t(lastX) + 1];
+				if (begin == end) {
+					continue;
+				}
+				size_t found = result.size();
+				result.resize(found + (end - begin));
+				for (auto i = begin; i < end; ++i) {
+					result[found] = sorted[i];
+					found += static_cast<double>(center.getSquaredDistance(sorted[i].coordinates)) <= squaredRadius;
+				}
+				result.resize(found);
+			}
+		}
+
+	private:
+		template<typename Table>
+		void append(const Table& table, Kind kind) {
+			for (size_t row = 0; row < table.size(); ++row) {
+				sightings.push_back({ table.entities[row], kind, table.getCoordinates(row) });
+			}
+		}
+
+		static std::int64_t getCellsNumber(int min, int max, std::int64_t size) noexcept {
+			return (std::int64_t(max) - min) / size + 1;
+		}
+
+		/*! Cell of the coordinate relative to the origin, rounded towards negative infinity. */
+		std::int64_t getCellIndex(std::int64_t coordinate, int origin) const noexcept {
+			const std::int64_t offset = coordinate - origin;
+			return offset >= 0 ? offset / cellSize : -1 - (-1 - offset) / cellSize;
+		}
+
+		std::uint32_t getCell(const Positioning::Coordinates& coords) const noexcept {
+			return static_cast<std::uint32_t>(getCellIndex(coords.y, originY) * width + getCellIndex(coords.x, originX));
+		}
+
+	private:
+		int cellSize = 1;
+		int originX = 0;
+		int originY = 0;
+		int width = 0;
+		int height = 0;
+		std::vector<Sighting> sightings;
+		std::vector<std::uint32_t> cells;
+		std::vector<std::uint32_t> cellStarts;
+		std::vector<std::uint32_t> positions;
+		std::vector<Sighting> sorted;
+	};
+
+	/*! What a worm sees: the entities in its visible range, in CellIndex order, without the worm itself. */
+	using Perception = std::span<const Sighting>;
+
+	/*!
+	* Fixed-width description of what a worm senses, the same for every worm, so that all worms with the same brain
+	* can be run through it as one batch. For worms, food and walls (in Kind order): offset to the nearest one divided
+	* by the visible range, whether there is one, and how crowded that kind is around; then the worm's own health and energy.
+	*/
+	namespace Senses {
+		constexpr size_t KINDS_NUMBER = 3;
+		constexpr size_t FEATURES_PER_KIND = 4;
+		constexpr size_t FEATURES_NUMBER = KINDS_NUMBER * FEATURES_PER_KIND + 2;
+		/*! Number of sightings of a kind at which its crowding feature reaches 1. */
+		constexpr float CROWD_SIZE = 16.f;
+		/*! Energy at which the energy feature reaches 0.5. */
+		constexpr float ENERGY_SCALE = 100.f;
+
+		/*! What a brain decides: go to the nearest entity of a kind, or stay. Brains have one output per action. */
+		enum class Action : unsigned char {
+			GoToWorm, GoToFood, GoToWall, Stay
+		};
+
+		constexpr size_t ACTIONS_NUMBER = 4;
+
+		/*! Writes the features of the worm in `row` and its nearest sighting of every kind; the entity is Entity{} if there is none. */
+		inline void extract(const WormTable& worms, size_t row, const Perception& perception, double visibleRange,
+							std::span<float> features, std::array<Sighting, KINDS_NUMBER>& nearest) noexcept {
+			const auto position = worms.getCoordinates(row);
+			std::array<std::int64_t, KINDS_NUMBER> distances;
+			std::array<size_t, KINDS_NUMBER> counts{};
+			distances.fill(std::numeric_limits<std::int64_t>::max());
+			nearest.fill(Sighting{});
+			for (const auto& sighting : perception) {
+				const size_t kind = static_cast<size_t>(sighting.kind);
+				const auto distance = position.getSquaredDistance(sighting.coordinates);
+				++counts[kind];
+				if (distance < distances[kind]) {
+					distances[kind] = distance;
+					nearest[kind] = sighting;
+				}
+			}
+
+			const float scale = visibleRange > 0 ? static_cast<float>(1.0 / visibleRange) : 1.f;
+			for (size_t kind = 0; kind < KINDS_NUMBER; ++kind) {
+				float* const kindFeatures = features.data() + kind * FEATURES_PER_KIND;
+				const bool seen = counts[kind] > 0;
+				kindFeatures[0] = seen ? (nearest[kind].coordinates.x - position.x) * scale : 0.f;
+				kindFeatures[1] = seen ? (nearest[kind].coordinates.y - position.y) * scale : 0.f;
+				kindFeatures[2] = seen ? 1.f : 0.f;
+				kindFeatures[3] = std::min(counts[kind] / CROWD_SIZE, 1.f);
+			}
+			const float energy = static_cast<float>(std::max(worms.energy[row], 0));
+			features[KINDS_NUMBER * FEATURES_PER_KIND] = static_cast<float>(worms.health[row]) / worms.maxHealth[row];
+			features[KINDS_NUMBER * FEATURES_PER_KIND + 1] = energy / (energy + ENERGY_SCALE);
+		}
+	}
+
+	struct TickOptions {
+		double visibleRange = 250.0;
+		/*! Worms are split into tasks of this many rows for the thread pool. */
+		size_t rowsPerTask = 256;
+	};
+
+	struct TickStatistics {
+		size_t eaten = 0;
+		size_t attacks = 0;
+		size_t died = 0;
+	};
+
+	/*!
+	* Simulator runs ticks of a world in two phases, on a thread pool:
+	* 1. Sense and decide: every worm looks at the world as it was at the start of the tick, through a CellIndex,
+	*    and picks its target, with the decision function or with its brain (see setBrains).
+	*    Worms only read the world and write their own row of the decisions, so they run in parallel.
+	* 2. Apply: worms move towards their targets in parallel, each writing only its own row. Then interactions
+	*    are resolved in a sequential pass with rules that don't depend on the order of worms: food claimed by several
+	*    worms goes to the one that was closest to it (then to the lower entity index), and all attacks of the tick
+	*    are summed before they are applied. Eaten food and dead worms are destroyed at the end.
+	* Nothing depends on which thread ran which worm, so the world after a tick is bit-identical for any number of threads.
+	*/
+	class Simulator {
+	public:
+		using Brain = CognitiveSystems::NeuralNetwork;
+
+		/*!
+		* Picks the target of the worm in `row` among what it sees, or returns Entity{} to stay.
+		* Runs in parallel for many worms, so it must only read the world.
+		*/
+		using DecisionFunction = std::function<Entity(const World& world, size_t row, const Perception& perception)>;
+
+		/*! Goes to the nearest food, or attacks the nearest worm if there is no food around. */
+		static Entity decideNearest(const World& world, size_t row, const Perception& perception) {
+			const auto position = world.getWorms().getCoordinates(row);
+			Entity bestFood, bestWorm;
+			std::int64_t bestFoodDistance = std::numeric_limits<std::int64_t>::max();
+			std::int64_t bestWormDistance = std::numeric_limits<std::int64_t>::max();
+			for (const auto& sighting : perception) {
+				const auto distance = position.getSquaredDistance(sighting.coordinates);
+				switch (sighting.kind) {
+				case Kind::Food:
+					if (distance < bestFoodDistance) {
+						bestFood = sighting.entity;
+						bestFoodDistance = distance;
+					}
+					break;
+				case Kind::Worm:
+					if (distance < bestWormDistance) {
+						bestWorm = sighting.entity;
+						bestWormDistance = distance;
+					}
+					break;
+				case Kind::Wall:
+					break;
+				}
+			}
+			return bestFood.index != Entity::INVALID_INDEX ? bestFood : bestWorm;
+		}
+
+		explicit Simulator(size_t threadsNumber = std::thread::hardware_concurrency(), TickOptions options = {},
+						   DecisionFunction decide = decideNearest)
+			: pool(threadsNumber), options(options), decide(std::move(decide)) {
+			if (this->options.rowsPerTask == 0) {
+				this->options.rowsPerTask = 1;
+			}
+		}
+
+		/*!
+		* Makes worms decide with neural networks instead of the decision function; the `brain` column of a worm
+		* selects its network. Worms are grouped by the topology of their brains and their Senses features are gathered
+		* into one matrix, which is run in batches of rowsPerTask rows with feedForwardEach: every worm uses its own weights,
+		* even when all brains are different, but the worms of a topology share the tasks and the layer passes,
+		* and worms of the same brain are adjacent, so its weights are loaded once for all of them.
+		* A worm takes the action with the highest output among those it can take. Brains need Senses::FEATURES_NUMBER
+		* inputs and Senses::ACTIONS_NUMBER outputs and are not copied. An empty vector goes back to the decision function.
+		*/
+		void setBrains(std::vector<const Brain*> newBrains) {
+			for (const auto* brain : newBrains) {
+				if (brain == nullptr) {
+					throw std::runtime_error("Simulator: brain is null.");
+				}
+				const auto& topology = brain->getTopology();
+				if (static_cast<size_t>(topology.getInputNumber()) != Senses::FEATURES_NUMBER
+					|| static_cast<size_t>(topology.getOutputNumber()) != Senses::ACTIONS_NUMBER) {
+					throw std::runtime_error("Simulator: brains must have " + std::to_string(Senses::FEATURES_NUMBER) + " inputs and "
+											 + std::to_string(Senses::ACTIONS_NUMBER) + " outputs.");
+				}
+			}
+			// Brains ordered by topology, the first brain of a topology deciding where it goes.
+			std::vector<size_t> order(newBrains.size());
+			std::vector<size_t> topologies(newBrains.size());
+			for (size_t b = 0; b < newBrains.size(); ++b) {
+				order[b] = b;
+				topologies[b] = b;
+				for (size_t other = 0; other < b; ++other) {
+					if (Brain::haveSameLayerSizes(*newBrains[b], *newBrains[other])) {
+						topologies[b] = topologies[other];
+						break;
+					}
+				}
+			}
+			std::stable_sort(order.begin(), order.end(), [&](size_t left, size_t right) {
+				return topologies[left] < topologies[right];
+			});
+			brainRanks.resize(newBrains.size());
+			topologyEnds.clear();
+			for (size_t rank = 0; rank < order.size(); ++rank) {
+				brainRanks[order[rank]] = rank;
+				if (rank + 1 == order.size() || topologies[order[rank + 1]] != topologies[order[rank]]) {
+					topologyEnds.push_back(rank + 1);
+				}
+			}
+			brains = std::move(newBrains);
+		}
+
+		TickStatistics tick(World& world) {
+			auto& worms = world.getWorms();
+			const size_t wormsNumber = worms.size();
+			const size_t tasksNumber = (wormsNumber + options.rowsPerTask - 1) / options.rowsPerTask;
+
+			index.build(world, std::max(1, static_cast<int>(std::ceil(options.visibleRange))));
+			targets.assign(wormsNumber, Entity{});
+			targetCoordinates.resize(wormsNumber);
+			targetDistances.resize(wormsNumber);
+			if (perceptions.size() < tasksNumber) {
+				perceptions.resize(tasksNumber);
+			}
+			if (!brains.empty()) {
+				groupByBrain(worms);
+			}
+
+			// Phase 1: sense and decide against the world as it is now.
+			const World& snapshot = world;
+			pool.run(tasksNumber, [&](size_t task) {
+				auto& perceived = perceptions[task];
+				const size_t end = std::min(wormsNumber, (task + 1) * options.rowsPerTask);
+				for (size_t row = task * options.rowsPerTask; row < end; ++row) {
+					const auto self = worms.entities[row];
+					perceived.clear();
+					index.query(worms.getCoordinates(row), options.visibleRange, perceived);
+					perceived.erase(std::remove_if(perceived.begin(), perceived.end(), [&](const Sighting& sighting) {
+						return sighting.entity == self;
+					}), perceived.end());
+					if (!brains.empty()) {
+						Senses::extract(worms, row, perceived, options.visibleRange, features.row(rowSlots[row]), nearest[row]);
+						continue;
+					}
+					const auto target = decide(snapshot, row, perceived);
+					if (snapshot.isAlive(target)) {
+						setTarget(worms, row, target, snapshot.getCoordinates(target));
+					}
+				}
+			});
+			if (!brains.empty()) {
+				decideWithBrains(worms);
+			}
+
+			// Phase 2: moves write the row of their worm only.
+			pool.run(tasksNumber, [&](size_t task) {
+				const size_t end = std::min(wormsNumber, (task + 1) * options.rowsPerTask);
+				for (size_t row = task * options.rowsPerTask; row < end; ++row) {
+					if (targets[row].index == Entity::INVALID_INDEX) {
+						worms.velocityX[row] = worms.velocityY[row] = 0;
+						continue;
+					}
+					Systems::steerTowards(worms, row, targetCoordinates[row]);
+					worms.x[row] += worms.velocityX[row];
+					worms.y[row] += worms.velocityY[row];
+				}
+			});
+
+			return resolveInteractions(world);
+		}
+
+		const std::vector<const Brain*>& getBrains() const noexcept {
+			return brains;
+		}
+
+		const std::vector<Entity>& getTargets() const noexcept {
+			return targets;
+		}
+
+		size_t getThreadsNumber() const noexcept {
+			return pool.getThreadsNumber();
+		}
+
+	private:
+		static constexpr std::uint32_t NO_CLAIM = std::numeric_limits<std::uint32_t>::max();
+
+		/*! Rows of the feature matrix of worms whose brains have the same topology, a batch for feedForwardEach. */
+		struct BrainBatch {
+			size_t begin;
+			size_t end;
+		};
+
+		void setTarget(const WormTable& worms, size_t row, Entity target, Positioning::Coordinates coords) noexcept {
+			targets[row] = target;
+			targetCoordinates[row] = coords;
+			targetDistances[row] = worms.getCoordinates(row).getSquaredDistance(coords);
+		}
+
+		/*!
+		* Counting sort of the worms by the rank of their brain, so worms of a topology and, within it, worms of a brain
+		* are adjacent: the features of worm `row` go to row rowSlots[row] of the feature matrix.
+		*/
+		void groupByBrain(const WormTable& worms) {
+			groupStarts.assign(brains.size() + 1, 0);
+			for (const auto brain : worms.brain) {
+				if (brain >= brains.size()) {
+					throw std::runtime_error("Simulator: worm has brain " + std::to_string(brain) + ", but there are only "
+											 + std::to_string(brains.size()) + " brains.");
+				}
+				++groupStarts[brainRanks[brain] + 1];
+			}
+			for (size_t b = 1; b < groupStarts.size(); ++b) {
+				groupStarts[b] += groupStarts[b - 1];
+			}
+			slotRows.resize(worms.size());
+			rowSlots.resize(worms.size());
+			positions.assign(groupStarts.begin(), groupStarts.end() - 1);
+			slotBrains.resize(worms.size());
+			for (size_t row = 0; row < worms.size(); ++row) {
+				const size_t slot = positions[brainRanks[worms.brain[row]]]++;
+				slotRows[slot] = row;
+				rowSlots[row] = slot;
+				slotBrains[slot] = brains[worms.brain[row]];
+			}
+			features.resize(worms.size(), Senses::FEATURES_NUMBER);
+			nearest.resize(worms.size());
+
+			batches.clear();
+			size_t topologyBegin = 0;
+			for (const auto topologyEnd : topologyEnds) {
+				const size_t end = groupStarts[topologyEnd];
+				for (size_t begin = groupStarts[topologyBegin]; begin < end; begin += options.rowsPerTask) {
+					batches.push_back({ begin, std::min(begin + options.rowsPerTask, end) });
+				}
+				topologyBegin = topologyEnd;
+			}
+			if (workspaces.size() < batches.size()) {
+				workspaces.resize(batches.size());
+			}
+		}
+
+		/*! Runs every batch through its brain and scatters the chosen actions back to the rows of the worms. */
+		void decideWithBrains(const WormTable& worms) {
+			pool.run(batches.size(), [&](size_t b) {
+				const auto& batch = batches[b];
+				const ::NeuralNetwork::MatrixView<const float> inputs(features.getData() + batch.begin * Senses::FEATURES_NUMBER,
+																	   batch.end - batch.begin, Senses::FEATURES_NUMBER);
+				const auto batchBrains = std::span<const Brain* const>(slotBrains).subspan(batch.begin, batch.end - batch.begin);
+				const auto& outputs = Brain::feedForwardEach(batchBrains, inputs, workspaces[b]);
+				for (size_t i = 0; i < outputs.rows(); ++i) {
+					const size_t row = slotRows[batch.begin + i];
+					const auto scores = outputs.row(i);
+					size_t action = static_cast<size_t>(Senses::Action::Stay);
+					for (size_t kind = 0; kind < Senses::KINDS_NUMBER; ++kind) {
+						if (nearest[row][kind].entity.index != Entity::INVALID_INDEX && scores[kind] > scores[action]) {
+							action = kind;
+						}
+					}
+					if (action != static_cast<size_t>(Senses::Action::Stay)) {
+						setTarget(worms, row, nearest[row][action].entity, nearest[row][action].coordinates);
+					}
+				}
+			});
+		}
+
+		/*! Interactions of worms that reached their targets, resolved independently of the order of worms. */
+		TickStatistics resolveInteractions(World& world) {
+			auto& worms = world.getWorms();
+			auto& food = world.getFood();
+			TickStatistics statistics;
+			foodClaims.assign(food.size(), NO_CLAIM);
+			damageTaken.assign(worms.size(), 0);
+
+			for (size_t row = 0; row < worms.size(); ++row) {
+				if (targets[row].index == Entity::INVALID_INDEX
+					|| worms.getCoordinates(row).getSquaredDistance(targetCoordinates[row]) > 1) {
+					continue;
+				}
+				const size_t targetRow = world.getRow(targets[row]);
+				switch (world.getKind(targets[row])) {
+				case Kind::Food: {
+					auto& claim = foodClaims[targetRow];
+					if (claim == NO_CLAIM || isStrongerClaim(worms, row, claim)) {
+						claim = static_cast<std::uint32_t>(row);
+					}
+					break;
+				}
+				case Kind::Wall:
+					Systems::regenerate(worms, row);
+					break;
+				case Kind::Worm:
+					damageTaken[targetRow] += worms.damage[row];
+					++statistics.attacks;
+					break;
+				}
+			}
+
+			eatenFood.clear();
+			for (size_t foodRow = 0; foodRow < foodClaims.size(); ++foodRow) {
+				const auto worm = foodClaims[foodRow];
+				if (worm == NO_CLAIM) {
+					continue;
+				}
+				worms.energy[worm] += food.nutrition[foodRow];
+				Systems::regenerate(worms, worm);
+				eatenFood.push_back(food.entities[foodRow]);
+			}
+			for (size_t row = 0; row < worms.size(); ++row) {
+				worms.health[row] = std::max(worms.health[row] - damageTaken[row], 0);
+			}
+
+			for (const auto& eaten : eatenFood) {
+				world.destroy(eaten);
+			}
+			statistics.eaten = eatenFood.size();
+			statistics.died = Systems::removeDead(world);
+			return statistics;
+		}
+
+		bool isStrongerClaim(const WormTable& worms, size_t row, size_t claim) const noexcept {
+			if (targetDistances[row] != targetDistances[claim]) {
+				return targetDistances[row] < targetDistances[claim];
+			}
+			return worms.entities[row].index < worms.entities[claim].index;
+		}
+
+	private:
+		Utils::ThreadPool pool;
+		TickOptions options;
+		DecisionFunction decide;
+		CellIndex index;
+		std::vector<std::vector<Sighting>> perceptions;
+		std::vector<Entity> targets;
+		std::vector<Positioning::Coordinates> targetCoordinates;
+		std::vector<std::int64_t> targetDistances;
+		std::vector<std::uint32_t> foodClaims;
+		std::vector<int> damageTaken;
+		std::vector<Entity> eatenFood;
+		std::vector<const Brain*> brains;
+		/*! Position of every brain when they are ordered by topology. */
+		std::vector<size_t> brainRanks;
+		/*! Ranks where the brains of a topology end. */
+		std::vector<size_t> topologyEnds;
+		std::vector<size_t> groupStarts;
+		std::vector<size_t> positions;
+		std::vector<size_t> slotRows;
+		std::vector<size_t> rowSlots;
+		std::vector<const Brain*> slotBrains;
+		::NeuralNetwork::Matrix<float> features;
+		std::vector<std::array<Sighting, Senses::KINDS_NUMBER>> nearest;
+		std::vector<BrainBatch> batches;
+		std::vector<CognitiveSystems::BatchWorkspace> workspaces;
+	};
+}
@@ -0,0 +1,500 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <limits>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "CognitiveSystem.hpp"
+#include "Entities.hpp"
+#include "MappedFile.hpp"
+#include "ModelFile.hpp"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace Entities {
+	/*! Every column of a world, slots included, in the order they are stored in a snapshot. */
+	struct WorldColumns {
+		static constexpr size_t NUMBER = 22;
+
+		template<class WorldType, class Visitor>
+		static void forEach(WorldType& world, Visitor&& visitor) {
+			visitor(world.slots);
+			visitor(world.freeSlots);
+			auto& worms = world.worms;
+			visitor(worms.entities);
+			visitor(worms.x);
+			visitor(worms.y);
+			visitor(worms.velocityX);
+			visitor(worms.velocityY);
+			visitor(worms.health);
+			visitor(worms.maxHealth);
+			visitor(worms.regenerationSpeed);
+			visitor(worms.speed);
+			visitor(worms.damage);
+			visitor(worms.energy);
+			visitor(worms.brain);
+			auto& food = world.food;
+			visitor(food.entities);
+			visitor(food.x);
+			visitor(food.y);
+			visitor(food.nutrition);
+			visitor(food.foodType);
+			auto& walls = world.walls;
+			visitor(walls.entities);
+			visitor(walls.x);
+			visitor(walls.y);
+		}
+
+		/*! Checks that the tables and the slots of a world whose columns were replaced agree, and counts its entities again. */
+		static void validate(World& world) {
+			const auto& worms = world.worms;
+			const auto& food = world.food;
+			const auto& walls = world.walls;
+			if (!haveSize(worms.size(), worms.x, worms.y, worms.velocityX, worms.velocityY, worms.health, worms.maxHealth,
+						  worms.regenerationSpeed, worms.speed, worms.damage, worms.energy, worms.brain)
+				|| !haveSize(food.size(), food.x, food.y, food.nutrition, food.foodType)
+				|| !haveSize(walls.size(), walls.x, walls.y))
+				throw std::runtime_error("World: columns of a table have different lengths.");
+
+			const size_t entitiesNumber = worms.size() + food.size() + walls.size();
+			if (entitiesNumber + world.freeSlots.size() != world.slots.size())
+				throw std::runtime_error("World: slots don't match the tables.");
+			for (const auto index : world.freeSlots) {
+				if (index >= world.slots.size())
+					throw std::runtime_error("World: slots don't match the tables.");
+			}
+			checkSlots(world, worms.entities, Kind::Worm);
+			checkSlots(world, food.entities, Kind::Food);
+			checkSlots(world, walls.entities, Kind::Wall);
+			world.entitiesNumber = entitiesNumber;
+		}
+
+	private:
+		template<class... Columns>
+		static bool haveSize(size_t size, const Columns&... columns) noexcept {
+			return ((columns.size() == size) && ...);
+		}
+
+		static void checkSlots(const World& world, const std::vector<Entity>& entities, Kind kind) {
+			for (size_t row = 0; row < entities.size(); ++row) {
+				const auto entity = entities[row];
+				if (entity.index >= world.slots.size())
+					throw std::runtime_error("World: slots don't match the tables.");
+				const auto& slot = world.slots[entity.index];
+				if (slot.generation != entity.generation || slot.kind != kind || slot.row != row)
+					throw std::runtime_error("World: slots don't match the tables.");
+			}
+		}
+	};
+}
+
+/*!
+* Binary snapshot of a world and of the brains of its worms, to resume a simulation after a crash or preemption.
+*
+* Layout (little-endian):
+*   Header                            56 bytes, see Snapshot::Header
+*   ColumnRecord[columnsNumber]       24 bytes each: offset, length and element size of every column of the world
+*   LayerRecord[layersNumber]         24 bytes each: brain, shape, neuron type and offset of the weights of a layer
+*   columns and weights               raw arrays, each starting on a CACHE_LINE_SIZE boundary
+*
+* Columns are the world's own vectors (see WorldColumns), so writing is a memcpy per column and restoring maps the file
+* and copies every column straight into its vector. The checksum covers everything after the header, as in ModelFile.
+*/
+namespace Entities::Snapshot {
+	using Brain = CognitiveSystems::NeuralNetwork;
+
+	constexpr char MAGIC[8] = { 'W', 'S', 'N', 'A', 'P', 'S', 'H', 'T' };
+	constexpr std::uint32_t VERSION = 1;
+
+	struct Header {
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t byteOrder;
+		std::uint64_t tick;
+		std::uint32_t columnsNumber;
+		std::uint32_t brainsNumber;
+		std::uint32_t layersNumber;
+		/*! Activations::IDENTIFIER of the brains. */
+		std::uint32_t activation;
+		std::uint64_t payloadSize;
+		std::uint64_t checksum;
+	};
+
+	struct ColumnRecord {
+		std::uint64_t offset;
+		std::uint64_t count;
+		std::uint32_t elementSize;
+		std::uint32_t reserved;
+	};
+
+	struct LayerRecord {
+		std::uint32_t brain;
+		std::uint32_t rows;
+		std::uint32_t cols;
+		/*! CognitiveSystems::NeuronType of the layer. */
+		std::uint32_t type;
+		std::uint64_t offset;
+	};
+
+	static_assert(sizeof(Header) == 56 && sizeof(ColumnRecord) == 24 && sizeof(LayerRecord) == 24,
+				  "Snapshot structures must not have padding.");
+
+	/*!
+	* Writes the file next to `path` first, flushes it to the disk and then renames it over `path`, flushing the rename too.
+	* A crash of the process or a power loss at any point leaves either the previous snapshot or the new one, never a torn file.
+	*/
+	inline void writeFile(const std::filesystem::path& path, std::span<const std::byte> file) {
+		auto temporary = path;
+		temporary += ".tmp";
+		const auto fail = [&] {
+			throw std::runtime_error("Cannot write snapshot " + temporary.string());
+		};
+#ifdef _WIN32
+		const HANDLE handle = CreateFileW(temporary.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (handle == INVALID_HANDLE_VALUE)
+			fail();
+		bool written = true;
+		for (size_t offset = 0; written && offset < file.size();) {
+			const DWORD chunk = static_cast<DWORD>(std::min<size_t>(file.size() - offset, std::numeric_limits<DWORD>::max()));
+			DWORD done = 0;
+			written = WriteFile(handle, file.data() + offset, chunk, &done, nullptr) && done != 0;
+			offset += done;
+		}
+		written = written && FlushFileBuffers(handle);
+		CloseHandle(handle);
+		// MOVEFILE_WRITE_THROUGH returns only once the rename is on the disk.
+		if (!written || !MoveFileExW(temporary.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+			fail();
+#else
+		const int descriptor = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (descriptor < 0)
+			fail();
+		bool written = true;
+		for (size_t offset = 0; written && offset < file.size();) {
+			const auto done = ::write(descriptor, file.data() + offset, file.size() - offset);
+			written = done > 0 || (done < 0 && errno == EINTR);
+			offset += done > 0 ? static_cast<size_t>(done) : 0;
+		}
+		written = written && ::fsync(descriptor) == 0;
+		if (::close(descriptor) != 0 || !written)
+			fail();
+		std::filesystem::rename(temporary, path);
+		// The rename is an entry of the directory, which has to be flushed as well.
+		auto directory = path.parent_path();
+		if (directory.empty())
+			directory = ".";
+		const int directoryDescriptor = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+		if (directoryDescriptor >= 0) {
+			::fsync(directoryDescriptor);
+			::close(directoryDescriptor);
+		}
+#endif
+	}
+
+	/*!
+	* A world and the weights of its brains at one tick, copied out of the simulation so that it can be written while
+	* the simulation goes on. Capturing again reuses the memory of the previous capture, so after the first one
+	* it costs a memcpy of every column.
+	*/
+	class State {
+	public:
+		void capture(const World& world, std::span<const Brain* const> brains, std::uint64_t tick) {
+			this->world = world;
+			this->tick = tick;
+			layers.clear();
+			weights.clear();
+			for (size_t b = 0; b < brains.size(); ++b) {
+				for (const auto& layer : brains[b]->getLayers()) {
+					const auto& layerWeights = layer.getWeights();
+					layers.push_back({ static_cast<std::uint32_t>(b), static_cast<std::uint32_t>(layerWeights.rows()),
+									   static_cast<std::uint32_t>(layerWeights.cols()), static_cast<std::uint32_t>(layer.getNeuronType()), 0 });
+					weights.insert(weights.end(), layerWeights.getData(), layerWeights.getData() + layerWeights.size());
+				}
+			}
+			brainsNumber = brains.size();
+		}
+
+		/*! Lays the snapshot out in `file`, which keeps its capacity between calls. */
+		void serialize(std::vector<std::byte>& file) const {
+			using ::NeuralNetwork::ModelFile::alignToCacheLine;
+
+			std::array<ColumnRecord, WorldColumns::NUMBER> columns;
+			size_t offset = alignToCacheLine(sizeof(Header) + columns.size() * sizeof(ColumnRecord) + layers.size() * sizeof(LayerRecord));
+			size_t c = 0;
+			WorldColumns::forEach(world, [&](const auto& column) {
+				using T = typename std::decay_t<decltype(column)>::value_type;
+				columns[c++] = { offset, column.size(), static_cast<std::uint32_t>(sizeof(T)), 0 };
+				offset = alignToCacheLine(offset + column.size() * sizeof(T));
+			});
+			const size_t weightsOffset = offset;
+			for (const auto& layer : layers) {
+				offset = alignToCacheLine(offset + size_t(layer.rows) * layer.cols * sizeof(float));
+			}
+
+			file.assign(offset, std::byte{ 0 });
+			std::memcpy(file.data() + sizeof(Header), columns.data(), columns.size() * sizeof(ColumnRecord));
+			c = 0;
+			WorldColumns::forEach(world, [&](const auto& column) {
+				using T = typename std::decay_t<decltype(column)>::value_type;
+				if (!column.empty())
+					std::memcpy(file.data() + columns[c].offset, column.data(), column.size() * sizeof(T));
+				++c;
+			});
+
+			auto* records = file.data() + sizeof(Header) + columns.size() * sizeof(ColumnRecord);
+			const float* layerWeights = weights.data();
+			offset = weightsOffset;
+			for (size_t l = 0; l < layers.size(); ++l) {
+				auto record = layers[l];
+				record.offset = offset;
+				std::memcpy(records + l * sizeof(LayerRecord), &record, sizeof(LayerRecord));
+				const size_t count = size_t(record.rows) * record.cols;
+				std::memcpy(file.data() + offset, layerWeights, count * sizeof(float));
+				layerWeights += count;
+				offset = alignToCacheLine(offset + count * sizeof(float));
+			}
+
+			Header header;
+			std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+			header.version = VERSION;
+			header.byteOrder = ::NeuralNetwork::ModelFile::BYTE_ORDER_MARK;
+			header.tick = tick;
+			header.columnsNumber = static_cast<std::uint32_t>(columns.size());
+			header.brainsNumber = static_cast<std::uint32_t>(brainsNumber);
+			header.layersNumber = static_cast<std::uint32_t>(layers.size());
+			header.activation = Brain::Activation::IDENTIFIER;
+			header.payloadSize = file.size() - sizeof(Header);
+			header.checksum = ::NeuralNetwork::ModelFile::checksum(file.data() + sizeof(Header), header.payloadSize);
+			std::memcpy(file.data(), &header, sizeof(Header));
+		}
+
+		std::uint64_t getTick() const noexcept {
+			return tick;
+		}
+
+	private:
+		World world;
+		std::uint64_t tick = 0;
+		size_t brainsNumber = 0;
+		std::vector<LayerRecord> layers;
+		std::vector<float> weights;
+	};
+
+	inline void write(const std::filesystem::path& path, const World& world, std::span<const Brain* const> brains, std::uint64_t tick) {
+		State state;
+		state.capture(world, brains, tick);
+		std::vector<std::byte> file;
+		state.serialize(file);
+		writeFile(path, file);
+	}
+
+	struct Restored {
+		std::uint64_t tick = 0;
+		/*! Brains in the order they were saved, i.e. by the index in the `brain` column of the worms. */
+		std::vector<Brain> brains;
+	};
+
+	/*!
+	* Maps a snapshot and copies its columns into the world, which is replaced only if the whole snapshot is valid.
+	* Brains are created with the saved topologies and weights.
+	*/
+	inline Restored restore(const std::filesystem::path& path, World& world, bool verifyChecksum = true) {
+		const ::NeuralNetwork::MappedFile file(path);
+		const auto* data = file.getData();
+		Header header;
+		if (file.size() < sizeof(Header))
+			throw std::runtime_error("Snapshot is truncated.");
+		std::memcpy(&header, data, sizeof(Header));
+		if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0)
+			throw std::runtime_error("Not a snapshot.");
+		if (header.byteOrder != ::NeuralNetwork::ModelFile::BYTE_ORDER_MARK)
+			throw std::runtime_error("Snapshot was written on a machine with a different byte order.");
+		if (header.version != VERSION)
+			throw std::runtime_error("Unsupported snapshot version " + std::to_string(header.version) + ".");
+		if (header.columnsNumber != WorldColumns::NUMBER)
+			throw std::runtime_error("Snapshot has a different number of columns.");
+		const size_t recordsSize = size_t(header.columnsNumber) * sizeof(ColumnRecord) + size_t(header.layersNumber) * sizeof(LayerRecord);
+		if (header.payloadSize != file.size() - sizeof(Header) || recordsSize > header.payloadSize)
+			throw std::runtime_error("Snapshot is truncated.");
+		if (verifyChecksum && ::NeuralNetwork::ModelFile::checksum(data + sizeof(Header), header.payloadSize) != header.checksum)
+			throw std::runtime_error("Snapshot checksum mismatch.");
+		if (header.brainsNumber != 0 && header.activation != Brain::Activation::IDENTIFIER)
+			throw std::runtime_error("Snapshot was saved from brains with a different activation function.");
+
+		const auto inFile = [&](std::uint64_t offset, std::uint64_t count, size_t elementSize) {
+			return offset <= file.size() && count <= (file.size() - offset) / elementSize;
+		};
+
+		std::array<ColumnRecord, WorldColumns::NUMBER> columns;
+		std::memcpy(columns.data(), data + sizeof(Header), columns.size() * sizeof(ColumnRecord));
+		World restored;
+		size_t c = 0;
+		WorldColumns::forEach(restored, [&](auto& column) {
+			using T = typename std::decay_t<decltype(column)>::value_type;
+			const auto& record = columns[c++];
+			if (record.elementSize != sizeof(T) || !inFile(record.offset, record.count, sizeof(T)))
+				throw std::runtime_error("Snapshot has a column that doesn't fit the world.");
+			column.resize(record.count);
+			if (record.count != 0)
+				std::memcpy(column.data(), data + record.offset, record.count * sizeof(T));
+		});
+		WorldColumns::validate(restored);
+
+		Restored result;
+		result.tick = header.tick;
+		result.brains.reserve(header.brainsNumber);
+		const auto* layerRecords = data + sizeof(Header) + columns.size() * sizeof(ColumnRecord);
+		std::vector<LayerRecord> layers(header.layersNumber);
+		if (!layers.empty())
+			std::memcpy(layers.data(), layerRecords, layers.size() * sizeof(LayerRecord));
+		for (size_t first = 0; first < layers.size();) {
+			size_t last = first;
+			while (last < layers.size() && layers[last].brain == layers[first].brain) {
+				++last;
+			}
+			if (layers[first].brain != result.brains.size() || last - first < 2)
+				throw std::runtime_error("Snapshot has layers that do not form brains.");
+
+			std::vector<int> hiddenLayers;
+			for (size_t l = first + 1; l + 1 < last; ++l) {
+				hiddenLayers.push_back(static_cast<int>(layers[l].rows));
+			}
+			auto& brain = result.brains.emplace_back(CognitiveSystems::Topology(static_cast<int>(layers[first].rows), std::move(hiddenLayers),
+																				static_cast<int>(layers[last - 1].rows)));
+			auto& brainLayers = brain.getModifiableLayers();
+			for (size_t l = first; l < last; ++l) {
+				const auto& record = layers[l];
+				auto& weights = brainLayers[l - first].getModifiableWeights();
+				if (record.rows != weights.rows() || record.cols != weights.cols()
+					|| record.type != static_cast<std::uint32_t>(brainLayers[l - first].getNeuronType())
+					|| !inFile(record.offset, weights.size(), sizeof(float)))
+					throw std::runtime_error("Snapshot has layers that do not form brains.");
+				std::memcpy(weights.getData(), data + record.offset, weights.size() * sizeof(float));
+			}
+			first = last;
+		}
+		if (result.brains.size() != header.brainsNumber)
+			throw std::runtime_error("Snapshot has layers that do not form brains.");
+
+		world = std::move(restored);
+		return result;
+	}
+
+	/*!
+	* Writes snapshots on a background thread. submit only captures the world into a State and returns;
+	* the previous capture may still be written meanwhile, the two buffers are swapped when the writer is done with it.
+	* When snapshots are submitted faster than they are written, only the latest one is written next.
+	*/
+	class Writer {
+	public:
+		explicit Writer(std::filesystem::path path) : path(std::move(path)), thread([this] { work(); }) {}
+
+		Writer(const Writer&) = delete;
+		Writer& operator=(const Writer&) = delete;
+
+		/*! Writes what was submitted and not written yet before returning. */
+		~Writer() {
+			{
+				std::lock_guard lock(mutex);
+				stopping = true;
+			}
+			wakeUp.notify_one();
+			thread.join();
+		}
+
+		/*! Captures the world and its brains for the background thread. Rethrows the error of a failed write. */
+		void submit(const World& world, std::span<const Brain* const> brains, std::uint64_t tick) {
+			{
+				std::lock_guard lock(mutex);
+				if (error)
+					std::rethrow_exception(std::exchange(error, nullptr));
+				pending.capture(world, brains, tick);
+				hasPending = true;
+			}
+			wakeUp.notify_one();
+		}
+
+		/*! Waits until everything submitted is written. Rethrows the error of a failed write. */
+		void wait() {
+			std::unique_lock lock(mutex);
+			finished.wait(lock, [this] { return !hasPending && !writing; });
+			if (error)
+				std::rethrow_exception(std::exchange(error, nullptr));
+		}
+
+		size_t getWrittenNumber() const {
+			std::lock_guard lock(mutex);
+			return writtenNumber;
+		}
+
+	private:
+		void work() {
+			std::unique_lock lock(mutex);
+			while (true) {
+				wakeUp.wait(lock, [this] { return stopping || hasPending; });
+				if (!hasPending)
+					return;
+				std::swap(pending, current);
+				hasPending = false;
+				writing = true;
+				lock.unlock();
+				std::exception_ptr writeError;
+				try {
+					current.serialize(file);
+					writeFile(path, file);
+				}
+				catch (...) {
+					writeError = std::current_exception();
+				}
+				lock.lock();
+				if (writeError)
+					error = writeError;
+				else
+					++writtenNumber;
+				writing = false;
+				finished.notify_all();
+			}
+		}
+
+	private:
+		std::filesystem::path path;
+		mutable std::mutex mutex;
+		std::condition_variable wakeUp;
+		std::condition_variable finished;
+		/*! Captured by submit. */
+		State pending;
+		/*! Being written by the background thread. */
+		State current;
+		std::vector<std::byte> file;
+		bool hasPending = false;
+		bool writing = false;
+		bool stopping = false;
+		size_t writtenNumber = 0;
+		std::exception_ptr error;
+		std::thread thread;
+	};
+}
@@ -43,6 +43,9 @@ namespace BodySystems {
 	public:
 		/*! Walks through all objects on the map and returns only some of them that are considered as visible. */
 		virtual const std::vector<Positioning::Object2D*> analyze(const Positioning::Coordinates& currentPosition, std::vector<Positioning::Object2D>& objects) = 0;
+
+		/*! Same, but only looks at the objects near the current position, found through the spatial grid of the map. */
+		virtual const std::vector<Positioning::Object2D*> analyze(const Positioning::Coordinates& currentPosition, const Positioning::SpatialGrid& grid) = 0;
 		virtual ~ISensorSystem() = default;
 	};
 
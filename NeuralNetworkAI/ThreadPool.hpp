@@ -0,0 +1,122 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Utils {
+	/*!
+	* Fixed set of worker threads that execute indexed tasks.
+	* `run` hands out task indices dynamically, so the order tasks are executed in is not fixed;
+	* callers that need deterministic results write every task's output into its own slot
+	* and combine the slots in index order afterwards.
+	*/
+	class ThreadPool final {
+	public:
+		/*! `threadsNumber` counts the calling thread too, so ThreadPool(1) runs everything inline. */
+		explicit ThreadPool(size_t threadsNumber = std::thread::hardware_concurrency()) {
+			if (threadsNumber == 0) {
+				threadsNumber = 1;
+			}
+			workers.reserve(threadsNumber - 1);
+			for (size_t i = 1; i < threadsNumber; ++i) {
+				workers.emplace_back([this] { work(); });
+			}
+		}
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		~ThreadPool() {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stopping = true;
+			}
+			wakeUp.notify_all();
+			for (auto& worker : workers) {
+				worker.join();
+			}
+		}
+
+		size_t getThreadsNumber() const noexcept {
+			return workers.size() + 1;
+		}
+
+		/*!
+		* Calls task(i) for every i in [0, tasksNumber) on the pool and the calling thread
+		* and returns when all of them are finished. The first exception thrown by a task is rethrown here.
+		*/
+		void run(size_t tasksNumber, const std::function<void(size_t)>& task) {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				currentTask = &task;
+				tasksCount = tasksNumber;
+				nextTask.store(0, std::memory_order_relaxed);
+				pendingWorkers = workers.size();
+				error = nullptr;
+				++generation;
+			}
+			wakeUp.notify_all();
+
+			execute();
+
+			std::unique_lock<std::mutex> lock(mutex);
+			finished.wait(lock, [this] { return pendingWorkers == 0; });
+			currentTask = nullptr;
+			if (error) {
+				std::rethrow_exception(error);
+			}
+		}
+
+	private:
+		void work() {
+			size_t seenGeneration = 0;
+			while (true) {
+				std::unique_lock<std::mutex> lock(mutex);
+				wakeUp.wait(lock, [&] { return stopping || generation != seenGeneration; });
+				if (stopping) {
+					return;
+				}
+				seenGeneration = generation;
+				lock.unlock();
+
+				execute();
+
+				lock.lock();
+				if (--pendingWorkers == 0) {
+					finished.notify_all();
+				}
+			}
+		}
+
+		void execute() {
+			for (size_t index = nextTask.fetch_add(1); index < tasksCount; index = nextTask.fetch_add(1)) {
+				try {
+					(*currentTask)(index);
+				}
+				catch (...) {
+					std::lock_guard<std::mutex> lock(mutex);
+					if (!error) {
+						error = std::current_exception();
+					}
+				}
+			}
+		}
+
+	private:
+		std::vector<std::thread> workers;
+		std::mutex mutex;
+		std::condition_variable wakeUp;
+		std::condition_variable finished;
+		const std::function<void(size_t)>* currentTask = nullptr;
+		size_t tasksCount = 0;
+		std::atomic<size_t> nextTask = 0;
+		size_t pendingWorkers = 0;
+		size_t generation = 0;
+		std::exception_ptr error;
+		bool stopping = false;
+	};
+}
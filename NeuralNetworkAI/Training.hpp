@@ -0,0 +1,142 @@
+#pragma once
+#include <vector>
+#include <limits>
+#include <numeric>
+#include <chrono>
+#include <functional>
+#include <stdexcept>
+#include "CognitiveSystem.hpp"
+
+namespace CognitiveSystems {
+    /*! What happened during one epoch of BasicTrainer::train. */
+    struct EpochReport {
+        size_t epoch = 0;
+        /*! Mean squared error of every output on the training set, measured while training. */
+        std::vector<float> trainingErrors;
+        float trainingLoss = 0;
+        /*! Loss on the validation set after the epoch; the training loss when there is no validation set. */
+        float validationLoss = 0;
+        bool improved = false;
+        size_t epochsWithoutImprovement = 0;
+        double seconds = 0;
+    };
+
+    struct TrainingOptions {
+        size_t maxEpochs = 100;
+        /*! Training stops after this many epochs in a row without improvement of the validation loss. */
+        size_t patience = 10;
+        /*! Smallest decrease of the validation loss that counts as an improvement. */
+        float minImprovement = 0;
+        /*! Training stops as soon as the validation loss is at or below this value. */
+        float targetLoss = 0;
+        /*! Put the weights of the best epoch back into the network when training ends. */
+        bool restoreBestWeights = true;
+        /*! Options of the parallel learn running the epochs; its onEpoch is set by the trainer. */
+        ParallelTrainingOptions parallel;
+        /*! Called after every epoch, e.g. to log the losses. */
+        std::function<void(const EpochReport&)> onEpoch;
+    };
+
+    struct TrainingResult {
+        size_t epochs = 0;
+        size_t bestEpoch = 0;
+        float bestValidationLoss = std::numeric_limits<float>::infinity();
+        bool stoppedEarly = false;
+        bool reachedTarget = false;
+        double seconds = 0;
+    };
+
+    /*!
+    * Training driver: runs epochs of parallel learn, measures the loss on a held-out validation set
+    * after each of them and stops once it converged, i.e. the validation loss has not improved for
+    * `patience` epochs or reached `targetLoss`. All epochs are one learn call, checked from its onEpoch,
+    * so the thread pool and shard buffers are created once per run. The best weights are kept in buffers
+    * allocated once, so tracking them costs a copy of the weights per improvement and nothing else.
+    */
+    template<Activations::Activation ActivationFunction>
+    class BasicTrainer {
+    public:
+        using Network = BasicNeuralNetwork<ActivationFunction>;
+
+        explicit BasicTrainer(TrainingOptions options) : options(std::move(options)) {}
+
+        const TrainingOptions& getOptions() const noexcept {
+            return options;
+        }
+
+        TrainingResult train(Network& network, const ::NeuralNetwork::FlatDataSet& training,
+                             const ::NeuralNetwork::FlatDataSet& validation, const float learningRate) {
+            if (training.empty())
+                throw std::runtime_error("training set is empty");
+
+            TrainingResult result;
+            EpochReport report;
+            const auto start = std::chrono::steady_clock::now();
+            auto parallel = options.parallel;
+            parallel.onEpoch = [&](size_t epoch, const std::vector<float>& errors) {
+                report.epoch = epoch;
+                report.trainingErrors = errors;
+                report.trainingLoss = meanOf(errors);
+                report.validationLoss = validation.empty() ? report.trainingLoss : meanOf(network.evaluate(validation));
+                report.improved = report.validationLoss < result.bestValidationLoss - options.minImprovement;
+                report.epochsWithoutImprovement = report.improved ? 0 : report.epochsWithoutImprovement + 1;
+                report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                result.epochs = epoch;
+
+                if (report.improved) {
+                    result.bestEpoch = epoch;
+                    result.bestValidationLoss = report.validationLoss;
+                    if (options.restoreBestWeights)
+                        saveWeights(network);
+                }
+                if (options.onEpoch)
+                    options.onEpoch(report);
+
+                if (report.validationLoss <= options.targetLoss) {
+                    result.reachedTarget = true;
+                    return false;
+                }
+                if (report.epochsWithoutImprovement >= options.patience) {
+                    result.stoppedEarly = true;
+                    return false;
+                }
+                return true;
+            };
+            network.learn(training, options.maxEpochs, learningRate, parallel);
+
+            if (options.restoreBestWeights && result.bestEpoch != result.epochs && result.bestEpoch != 0)
+                restoreWeights(network);
+            result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            return result;
+        }
+
+    private:
+        static float meanOf(const std::vector<float>& errors) {
+            return errors.empty() ? 0.f : std::accumulate(errors.begin(), errors.end(), 0.f) / errors.size();
+        }
+
+        void saveWeights(const Network& network) {
+            const auto& layers = network.getLayers();
+            bestWeights.resize(layers.size());
+            for (size_t l = 0; l < layers.size(); ++l) {
+                const auto& weights = layers[l].getWeights();
+                bestWeights[l].resize(weights.rows(), weights.cols());
+                std::copy(weights.getData(), weights.getData() + weights.size(), bestWeights[l].getData());
+            }
+        }
+
+        void restoreWeights(Network& network) const {
+            auto& layers = network.getModifiableLayers();
+            for (size_t l = 0; l < layers.size(); ++l) {
+                auto& weights = layers[l].getModifiableWeights();
+                std::copy(bestWeights[l].getData(), bestWeights[l].getData() + bestWeights[l].size(), weights.getData());
+            }
+        }
+
+    private:
+        TrainingOptions options;
+        std::vector<::NeuralNetwork::Matrix<float>> bestWeights;
+    };
+
+    using Trainer = BasicTrainer<Activations::Sigmoid>;
+}
@@ -1,23 +1,57 @@
 #include <iostream>
+#include <charconv>
 #include <vector>
 #include <memory>
 #include <cmath>
 #include <chrono>
 #include <ranges>
+#include <string>
+#include <filesystem>
+#include <stdexcept>
 #include "Objects.hpp"
+#include "Entities.hpp"
+#include "Headless.hpp"
 
 using std::vector;
 using std::unique_ptr;
 
+/*!
+* Simulation keeps its worms, food and walls in an entity store: a vector<Object2D> would slice them.
+*/
 class Simulation final {
 public:
-	void addObject(Positioning::Object2D& object) {
-		_objects.push_back(object);
+	Entities::Entity addWorm(Positioning::Coordinates coords, const Entities::WormTraits& traits) {
+		return _world.createWorm(coords, traits);
+	}
+
+	Entities::Entity addFood(Positioning::Coordinates coords, int nutrition) {
+		return _world.createFood(coords, nutrition);
+	}
+
+	Entities::Entity addWall(Positioning::Coordinates coords) {
+		return _world.createWall(coords);
+	}
+
+	Entities::World& getWorld() noexcept {
+		return _world;
+	}
+
+	/*!
+	* Populates the world from the options, or restores it from a snapshot when `resumeFrom` is not empty,
+	* and runs it headless, see Entities::HeadlessRunner.
+	*/
+	Entities::HeadlessReport runHeadless(const Entities::HeadlessOptions& options, Entities::HeadlessRunner::ReportFunction report,
+										 const std::filesystem::path& resumeFrom = {}) {
+		Entities::HeadlessRunner runner(options, std::move(report));
+		if (resumeFrom.empty())
+			runner.populate(_world);
+		else
+			runner.resume(resumeFrom, _world);
+		return runner.run(_world);
 	}
 
 private:
-	vector<Positioning::Object2D> _objects;
-	Objects::Worm worm;
+	Entities::World _world;
 };
 
 #pragma region experiments
@@ -58,27 +92,75 @@ std::vector<Test> testVecGen() {
 #pragma endregion
 
 #include "CognitiveSystem.hpp"
+void printReport(const Entities::HeadlessReport& report) {
+	std::cout << "tick " << report.tick
+		<< " | simulated " << report.simulatedSeconds << " s"
+		<< " | " << static_cast<std::uint64_t>(report.ticksPerSecond) << " ticks/s"
+		<< " | " << static_cast<std::uint64_t>(report.agentsPerSecond) << " agents/s"
+		<< " | worms " << report.worms << ", food " << report.food
+		<< " | eaten " << report.statistics.eaten << ", died " << report.statistics.died
+		<< " | memory " << report.residentBytes / (1024 * 1024) << " MiB" << std::endl;
+}
+
+/*! Parses the value of a count option; unlike std::stoull, rejects signs, overflow and trailing characters instead of wrapping. */
+template<typename Count>
+void parseCount(const std::string& argument, const std::string& value, Count& count) {
+	const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), count);
+	if (error != std::errc() || end != value.data() + value.size())
+		throw std::runtime_error(argument + " requires a non-negative integer, got " + value + ".");
+}
+
 /*!
-* The main function that is actually like a life cycle.
+* The main function that is actually like a life cycle: runs a headless simulation.
+* Usage: NeuralNetworkAI [--ticks N] [--seed N] [--worms N] [--food N] [--walls N] [--world-size N]
+*                        [--timestep SECONDS] [--threads N] [--report-every TICKS]
+*                        [--snapshot PATH] [--snapshot-every TICKS] [--resume SNAPSHOT]
 */
 int main(int argc, char** argv) {
-	std::vector<int> vec{ 1,2,3,4,5,6,7,8,9,10 };
-	std::vector<int> vec2{ 0,1,2,3,4,5,6,7,8,9 };
-	//std::vector<int> resvec;
+	Entities::HeadlessOptions options;
+	std::filesystem::path resumeFrom;
+	try {
+		for (int i = 1; i < argc; ++i) {
+			const std::string argument = argv[i];
+			if (i + 1 >= argc)
+				throw std::runtime_error(argument + " requires a value.");
+			const std::string value = argv[++i];
+			if (argument == "--ticks")
+				parseCount(argument, value, options.ticks);
+			else if (argument == "--seed")
+				parseCount(argument, value, options.seed);
+			else if (argument == "--worms")
+				parseCount(argument, value, options.worms);
+			else if (argument == "--food")
+				parseCount(argument, value, options.food);
+			else if (argument == "--walls")
+				parseCount(argument, value, options.walls);
+			else if (argument == "--world-size")
+				options.worldSize = std::stoi(value);
+			else if (argument == "--timestep")
+				options.timestep = std::stod(value);
+			else if (argument == "--threads")
+				parseCount(argument, value, options.threadsNumber);
+			else if (argument == "--report-every")
+				parseCount(argument, value, options.reportEvery);
+			else if (argument == "--snapshot")
+				options.snapshotPath = value;
+			else if (argument == "--snapshot-every")
+				parseCount(argument, value, options.snapshotEvery);
+			else if (argument == "--resume")
+				resumeFrom = value;
+			else
+				throw std::runtime_error("Unknown argument " + argument + ".");
+		}
 
-	for (auto iter = vec.rbegin() + 1; iter != vec.rend(); ++iter) {
-		std::cout << *iter << ' ';
+		Simulation simulation;
+		const auto result = simulation.runHeadless(options, printReport, resumeFrom);
+		std::cout << "finished in " << result.elapsedSeconds << " s: ";
+		printReport(result);
+	}
+	catch (const std::exception& error) {
+		std::cerr << error.what() << std::endl;
+		return 1;
 	}
-	
-
-
-	/*vector<int> vec;
-	Worm worm;
-	Object2D* obj = &worm;
-	
-	cout << "worm is a type of " << typeid(worm).name() << endl;
-	cout << "obj is a type of " << typeid(*obj).name() << endl;
-
-	cout << "obj is a type of " << typeid(*obj).name() << endl;*/
 	return 0;
 }
@@ -0,0 +1,204 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace Benchmarks {
+	constexpr int NAME_WIDTH = 56;
+
+	/*! Incremented by the replaced global operator new in benchmarks.cpp. */
+	extern std::atomic<size_t> allocationsCount;
+
+	struct Result {
+		std::string name;
+		size_t iterations = 0;
+		double nsPerOp = 0;
+		/*! Samples (network inputs, visible objects checks, ...) processed per second; 0 if not meaningful. */
+		double samplesPerSecond = 0;
+		double allocationsPerOp = 0;
+	};
+
+	namespace Detail {
+		inline volatile char sink = 0;
+	}
+
+	/*! Keeps the compiler from throwing away results of benchmarked code. */
+	template<class T>
+	inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+		asm volatile("" : : "r"(&value) : "memory");
+#else
+		Detail::sink = *reinterpret_cast<const volatile char*>(&value);
+#endif
+	}
+
+	/*!
+	* Runs benchmarks and collects their results. Every benchmark is run until it takes `minTime`
+	* seconds, `REPETITIONS` times, and the fastest repetition is reported: slower ones are noise
+	* from the rest of the system, not properties of the code.
+	*/
+	class Runner {
+	public:
+		static constexpr int REPETITIONS = 5;
+
+		Runner(std::string filter, double minTime) : filter(std::move(filter)), minTime(minTime) {}
+
+		/*! `operation` is one op; `samplesPerOp` is how many samples it processes. */
+		void run(const std::string& name, size_t samplesPerOp, const std::function<void()>& operation) {
+			if (!filter.empty() && name.find(filter) == std::string::npos)
+				return;
+
+			operation();
+
+			size_t iterations = 1;
+			while (true) {
+				const double seconds = measure(iterations, operation);
+				if (seconds >= minTime / REPETITIONS || iterations >= (size_t(1) << 30))
+					break;
+				const double estimate = seconds > 0 ? iterations * (minTime / REPETITIONS) / seconds : iterations * 10.0;
+				iterations = std::max(iterations * 2, static_cast<size_t>(std::min(estimate * 1.2, iterations * 100.0)));
+			}
+
+			double best = measure(iterations, operation);
+			const size_t allocationsBefore = allocationsCount;
+			for (int r = 1; r < REPETITIONS; ++r) {
+				best = std::min(best, measure(iterations, operation));
+			}
+			const size_t allocations = allocationsCount - allocationsBefore;
+
+			Result result;
+			result.name = name;
+			result.iterations = iterations;
+			result.nsPerOp = best * 1e9 / iterations;
+			result.samplesPerSecond = samplesPerOp > 0 && best > 0 ? samplesPerOp * iterations / best : 0;
+			result.allocationsPerOp = static_cast<double>(allocations) / (iterations * (REPETITIONS - 1));
+			print(result);
+			results.push_back(std::move(result));
+		}
+
+		const std::vector<Result>& getResults() const noexcept {
+			return results;
+		}
+
+		static void printHeader() {
+			std::cout << std::left << std::setw(NAME_WIDTH) << "benchmark" << std::right << std::setw(14) << "ns/op"
+					  << std::setw(16) << "samples/s" << std::setw(12) << "allocs/op" << '\n';
+		}
+
+	private:
+		static double measure(size_t iterations, const std::function<void()>& operation) {
+			const auto start = std::chrono::steady_clock::now();
+			for (size_t i = 0; i < iterations; ++i) {
+				operation();
+			}
+			return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		static void print(const Result& result) {
+			std::cout << std::left << std::setw(NAME_WIDTH) << result.name << std::right << std::fixed << std::setprecision(1)
+					  << std::setw(14) << result.nsPerOp << std::setw(16) << std::setprecision(0) << result.samplesPerSecond
+					  << std::setw(12) << std::setprecision(2) << result.allocationsPerOp << std::endl;
+		}
+
+	private:
+		std::string filter;
+		double minTime;
+		std::vector<Result> results;
+	};
+
+	/*! One benchmark object per line, so readJson does not need a full JSON parser. */
+	inline void writeJson(const std::string& path, const std::vector<Result>& results) {
+		std::ofstream stream(path);
+		if (!stream)
+			throw std::runtime_error("Cannot write " + path);
+		stream << std::setprecision(10) << "{\"benchmarks\": [\n";
+		for (size_t i = 0; i < results.size(); ++i) {
+			const auto& result = results[i];
+			stream << "  {\"name\": \"" << result.name << "\", \"iterations\": " << result.iterations
+				   << ", \"ns_per_op\": " << result.nsPerOp << ", \"samples_per_second\": " << result.samplesPerSecond
+				   << ", \"allocations_per_op\": " << result.allocationsPerOp << '}' << (i + 1 < results.size() ? "," : "") << '\n';
+		}
+		stream << "]}\n";
+	}
+
+	namespace Detail {
+		inline std::string findString(const std::string& line, const std::string& key) {
+			const auto keyPosition = line.find("\"" + key + "\"");
+			if (keyPosition == std::string::npos)
+				return {};
+			const auto begin = line.find('"', line.find(':', keyPosition) + 1);
+			const auto end = line.find('"', begin + 1);
+			return begin == std::string::npos || end == std::string::npos ? std::string() : line.substr(begin + 1, end - begin - 1);
+		}
+
+		inline double findNumber(const std::string& line, const std::string& key) {
+			const auto keyPosition = line.find("\"" + key + "\"");
+			if (keyPosition == std::string::npos)
+				return 0;
+			return std::strtod(line.c_str() + line.find(':', keyPosition) + 1, nullptr);
+		}
+	}
+
+	/*! Reads results written by writeJson. */
+	inline std::vector<Result> readJson(const std::string& path) {
+		std::ifstream stream(path);
+		if (!stream)
+			throw std::runtime_error("Cannot read " + path);
+		std::vector<Result> results;
+		std::string line;
+		while (std::getline(stream, line)) {
+			Result result;
+			result.name = Detail::findString(line, "name");
+			if (result.name.empty())
+				continue;
+			result.iterations = static_cast<size_t>(Detail::findNumber(line, "iterations"));
+			result.nsPerOp = Detail::findNumber(line, "ns_per_op");
+			result.samplesPerSecond = Detail::findNumber(line, "samples_per_second");
+			result.allocationsPerOp = Detail::findNumber(line, "allocations_per_op");
+			results.push_back(std::move(result));
+		}
+		return results;
+	}
+
+	/*!
+	* Prints the change of every benchmark present in both runs and returns the number of regressions:
+	* benchmarks that got slower by more than `threshold` (0.1 is 10%) or started to allocate more.
+	*/
+	inline int compare(const std::vector<Result>& baseline, const std::vector<Result>& current, double threshold) {
+		int regressions = 0;
+		std::cout << std::left << std::setw(NAME_WIDTH) << "benchmark" << std::right << std::setw(14) << "base ns/op"
+				  << std::setw(14) << "ns/op" << std::setw(10) << "change" << std::setw(14) << "allocs/op" << '\n';
+		for (const auto& result : current) {
+			const auto base = std::find_if(baseline.begin(), baseline.end(), [&](const Result& r) { return r.name == result.name; });
+			if (base == baseline.end()) {
+				std::cout << std::left << std::setw(NAME_WIDTH) << result.name << "  (new)\n";
+				continue;
+			}
+
+			const double change = base->nsPerOp > 0 ? result.nsPerOp / base->nsPerOp - 1 : 0;
+			const bool slower = change > threshold;
+			const bool allocatesMore = result.allocationsPerOp > base->allocationsPerOp + 1e-9;
+			regressions += slower || allocatesMore;
+
+			std::ostringstream allocations;
+			allocations << std::fixed << std::setprecision(2) << base->allocationsPerOp << "->" << result.allocationsPerOp;
+			std::cout << std::left << std::setw(NAME_WIDTH) << result.name << std::right << std::fixed << std::setprecision(1)
+					  << std::setw(14) << base->nsPerOp << std::setw(14) << result.nsPerOp
+					  << std::setw(9) << std::showpos << change * 100 << std::noshowpos << '%'
+					  << std::setw(14) << allocations.str()
+					  << (slower || allocatesMore ? "  REGRESSION" : change < -threshold ? "  improved" : "") << '\n';
+		}
+		return regressions;
+	}
+}
@@ -0,0 +1,617 @@
+/*!
+* Micro and macro benchmarks of both networks and of the sensor system.
+*
+* Besides the Visual Studio project, builds on Linux with:
+*   g++ -std=c++20 -O2 -INeuralNetworkModule -INeuralNetworkAI NeuralNetworkBenchmarks/benchmarks.cpp NeuralNetworkAI/PositioningSystem.cpp -pthread
+*
+* Usage:
+*   NeuralNetworkBenchmarks [--filter <substring>] [--min-time <seconds>] [--json <file>]
+*   NeuralNetworkBenchmarks --compare <baseline.json> <current.json> [--threshold <fraction>]
+* The compare mode exits with 1 if any benchmark got slower than the threshold (10% by default)
+* or does more allocations per op.
+* Built with -DNEURAL_NETWORK_PROFILING it also prints the per-layer profile of everything it ran
+* and writes it to the file given with --profile-json.
+*/
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Benchmark.hpp"
+#include "NeuralNetwork.hpp"
+#include "FixedNetwork.hpp"
+#include "Activations.hpp"
+#include "CognitiveSystem.hpp"
+#include "SensorSystem.hpp"
+#include "Food.hpp"
+#include "Bodies.hpp"
+#include "DigestiveSystem.hpp"
+#include "Entities.hpp"
+#include "Simulator.hpp"
+#include "ObjectPool.hpp"
+#include "Evolution.hpp"
+#include "Snapshot.hpp"
+
+namespace Benchmarks {
+	std::atomic<size_t> allocationsCount = 0;
+}
+
+namespace {
+	/*!
+	* Every form of operator new ends up here, aligned ones (AlignedAllocator, so Matrix and AlignedVector) included,
+	* so allocs/op covers them. The pointer returned by malloc is kept right before the block,
+	* so every form of operator delete frees it the same way.
+	*/
+	void* allocate(std::size_t size, std::size_t alignment) {
+		++Benchmarks::allocationsCount;
+#ifdef NEURAL_NETWORK_PROFILING
+		NeuralNetwork::Profiling::countAllocation();
+#endif
+		alignment = std::max(alignment, std::size_t(__STDCPP_DEFAULT_NEW_ALIGNMENT__));
+		void* block = std::malloc(size + alignment);
+		if (!block)
+			throw std::bad_alloc();
+		const auto address = (reinterpret_cast<std::uintptr_t>(block) + alignment) & ~(std::uintptr_t(alignment) - 1);
+		auto* pointer = reinterpret_cast<void*>(address);
+		static_cast<void**>(pointer)[-1] = block;
+		return pointer;
+	}
+
+	void deallocate(void* pointer) noexcept {
+		if (pointer)
+			std::free(static_cast<void**>(pointer)[-1]);
+	}
+}
+
+void* operator new(std::size_t size) {
+	return allocate(size, 0);
+}
+
+void* operator new[](std::size_t size) {
+	return allocate(size, 0);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+	return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+	return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* pointer) noexcept {
+	deallocate(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+	deallocate(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+	deallocate(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept {
+	deallocate(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept {
+	deallocate(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept {
+	deallocate(pointer);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept {
+	deallocate(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept {
+	deallocate(pointer);
+}
+
+namespace {
+	std::vector<float> randomSignals(size_t size, std::mt19937& random) {
+		std::uniform_real_distribution<float> distribution(0.f, 1.f);
+		std::vector<float> signals(size);
+		for (auto& signal : signals) {
+			signal = distribution(random);
+		}
+		return signals;
+	}
+
+	NeuralNetwork::Matrix<float> randomBatch(size_t rows, size_t cols, std::mt19937& random) {
+		std::uniform_real_distribution<float> distribution(0.f, 1.f);
+		NeuralNetwork::Matrix<float> batch(rows, cols);
+		for (size_t i = 0; i < batch.size(); ++i) {
+			batch.getData()[i] = distribution(random);
+		}
+		return batch;
+	}
+
+	std::string topologyName(const std::vector<int>& topology) {
+		std::string name;
+		for (int neurons : topology) {
+			name += (name.empty() ? "" : "x") + std::to_string(neurons);
+		}
+		return name;
+	}
+
+	NeuralNetwork::NeuralNetwork makeNetwork(const std::vector<int>& topology) {
+		switch (topology.size()) {
+		case 3:
+			return NeuralNetwork::NeuralNetwork({ topology[0], topology[1], topology[2] });
+		case 4:
+			return NeuralNetwork::NeuralNetwork({ topology[0], topology[1], topology[2], topology[3] });
+		default:
+			throw std::runtime_error("Unsupported benchmark topology.");
+		}
+	}
+
+	const std::vector<std::vector<int>> TOPOLOGIES = { { 8, 16, 4 }, { 64, 128, 64, 8 }, { 256, 256, 256, 16 } };
+	const std::vector<size_t> BATCH_SIZES = { 1, 16, 128 };
+
+	void layerConnectionBenchmarks(Benchmarks::Runner& runner) {
+		std::mt19937 random(1);
+		for (int size : { 16, 64, 256 }) {
+			NeuralNetwork::LayerConnection layer(size, size);
+			const auto inputs = randomSignals(size, random);
+			std::vector<float> outputs(size);
+			runner.run("LayerConnection_getOutputs/" + std::to_string(size) + "x" + std::to_string(size), 1, [&] {
+				layer.getOutputs(inputs, outputs);
+				Benchmarks::doNotOptimize(outputs);
+			});
+		}
+	}
+
+	template<class Activation>
+	void activationBenchmark(Benchmarks::Runner& runner, const std::string& name, const std::vector<float>& inputs) {
+		std::vector<float> values(inputs.size());
+		runner.run("Activation/" + name, values.size(), [&] {
+			std::copy(inputs.begin(), inputs.end(), values.begin());
+			Activation::activate(values.data(), values.size());
+			Benchmarks::doNotOptimize(values);
+		});
+	}
+
+	void activationBenchmarks(Benchmarks::Runner& runner) {
+		std::mt19937 random(6);
+		std::uniform_real_distribution<float> distribution(-8.f, 8.f);
+		std::vector<float> inputs(4096);
+		for (auto& input : inputs) {
+			input = distribution(random);
+		}
+		activationBenchmark<NeuralNetwork::Activations::Sigmoid>(runner, "sigmoid", inputs);
+		activationBenchmark<NeuralNetwork::Activations::FastSigmoid>(runner, "fast_sigmoid", inputs);
+		activationBenchmark<NeuralNetwork::Activations::Tanh>(runner, "tanh", inputs);
+		activationBenchmark<NeuralNetwork::Activations::ReLU>(runner, "relu", inputs);
+	}
+
+	void moduleNetworkBenchmarks(Benchmarks::Runner& runner) {
+		std::mt19937 random(2);
+		for (const auto& topology : TOPOLOGIES) {
+			const auto name = topologyName(topology);
+			auto network = makeNetwork(topology);
+			auto workspace = network.createWorkspace();
+			const auto inputs = randomSignals(topology.front(), random);
+			const auto expected = randomSignals(topology.back(), random);
+
+			runner.run("NeuralNetwork_feedForward/" + name, 1, [&] {
+				Benchmarks::doNotOptimize(network.feedForward(inputs, workspace));
+			});
+			runner.run("NeuralNetwork_backPropagation/" + name, 1, [&] {
+				network.feedForward(inputs, workspace);
+				network.backPropagation(workspace, expected, 0.01f);
+			});
+
+			for (size_t batchSize : BATCH_SIZES) {
+				const auto batch = randomBatch(batchSize, topology.front(), random);
+				const auto batchExpected = randomBatch(batchSize, topology.back(), random);
+				const auto suffix = name + "/batch" + std::to_string(batchSize);
+				NeuralNetwork::BatchWorkspace batchWorkspace;
+				runner.run("NeuralNetwork_feedForwardBatch/" + suffix, batchSize, [&] {
+					Benchmarks::doNotOptimize(network.feedForward(batch.view(), batchWorkspace));
+				});
+				runner.run("NeuralNetwork_trainBatch/" + suffix, batchSize, [&] {
+					network.trainBatch(batch, batchExpected, 0.01f);
+				});
+			}
+		}
+	}
+
+	void fixedNetworkBenchmarks(Benchmarks::Runner& runner) {
+		std::mt19937 random(5);
+		using Brain = NeuralNetwork::FixedNetwork<8, 16, 4>;
+		Brain network;
+		Brain::Workspace workspace;
+		Brain::Inputs inputs;
+		Brain::Outputs expected;
+		const auto inputSignals = randomSignals(inputs.size(), random);
+		const auto expectedSignals = randomSignals(expected.size(), random);
+		std::copy(inputSignals.begin(), inputSignals.end(), inputs.begin());
+		std::copy(expectedSignals.begin(), expectedSignals.end(), expected.begin());
+
+		runner.run("FixedNetwork_feedForward/8x16x4", 1, [&] {
+			Benchmarks::doNotOptimize(network.feedForward(inputs, workspace));
+		});
+		runner.run("FixedNetwork_backPropagation/8x16x4", 1, [&] {
+			network.feedForward(inputs, workspace);
+			network.backPropagation(workspace, expected, 0.01f);
+		});
+	}
+
+	void cognitiveNetworkBenchmarks(Benchmarks::Runner& runner) {
+		std::mt19937 random(3);
+		CognitiveSystems::NeuralNetwork::DataSet dataset;
+		for (int i = 0; i < 1024; ++i) {
+			dataset.emplace_back(randomSignals(16, random), randomSignals(4, random));
+		}
+
+		CognitiveSystems::NeuralNetwork sequential(CognitiveSystems::Topology(16, { 64, 64 }, 4));
+		runner.run("CognitiveNetwork_learn/sequential", dataset.size(), [&] {
+			Benchmarks::doNotOptimize(sequential.learn(dataset, 1, 0.01f));
+		});
+
+		const auto flatDataset = NeuralNetwork::FlatDataSet::from(dataset);
+		std::vector<size_t> threadsNumbers{ 1 };
+		if (std::thread::hardware_concurrency() > 1)
+			threadsNumbers.push_back(std::thread::hardware_concurrency());
+		for (size_t threads : threadsNumbers) {
+			CognitiveSystems::NeuralNetwork network(CognitiveSystems::Topology(16, { 64, 64 }, 4));
+			CognitiveSystems::ParallelTrainingOptions options;
+			options.threadsNumber = threads;
+			runner.run("CognitiveNetwork_learn/parallel_t" + std::to_string(threads), dataset.size(), [&] {
+				Benchmarks::doNotOptimize(network.learn(dataset, 1, 0.01f, options));
+			});
+			runner.run("CognitiveNetwork_learn/flat_parallel_t" + std::to_string(threads), flatDataset.size(), [&] {
+				Benchmarks::doNotOptimize(network.learn(flatDataset, 1, 0.01f, options));
+			});
+		}
+	}
+
+	/*! Wall-clock time until the mean squared error of a fresh network drops below the target. */
+	void timeToLossBenchmarks(Benchmarks::Runner& runner) {
+		constexpr float TARGET_LOSS = 7.5e-3f;
+		constexpr int MAX_STEPS = 20000;
+		CognitiveSystems::NeuralNetwork::Batch inputs(64, 2), expected(64, 1);
+		for (size_t n = 0; n < inputs.rows(); ++n) {
+			inputs(n, 0) = (n % 8) / 8.f;
+			inputs(n, 1) = (n / 8) / 8.f;
+			expected(n, 0) = 0.2f + 0.3f * inputs(n, 0) + 0.4f * inputs(n, 1) * inputs(n, 1);
+		}
+
+		const auto run = [&](const std::string& name, const auto& makeOptimizer) {
+			runner.run("CognitiveNetwork_timeToLoss/" + name, 1, [&] {
+				CognitiveSystems::NeuralNetwork network(CognitiveSystems::Topology(2, { 8 }, 1));
+				auto optimizer = makeOptimizer();
+				int step = 0;
+				while (network.trainBatch(inputs, expected, optimizer)[0] > TARGET_LOSS && ++step < MAX_STEPS) {
+				}
+				Benchmarks::doNotOptimize(step);
+			});
+		};
+		run("sgd", [] { return NeuralNetwork::Optimizers::SGD(5.f); });
+		run("momentum", [] { return NeuralNetwork::Optimizers::Momentum(0.5f); });
+		run("rmsprop", [] { return NeuralNetwork::Optimizers::RMSProp(0.01f); });
+		run("adam", [] { return NeuralNetwork::Optimizers::Adam(0.02f); });
+	}
+
+	void sensorSystemBenchmarks(Benchmarks::Runner& runner) {
+		std::mt19937 random(4);
+		for (int objectsNumber : { 100, 1000, 10000, 100000 }) {
+			// The world grows with the number of objects, so their density stays the same.
+			const int side = static_cast<int>(std::sqrt(objectsNumber) * 100);
+			std::uniform_int_distribution<int> coordinate(0, side);
+			std::vector<Positioning::Object2D> objects;
+			objects.reserve(objectsNumber);
+			for (int i = 0; i < objectsNumber; ++i) {
+				Objects::Food food(1);
+				food.setLocation(coordinate(random), coordinate(random));
+				objects.push_back(food);
+			}
+
+			SensorSystems::SimpleSensorSystem sensorSystem;
+			const Positioning::Coordinates position{ side / 2, side / 2 };
+			runner.run("SensorSystem_analyze/" + std::to_string(objectsNumber), objectsNumber, [&] {
+				Benchmarks::doNotOptimize(sensorSystem.analyze(position, objects));
+			});
+
+			Positioning::SpatialGrid grid(static_cast<int>(sensorSystem.getVisibleRange()));
+			for (auto& object : objects) {
+				grid.insert(object);
+			}
+			runner.run("SensorSystem_analyzeGrid/" + std::to_string(objectsNumber), objectsNumber, [&] {
+				Benchmarks::doNotOptimize(sensorSystem.analyze(position, grid));
+			});
+		}
+	}
+
+	void entityBenchmarks(Benchmarks::Runner& runner) {
+		for (int wormsNumber : { 1000, 100000 }) {
+			// Bodies and digestive systems behind pointers, as Objects::Worm keeps them.
+			std::vector<std::unique_ptr<BodySystems::IBody>> bodies;
+			std::vector<std::unique_ptr<BodySystems::IDigestiveSystem>> digestiveSystems;
+			Entities::World world;
+			for (int i = 0; i < wormsNumber; ++i) {
+				bodies.push_back(std::make_unique<Bodies::SimpleBody>(100, 1, 10, 1));
+				digestiveSystems.push_back(std::make_unique<DigestiveSystems::SimpleDigestiveSystem>(1 << 30));
+				bodies.back()->getDamage(50);
+				const auto worm = world.createWorm({ i, -i }, { 100, 1, 10, 1, 1 << 30 });
+				world.getWorms().health[world.getRow(worm)] = 50;
+			}
+
+			runner.run("Entities_regenerate/objects/" + std::to_string(wormsNumber), wormsNumber, [&] {
+				for (size_t i = 0; i < bodies.size(); ++i) {
+					bodies[i]->regenerate(*digestiveSystems[i]);
+					bodies[i]->getDamage(1);
+				}
+				Benchmarks::doNotOptimize(bodies.front()->getHealthValue());
+			});
+			runner.run("Entities_regenerate/world/" + std::to_string(wormsNumber), wormsNumber, [&] {
+				auto& worms = world.getWorms();
+				Entities::Systems::regenerate(worms);
+				for (auto& health : worms.health) {
+					health -= 1;
+				}
+				Benchmarks::doNotOptimize(worms.health.front());
+			});
+			runner.run("Entities_move/" + std::to_string(wormsNumber), wormsNumber, [&] {
+				Entities::Systems::move(world.getWorms());
+				Benchmarks::doNotOptimize(world.getWorms().x.front());
+			});
+		}
+	}
+
+	void simulatorBenchmarks(Benchmarks::Runner& runner) {
+		constexpr int WORMS_NUMBER = 20000;
+		std::vector<size_t> threadsNumbers = { 1 };
+		if (std::thread::hardware_concurrency() > 1) {
+			threadsNumbers.push_back(std::thread::hardware_concurrency());
+		}
+		for (size_t threads : threadsNumbers) {
+			std::mt19937 random(20);
+			// About one worm per 100x100 square, so a worm sees a few dozen entities.
+			const int side = static_cast<int>(std::sqrt(WORMS_NUMBER) * 100);
+			std::uniform_int_distribution<int> coordinate(0, side);
+			Entities::World world;
+			for (int i = 0; i < WORMS_NUMBER; ++i) {
+				// Worms that neither die nor reach anything, so every tick does the same work.
+				world.createWorm({ coordinate(random), coordinate(random) }, { 100, 0, 0, 1, 0 });
+				world.createFood({ coordinate(random), coordinate(random) }, 1);
+			}
+			Entities::Simulator simulator(threads);
+			runner.run("Simulator_tick/" + std::to_string(WORMS_NUMBER) + "/threads:" + std::to_string(threads), WORMS_NUMBER, [&] {
+				Benchmarks::doNotOptimize(simulator.tick(world));
+			});
+		}
+	}
+
+	/*! Decisions of all worms of a tick with a small brain: one forward pass per worm against batches of worms. */
+	void brainBenchmarks(Benchmarks::Runner& runner) {
+		constexpr size_t WORMS_NUMBER = 20000;
+		constexpr size_t BATCH_SIZE = 256;
+		std::mt19937 random(21);
+		const CognitiveSystems::NeuralNetwork brain(CognitiveSystems::Topology(static_cast<int>(Entities::Senses::FEATURES_NUMBER), { 16 },
+																			   static_cast<int>(Entities::Senses::ACTIONS_NUMBER)));
+		NeuralNetwork::Matrix<float> features(WORMS_NUMBER, Entities::Senses::FEATURES_NUMBER);
+		const auto signals = randomSignals(features.size(), random);
+		std::copy(signals.begin(), signals.end(), features.getData());
+
+		CognitiveSystems::Workspace workspace;
+		std::vector<float> wormFeatures(Entities::Senses::FEATURES_NUMBER);
+		runner.run("Brain_decisions/perWorm/" + std::to_string(WORMS_NUMBER), WORMS_NUMBER, [&] {
+			float sum = 0;
+			for (size_t worm = 0; worm < WORMS_NUMBER; ++worm) {
+				const auto row = features.row(worm);
+				std::copy(row.begin(), row.end(), wormFeatures.begin());
+				sum += brain.feedForward(wormFeatures, workspace).front();
+			}
+			Benchmarks::doNotOptimize(sum);
+		});
+
+		CognitiveSystems::BatchWorkspace batchWorkspace;
+		runner.run("Brain_decisions/batched/" + std::to_string(WORMS_NUMBER), WORMS_NUMBER, [&] {
+			float sum = 0;
+			for (size_t begin = 0; begin < WORMS_NUMBER; begin += BATCH_SIZE) {
+				const size_t rows = std::min(BATCH_SIZE, WORMS_NUMBER - begin);
+				const NeuralNetwork::MatrixView<const float> batch(features.getData() + begin * features.cols(), rows, features.cols());
+				sum += brain.feedForward(batch, batchWorkspace)(0, 0);
+			}
+			Benchmarks::doNotOptimize(sum);
+		});
+
+		// Every worm of a batch with another brain of the same topology, as in a population.
+		constexpr size_t BRAINS_NUMBER = 1024;
+		std::vector<CognitiveSystems::NeuralNetwork> brains(BRAINS_NUMBER, brain);
+		std::vector<const CognitiveSystems::NeuralNetwork*> wormBrains(WORMS_NUMBER);
+		for (size_t worm = 0; worm < WORMS_NUMBER; ++worm) {
+			wormBrains[worm] = &brains[worm % BRAINS_NUMBER];
+		}
+		runner.run("Brain_decisions/distinctPerWorm/" + std::to_string(WORMS_NUMBER), WORMS_NUMBER, [&] {
+			float sum = 0;
+			for (size_t worm = 0; worm < WORMS_NUMBER; ++worm) {
+				const NeuralNetwork::MatrixView<const float> batch(features.getData() + worm * features.cols(), 1, features.cols());
+				sum += wormBrains[worm]->feedForward(batch, batchWorkspace)(0, 0);
+			}
+			Benchmarks::doNotOptimize(sum);
+		});
+		runner.run("Brain_decisions/distinctBatched/" + std::to_string(WORMS_NUMBER), WORMS_NUMBER, [&] {
+			float sum = 0;
+			for (size_t begin = 0; begin < WORMS_NUMBER; begin += BATCH_SIZE) {
+				const size_t rows = std::min(BATCH_SIZE, WORMS_NUMBER - begin);
+				const NeuralNetwork::MatrixView<const float> batch(features.getData() + begin * features.cols(), rows, features.cols());
+				const auto batchBrains = std::span<const CognitiveSystems::NeuralNetwork* const>(wormBrains).subspan(begin, rows);
+				sum += CognitiveSystems::NeuralNetwork::feedForwardEach(batchBrains, batch, batchWorkspace)(0, 0);
+			}
+			Benchmarks::doNotOptimize(sum);
+		});
+	}
+
+	/*! Food spawning and being eaten in a world that keeps about the same amount of food. */
+	void objectPoolBenchmarks(Benchmarks::Runner& runner) {
+		constexpr size_t FOOD_NUMBER = 10000;
+		constexpr size_t EATEN_PER_TICK = 500;
+
+		std::vector<std::unique_ptr<Objects::Food>> heapFood;
+		for (size_t i = 0; i < FOOD_NUMBER; ++i) {
+			heapFood.push_back(std::make_unique<Objects::Food>(1));
+		}
+		size_t next = 0;
+		runner.run("Food_spawnAndEat/heap", EATEN_PER_TICK, [&] {
+			for (size_t i = 0; i < EATEN_PER_TICK; ++i) {
+				next = (next + 7919) % FOOD_NUMBER;
+				heapFood[next] = std::make_unique<Objects::Food>(1);
+			}
+			Benchmarks::doNotOptimize(heapFood[next].get());
+		});
+
+		Utils::ObjectPool<Objects::Food> pool;
+		std::vector<Utils::ObjectPool<Objects::Food>::Handle> handles;
+		for (size_t i = 0; i < FOOD_NUMBER; ++i) {
+			handles.push_back(pool.spawn(1));
+		}
+		runner.run("Food_spawnAndEat/pool", EATEN_PER_TICK, [&] {
+			for (size_t i = 0; i < EATEN_PER_TICK; ++i) {
+				next = (next + 7919) % FOOD_NUMBER;
+				pool.despawn(handles[next]);
+				handles[next] = pool.spawn(1);
+			}
+			Benchmarks::doNotOptimize(pool.get(handles[next]));
+		});
+	}
+
+	/*! One generation of brains evaluated in small worlds, on one thread and on all of them. */
+	void evolutionBenchmarks(Benchmarks::Runner& runner) {
+		Evolution::WorldOptions world;
+		world.ticks = 50;
+		Evolution::EvolutionOptions options;
+		options.populationSize = 32;
+		std::vector<size_t> threadsNumbers = { 1 };
+		if (std::thread::hardware_concurrency() > 1) {
+			threadsNumbers.push_back(std::thread::hardware_concurrency());
+		}
+		for (size_t threads : threadsNumbers) {
+			options.threadsNumber = threads;
+			Evolution::Engine engine(CognitiveSystems::Topology(static_cast<int>(Entities::Senses::FEATURES_NUMBER), { 16 },
+																static_cast<int>(Entities::Senses::ACTIONS_NUMBER)),
+									 options, Evolution::Engine::makeWorldFitness(world));
+			runner.run("Evolution_generation/" + std::to_string(options.populationSize) + "/threads:" + std::to_string(threads),
+					   options.populationSize, [&] {
+				Benchmarks::doNotOptimize(engine.step().bestFitness);
+			});
+		}
+	}
+
+	/*! What a snapshot costs the tick loop (capturing the world) and how fast a world comes back from one. */
+	void snapshotBenchmarks(Benchmarks::Runner& runner) {
+		constexpr int ENTITIES_NUMBER = 100000;
+		std::mt19937 random(25);
+		std::uniform_int_distribution<int> coordinate(0, 30000);
+		Entities::World world;
+		for (int i = 0; i < ENTITIES_NUMBER / 2; ++i) {
+			world.createWorm({ coordinate(random), coordinate(random) }, {});
+			world.createFood({ coordinate(random), coordinate(random) }, 10);
+		}
+		const CognitiveSystems::NeuralNetwork brain(CognitiveSystems::Topology(static_cast<int>(Entities::Senses::FEATURES_NUMBER), { 16 },
+																			   static_cast<int>(Entities::Senses::ACTIONS_NUMBER)));
+		const std::vector<const CognitiveSystems::NeuralNetwork*> brains{ &brain };
+
+		Entities::Snapshot::State state;
+		runner.run("Snapshot_capture/" + std::to_string(ENTITIES_NUMBER), ENTITIES_NUMBER, [&] {
+			state.capture(world, brains, 1);
+			Benchmarks::doNotOptimize(state.getTick());
+		});
+
+		const auto path = std::filesystem::temp_directory_path() / "world_snapshot_benchmark.bin";
+		Entities::Snapshot::write(path, world, brains, 1);
+		Entities::World restored;
+		runner.run("Snapshot_restore/" + std::to_string(ENTITIES_NUMBER), ENTITIES_NUMBER, [&] {
+			Benchmarks::doNotOptimize(Entities::Snapshot::restore(path, restored).tick);
+		});
+		std::filesystem::remove(path);
+	}
+
+}
+
+int main(int argc, char** argv) {
+	std::vector<std::string> arguments(argv + 1, argv + argc);
+	std::string filter;
+	std::string jsonPath;
+	std::string profilePath;
+	double minTime = 0.5;
+	double threshold = 0.1;
+	std::vector<std::string> compared;
+
+	try {
+		for (size_t i = 0; i < arguments.size(); ++i) {
+			const auto next = [&]() -> const std::string& {
+				if (i + 1 >= arguments.size())
+					throw std::runtime_error(arguments[i] + " requires a value.");
+				return arguments[++i];
+			};
+			if (arguments[i] == "--filter")
+				filter = next();
+			else if (arguments[i] == "--json")
+				jsonPath = next();
+			else if (arguments[i] == "--profile-json")
+				profilePath = next();
+			else if (arguments[i] == "--min-time")
+				minTime = std::stod(next());
+			else if (arguments[i] == "--threshold")
+				threshold = std::stod(next());
+			else if (arguments[i] == "--compare") {
+				compared.push_back(next());
+				compared.push_back(next());
+			}
+			else
+				throw std::runtime_error("Unknown argument " + arguments[i] + ".");
+		}
+
+		if (!compared.empty()) {
+			const int regressions = Benchmarks::compare(Benchmarks::readJson(compared[0]), Benchmarks::readJson(compared[1]), threshold);
+			std::cout << regressions << " regression(s)" << std::endl;
+			return regressions == 0 ? 0 : 1;
+		}
+
+		Benchmarks::Runner runner(filter, minTime);
+		Benchmarks::Runner::printHeader();
+		activationBenchmarks(runner);
+		layerConnectionBenchmarks(runner);
+		moduleNetworkBenchmarks(runner);
+		fixedNetworkBenchmarks(runner);
+		cognitiveNetworkBenchmarks(runner);
+		timeToLossBenchmarks(runner);
+		sensorSystemBenchmarks(runner);
+		entityBenchmarks(runner);
+		simulatorBenchmarks(runner);
+		brainBenchmarks(runner);
+		objectPoolBenchmarks(runner);
+		evolutionBenchmarks(runner);
+		snapshotBenchmarks(runner);
+		if (!jsonPath.empty())
+			Benchmarks::writeJson(jsonPath, runner.getResults());
+#ifdef NEURAL_NETWORK_PROFILING
+		std::cout << '\n';
+		NeuralNetwork::Profiling::writeTable(std::cout, NeuralNetwork::Profiling::snapshot());
+		if (!profilePath.empty()) {
+			std::ofstream profile(profilePath);
+			NeuralNetwork::Profiling::writeJson(profile, NeuralNetwork::Profiling::snapshot());
+		}
+#endif
+	}
+	catch (const std::exception& exception) {
+		std::cerr << exception.what() << std::endl;
+		return 2;
+	}
+	return 0;
+}
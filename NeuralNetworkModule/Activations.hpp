@@ -0,0 +1,163 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include "Kernels.hpp"
+
+/*!
+* Activation functions as compile-time policies. Every policy provides
+* - activate(x) and an in-place activate(values, size) for a whole layer;
+* - derivative(y), the derivative expressed through the activated value y = activate(x),
+*   so backpropagation uses the outputs cached by the forward pass instead of calling exp again.
+* IDENTIFIER is stored in model files, so a model cannot be loaded with a different activation.
+*/
+namespace NeuralNetwork::Activations {
+	template<class T>
+	concept Activation = requires(float value, float* values, std::size_t size) {
+		{ T::activate(value) } -> std::same_as<float>;
+		{ T::activate(values, size) } -> std::same_as<void>;
+		{ T::derivative(value) } -> std::same_as<float>;
+		{ T::IDENTIFIER } -> std::convertible_to<std::uint32_t>;
+	};
+
+	struct Sigmoid {
+		static constexpr std::uint32_t IDENTIFIER = 0;
+
+		static float activate(float x) noexcept {
+			return Kernels::Scalar::sigmoid(x);
+		}
+
+		/*! Uses the vectorized kernels. */
+		static void activate(float* values, std::size_t size) noexcept {
+			Kernels::sigmoid(values, size);
+		}
+
+		static float derivative(float y) noexcept {
+			return y * (1.f - y);
+		}
+	};
+
+	/*!
+	* Sigmoid read from a table with linear interpolation: no exp at all, absolute error below MAX_ERROR.
+	* Outside of [-RANGE, RANGE] the sigmoid is within 1.2e-7 of 0 or 1 and is clamped.
+	* The table beats std::exp on scalar paths, so it is used by activate(x) and, on machines without AVX2,
+	* by activate(values, size). With AVX2 whole layers go through the vectorized sigmoid kernels instead,
+	* which are faster than gathering from the table and well within MAX_ERROR.
+	*/
+	struct FastSigmoid {
+		static constexpr std::uint32_t IDENTIFIER = 1;
+		static constexpr float RANGE = 16.f;
+		static constexpr std::size_t TABLE_SIZE = 2048;
+		static constexpr float MAX_ERROR = 5e-6f;
+
+		static float activate(float x) noexcept {
+			return interpolate(getTable(), x);
+		}
+
+		static void activate(float* values, std::size_t size) noexcept {
+			if (Kernels::getBestKernels().instructionSet != Kernels::InstructionSet::Scalar) {
+				Kernels::sigmoid(values, size);
+				return;
+			}
+			const auto& table = getTable();
+			for (std::size_t i = 0; i < size; ++i) {
+				values[i] = interpolate(table, values[i]);
+			}
+		}
+
+		static float derivative(float y) noexcept {
+			return y * (1.f - y);
+		}
+
+	private:
+		using Table = std::array<float, TABLE_SIZE + 1>;
+
+		static const Table& getTable() noexcept {
+			static const Table table = [] {
+				Table values;
+				for (std::size_t i = 0; i <= TABLE_SIZE; ++i) {
+					values[i] = Kernels::Scalar::sigmoid(-RANGE + 2 * RANGE * i / TABLE_SIZE);
+				}
+				return values;
+			}();
+			return table;
+		}
+
+		static float interpolate(const Table& table, float x) noexcept {
+			const float position = (std::clamp(x, -RANGE, RANGE) + RANGE) * (TABLE_SIZE / (2 * RANGE));
+			const std::size_t index = std::min(static_cast<std::size_t>(position), TABLE_SIZE - 1);
+			const float fraction = position - index;
+			return table[index] + (table[index + 1] - table[index]) * fraction;
+		}
+	};
+
+	/*! tanh(x) = 2 * sigmoid(2x) - 1, which lets a whole layer use the vectorized sigmoid kernels. */
+	struct Tanh {
+		static constexpr std::uint32_t IDENTIFIER = 2;
+
+		static float activate(float x) noexcept {
+			return 2.f * Kernels::Scalar::sigmoid(2.f * x) - 1.f;
+		}
+
+		static void activate(float* values, std::size_t size) noexcept {
+			for (std::size_t i = 0; i < size; ++i) {
+				values[i] *= 2.f;
+			}
+			Kernels::sigmoid(values, size);
+			for (std::size_t i = 0; i < size; ++i) {
+				values[i] = 2.f * values[i] - 1.f;
+			}
+		}
+
+		static float derivative(float y) noexcept {
+			return 1.f - y * y;
+		}
+	};
+
+	struct ReLU {
+		static constexpr std::uint32_t IDENTIFIER = 3;
+
+		static float activate(float x) noexcept {
+			return std::max(x, 0.f);
+		}
+
+		static void activate(float* values, std::size_t size) noexcept {
+			for (std::size_t i = 0; i < size; ++i) {
+				values[i] = activate(values[i]);
+			}
+		}
+
+		static float derivative(float y) noexcept {
+			return y > 0.f ? 1.f : 0.f;
+		}
+	};
+
+	/*!
+	* ReLU that lets a small gradient through for negative inputs, so neurons cannot die.
+	* IDENTIFIER is the bits of the slope with the highest bit set: every slope has its own, and as the slope
+	* is positive it cannot be mistaken for the identifier of another activation.
+	*/
+	template<float Slope = 0.01f>
+	struct LeakyReLU {
+		static_assert(Slope > 0.f, "Slope has to be positive, otherwise the derivative cannot be found from the output.");
+		static constexpr std::uint32_t IDENTIFIER = 0x80000000u | std::bit_cast<std::uint32_t>(Slope);
+
+		static float activate(float x) noexcept {
+			return x > 0.f ? x : Slope * x;
+		}
+
+		static void activate(float* values, std::size_t size) noexcept {
+			for (std::size_t i = 0; i < size; ++i) {
+				values[i] = activate(values[i]);
+			}
+		}
+
+		static float derivative(float y) noexcept {
+			return y > 0.f ? 1.f : Slope;
+		}
+	};
+}
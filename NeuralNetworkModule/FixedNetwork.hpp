@@ -0,0 +1,190 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include "Kernels.hpp"
+#include "NeuralNetwork.hpp"
+
+namespace NeuralNetwork {
+	/*!
+	* NeuralNetwork with the topology fixed at compile time: FixedNetwork<3, 16, 16, 2> is the same network
+	* as NeuralNetwork({ 3, 16, 16, 2 }) and computes the same outputs.
+	* All weights live in one std::array, so the network has no heap memory at all, is trivially copyable
+	* and can be kept on the stack or inside another object. The forward pass runs every layer through the
+	* same runtime-dispatched vector kernels as NeuralNetwork, which beat unrolled scalar code because of exp;
+	* the backward pass loops have constexpr trip counts, which lets the compiler unroll them for small layers.
+	*/
+	template<std::size_t... NeuronsNumbers>
+	class FixedNetwork {
+		static_assert(sizeof...(NeuronsNumbers) >= 2, "A network needs at least an input and an output layer.");
+		static_assert(((NeuronsNumbers > 0) && ...), "Every layer needs at least one neuron.");
+
+		static constexpr std::array<std::size_t, sizeof...(NeuronsNumbers)> NEURONS = { NeuronsNumbers... };
+
+		/*! Offsets of the weights of every layer connection in `weights`, the last element is the total. */
+		static constexpr auto WEIGHTS_OFFSETS = [] {
+			std::array<std::size_t, NEURONS.size()> offsets{};
+			for (std::size_t l = 1; l < NEURONS.size(); ++l) {
+				offsets[l] = offsets[l - 1] + NEURONS[l - 1] * NEURONS[l];
+			}
+			return offsets;
+		}();
+
+		/*! Offsets of the signals of every layer in Workspace, the last element is where the last layer begins. */
+		static constexpr auto SIGNALS_OFFSETS = [] {
+			std::array<std::size_t, NEURONS.size()> offsets{};
+			for (std::size_t l = 1; l < NEURONS.size(); ++l) {
+				offsets[l] = offsets[l - 1] + NEURONS[l - 1];
+			}
+			return offsets;
+		}();
+
+	public:
+		static constexpr std::size_t LAYER_CONNECTIONS_NUMBER = NEURONS.size() - 1;
+		static constexpr std::size_t INPUTS_NUMBER = NEURONS.front();
+		static constexpr std::size_t OUTPUTS_NUMBER = NEURONS.back();
+		static constexpr std::size_t WEIGHTS_NUMBER = WEIGHTS_OFFSETS.back();
+		static constexpr std::size_t SIGNALS_NUMBER = SIGNALS_OFFSETS.back() + NEURONS.back();
+
+		using Inputs = std::array<Signal, INPUTS_NUMBER>;
+		using Outputs = std::array<Signal, OUTPUTS_NUMBER>;
+
+		/*! Signals and deltas of every layer for one pass, laid out like in NeuralNetwork::Workspace. */
+		struct Workspace {
+			std::array<Signal, SIGNALS_NUMBER> signals{};
+			std::array<Error, SIGNALS_NUMBER> deltas{};
+
+			Outputs getOutputs() const noexcept {
+				Outputs outputs;
+				for (std::size_t i = 0; i < OUTPUTS_NUMBER; ++i) {
+					outputs[i] = signals[SIGNALS_OFFSETS.back() + i];
+				}
+				return outputs;
+			}
+		};
+
+		/*! All weights are 1, as in NeuralNetwork. */
+		constexpr FixedNetwork() noexcept {
+			weights.fill(1.f);
+		}
+
+		/*! Copies weights of a runtime network with the same topology. */
+		static FixedNetwork fromNetwork(const NeuralNetwork& network) {
+			const auto& layerConnections = network.getLayerConnections();
+			if (layerConnections.size() != LAYER_CONNECTIONS_NUMBER)
+				throw std::runtime_error("Network has a different number of layers.");
+
+			FixedNetwork fixedNetwork;
+			for (std::size_t l = 0; l < LAYER_CONNECTIONS_NUMBER; ++l) {
+				const auto& layer = layerConnections[l];
+				if (static_cast<std::size_t>(layer.getNeuronNumber()) != NEURONS[l] || static_cast<std::size_t>(layer.getNextLayerNeuronNumber()) != NEURONS[l + 1])
+					throw std::runtime_error("Network has layers of different sizes.");
+				for (std::size_t i = 0; i < NEURONS[l + 1]; ++i) {
+					for (std::size_t j = 0; j < NEURONS[l]; ++j) {
+						fixedNetwork.weights[WEIGHTS_OFFSETS[l] + i * NEURONS[l] + j] = layer.getWeight(static_cast<int>(j), static_cast<int>(i));
+					}
+				}
+			}
+			return fixedNetwork;
+		}
+
+		/*! Weight of the connection from the neuron `from` on the layer `layer` to the neuron `to` on the next one. */
+		Weight getWeight(std::size_t layer, std::size_t from, std::size_t to) const noexcept {
+			return weights[WEIGHTS_OFFSETS[layer] + to * NEURONS[layer] + from];
+		}
+
+		void setWeight(std::size_t layer, std::size_t from, std::size_t to, Weight weight) noexcept {
+			weights[WEIGHTS_OFFSETS[layer] + to * NEURONS[layer] + from] = weight;
+		}
+
+		Outputs feedForward(const Inputs& inputs) const noexcept {
+			Workspace workspace;
+			return feedForward(inputs, workspace);
+		}
+
+		/*! Runs signals through the network remembering them in `workspace` for backPropagation. */
+		Outputs feedForward(const Inputs& inputs, Workspace& workspace) const noexcept {
+			for (std::size_t i = 0; i < INPUTS_NUMBER; ++i) {
+				workspace.signals[i] = inputs[i];
+			}
+			forEachLayer([&]<std::size_t L>() { getOutputs<L>(workspace); });
+			return workspace.getOutputs();
+		}
+
+		/*! Learns from the signals that the last feedForward left in `workspace`, same as NeuralNetwork::backPropagation. */
+		void backPropagation(Workspace& workspace, const Outputs& expected, const float learningRate) noexcept {
+			constexpr std::size_t lastOffset = SIGNALS_OFFSETS.back();
+			for (std::size_t i = 0; i < OUTPUTS_NUMBER; ++i) {
+				const Signal actual = workspace.signals[lastOffset + i];
+				workspace.deltas[lastOffset + i] = (actual - expected[i]) * sigmDx(actual);
+			}
+			forEachLayerBackwards([&]<std::size_t L>() { teachLayer<L>(workspace, learningRate); });
+		}
+
+	private:
+		template<class Function>
+		static constexpr void forEachLayer(Function&& function) {
+			[&]<std::size_t... L>(std::index_sequence<L...>) {
+				(function.template operator()<L>(), ...);
+			}(std::make_index_sequence<LAYER_CONNECTIONS_NUMBER>());
+		}
+
+		template<class Function>
+		static constexpr void forEachLayerBackwards(Function&& function) {
+			[&]<std::size_t... L>(std::index_sequence<L...>) {
+				(function.template operator()<LAYER_CONNECTIONS_NUMBER - 1 - L>(), ...);
+			}(std::make_index_sequence<LAYER_CONNECTIONS_NUMBER>());
+		}
+
+		template<std::size_t L>
+		void getOutputs(Workspace& workspace) const noexcept {
+			constexpr std::size_t inputsNumber = NEURONS[L];
+			constexpr std::size_t outputsNumber = NEURONS[L + 1];
+			const Weight* layerWeights = weights.data() + WEIGHTS_OFFSETS[L];
+			const Signal* inputs = workspace.signals.data() + SIGNALS_OFFSETS[L];
+			Signal* outputs = workspace.signals.data() + SIGNALS_OFFSETS[L + 1];
+
+			// The same vectorized kernels as NeuralNetwork. The products commute, so the inputs can take the place
+			// of the shared row of sumsOfSigmoidProducts and the rows of weights that of the samples.
+			const auto& kernels = Kernels::getBestKernels();
+			constexpr std::size_t ROWS = Kernels::SIGMOID_SUMS_ROWS;
+			constexpr std::size_t groupedNumber = outputsNumber / ROWS * ROWS;
+			std::size_t i = 0;
+			for (; i < groupedNumber; i += ROWS) {
+				kernels.sumsOfSigmoidProducts(inputs, layerWeights + i * inputsNumber, inputsNumber, inputsNumber, outputs + i);
+			}
+			for (; i < outputsNumber; ++i) {
+				outputs[i] = kernels.sumOfSigmoidProducts(layerWeights + i * inputsNumber, inputs, inputsNumber);
+			}
+		}
+
+		template<std::size_t L>
+		void teachLayer(Workspace& workspace, const float learningRate) noexcept {
+			constexpr std::size_t inputsNumber = NEURONS[L];
+			constexpr std::size_t outputsNumber = NEURONS[L + 1];
+			Weight* layerWeights = weights.data() + WEIGHTS_OFFSETS[L];
+			const Signal* inputs = workspace.signals.data() + SIGNALS_OFFSETS[L];
+			const Error* deltas = workspace.deltas.data() + SIGNALS_OFFSETS[L + 1];
+
+			std::array<Error, inputsNumber> errors{};
+			for (std::size_t i = 0; i < outputsNumber; ++i) {
+				Weight* neuronWeights = layerWeights + i * inputsNumber;
+				for (std::size_t j = 0; j < inputsNumber; ++j) {
+					neuronWeights[j] -= inputs[j] * deltas[i] * learningRate;
+					errors[j] += neuronWeights[j] * deltas[i];
+				}
+			}
+
+			if constexpr (L != 0) {
+				Error* previousDeltas = workspace.deltas.data() + SIGNALS_OFFSETS[L];
+				for (std::size_t j = 0; j < inputsNumber; ++j) {
+					previousDeltas[j] = errors[j] * sigmDx(inputs[j]);
+				}
+			}
+		}
+
+	private:
+		std::array<Weight, WEIGHTS_NUMBER> weights;
+	};
+}
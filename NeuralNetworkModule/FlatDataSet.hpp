@@ -0,0 +1,93 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+#include <algorithm>
+#include "Matrix.hpp"
+
+namespace NeuralNetwork {
+	/*!
+	* Training samples stored column-wise: inputs of all samples in one contiguous buffer and expected
+	* outputs in another, a row per sample. Adding a sample does not allocate once the buffers have grown,
+	* and any range of samples is a matrix view that can be passed to batched training without copying.
+	*/
+	class FlatDataSet {
+	public:
+		FlatDataSet() noexcept : inputsNumber(0), expectedNumber(0) {}
+
+		FlatDataSet(std::size_t inputsNumber, std::size_t expectedNumber) noexcept
+			: inputsNumber(inputsNumber), expectedNumber(expectedNumber) {}
+
+		/*! Copies samples from any range of (inputs, expected) pairs, e.g. CognitiveSystems::NeuralNetwork::DataSet. */
+		template<class Samples>
+		static FlatDataSet from(const Samples& samples) {
+			if (std::empty(samples))
+				return FlatDataSet();
+			const auto& [firstInputs, firstExpected] = *std::begin(samples);
+			FlatDataSet dataset(std::size(firstInputs), std::size(firstExpected));
+			dataset.reserve(std::size(samples));
+			for (const auto& [sampleInputs, sampleExpected] : samples) {
+				dataset.add(sampleInputs, sampleExpected);
+			}
+			return dataset;
+		}
+
+		std::size_t size() const noexcept {
+			return inputsNumber > 0 ? inputs.size() / inputsNumber : 0;
+		}
+
+		bool empty() const noexcept {
+			return inputs.empty();
+		}
+
+		std::size_t getInputsNumber() const noexcept {
+			return inputsNumber;
+		}
+
+		std::size_t getExpectedNumber() const noexcept {
+			return expectedNumber;
+		}
+
+		void reserve(std::size_t samples) {
+			inputs.reserve(samples * inputsNumber);
+			expected.reserve(samples * expectedNumber);
+		}
+
+		/*! Removes all samples but keeps the memory, so refilling the dataset does not allocate. */
+		void clear() noexcept {
+			inputs.clear();
+			expected.clear();
+		}
+
+		void add(std::span<const float> sampleInputs, std::span<const float> sampleExpected) {
+			if (sampleInputs.size() != inputsNumber || sampleExpected.size() != expectedNumber)
+				throw std::runtime_error("Sample has a different size than the dataset.");
+			inputs.insert(inputs.end(), sampleInputs.begin(), sampleInputs.end());
+			expected.insert(expected.end(), sampleExpected.begin(), sampleExpected.end());
+		}
+
+		std::span<const float> getInputs(std::size_t sample) const noexcept {
+			return { inputs.data() + sample * inputsNumber, inputsNumber };
+		}
+
+		std::span<const float> getExpected(std::size_t sample) const noexcept {
+			return { expected.data() + sample * expectedNumber, expectedNumber };
+		}
+
+		/*! Inputs of samples [begin, end), one sample per row. */
+		MatrixView<const float> getInputs(std::size_t begin, std::size_t end) const noexcept {
+			return { inputs.data() + begin * inputsNumber, end - begin, inputsNumber };
+		}
+
+		/*! Expected outputs of samples [begin, end), one sample per row. */
+		MatrixView<const float> getExpected(std::size_t begin, std::size_t end) const noexcept {
+			return { expected.data() + begin * expectedNumber, end - begin, expectedNumber };
+		}
+
+	private:
+		std::size_t inputsNumber;
+		std::size_t expectedNumber;
+		AlignedVector<float> inputs;
+		AlignedVector<float> expected;
+	};
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <algorithm>
+#include "Matrix.hpp"
+#include "Kernels.hpp"
+
+/*!
+* Matrix-matrix products used by the batched forward and backward passes.
+* All of them accumulate into the output (C += ...), so gradients of several batches
+* can be summed without extra buffers. Loops are tiled so that a block of rows of the
+* weight matrix stays in cache while it is applied to a block of samples.
+*/
+namespace NeuralNetwork::Gemm {
+	/*! Number of rows of each operand processed together. 32 rows of 256 floats fit into L1 twice. */
+	constexpr std::size_t BLOCK_SIZE = 32;
+
+	/*! y += alpha * x */
+	inline void axpy(float alpha, const float* x, float* y, std::size_t size) noexcept {
+		for (std::size_t i = 0; i < size; ++i) {
+			y[i] += alpha * x[i];
+		}
+	}
+
+	/*! C += A * B^T, where A is N x K, B is M x K and C is N x M. Every element is a dot product of two rows. */
+	inline void multiplyTransposed(MatrixView<const float> a, MatrixView<const float> b, MatrixView<float> c) {
+		assert(a.cols() == b.cols() && c.rows() == a.rows() && c.cols() == b.rows());
+		const auto dot = Kernels::getBestKernels().dot;
+		for (std::size_t n0 = 0; n0 < a.rows(); n0 += BLOCK_SIZE) {
+			const std::size_t n1 = std::min(n0 + BLOCK_SIZE, a.rows());
+			for (std::size_t m = 0; m < b.rows(); ++m) {
+				const float* bRow = b.row(m).data();
+				for (std::size_t n = n0; n < n1; ++n) {
+					c(n, m) += dot(a.row(n).data(), bRow, a.cols());
+				}
+			}
+		}
+	}
+
+	/*! C += A * B, where A is N x K, B is K x M and C is N x M. */
+	inline void multiply(MatrixView<const float> a, MatrixView<const float> b, MatrixView<float> c) {
+		assert(a.cols() == b.rows() && c.rows() == a.rows() && c.cols() == b.cols());
+		for (std::size_t k0 = 0; k0 < b.rows(); k0 += BLOCK_SIZE) {
+			const std::size_t k1 = std::min(k0 + BLOCK_SIZE, b.rows());
+			for (std::size_t n = 0; n < a.rows(); ++n) {
+				float* cRow = c.row(n).data();
+				for (std::size_t k = k0; k < k1; ++k) {
+					axpy(a(n, k), b.row(k).data(), cRow, b.cols());
+				}
+			}
+		}
+	}
+
+	/*! C += A^T * B, where A is N x K, B is N x M and C is K x M. */
+	inline void transposedMultiply(MatrixView<const float> a, MatrixView<const float> b, MatrixView<float> c) {
+		assert(a.rows() == b.rows() && c.rows() == a.cols() && c.cols() == b.cols());
+		for (std::size_t k0 = 0; k0 < a.cols(); k0 += BLOCK_SIZE) {
+			const std::size_t k1 = std::min(k0 + BLOCK_SIZE, a.cols());
+			for (std::size_t n = 0; n < a.rows(); ++n) {
+				const float* bRow = b.row(n).data();
+				for (std::size_t k = k0; k < k1; ++k) {
+					axpy(a(n, k), bRow, c.row(k).data(), b.cols());
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,439 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define NEURAL_NETWORK_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(NEURAL_NETWORK_X86) && (defined(__GNUC__) || defined(__clang__))
+#define NEURAL_NETWORK_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define NEURAL_NETWORK_TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+#define NEURAL_NETWORK_TARGET_AVX2
+#define NEURAL_NETWORK_TARGET_AVX512
+#endif
+
+/*!
+* Math kernels used by the forward passes of both networks.
+* Every kernel has a portable scalar version and, on x86, AVX2 and AVX-512 versions.
+* The best version supported by the running CPU is selected once, on the first call.
+*
+* The vector versions use a polynomial approximation of exp (Cephes expf, ~2 ulp) and
+* sum in a different order than the scalar loops, so their results differ from the scalar
+* path by at most KERNEL_TOLERANCE relative error (per element for `sigmoid`, per result for the sums).
+* The float vector kernels finish a row with masked loads instead of a scalar loop, so short rows (small layers) stay vectorized.
+* The int8 dot product accumulates in int32 and is exact in every version; it finishes a row with a scalar loop.
+*/
+namespace NeuralNetwork::Kernels {
+	constexpr float KERNEL_TOLERANCE = 1e-5f;
+
+	enum class InstructionSet {
+		Scalar, Avx2, Avx512
+	};
+
+	/*! Sum of a[i] * b[i]. */
+	using DotKernel = float (*)(const float* a, const float* b, std::size_t size);
+	/*! Sum of sigm(weights[i] * inputs[i]), the output of a single neuron of LayerConnection. */
+	using SigmoidSumKernel = float (*)(const float* weights, const float* inputs, std::size_t size);
+	/*! Rows of inputs that SigmoidSumsKernel runs a row of weights against at once. */
+	constexpr std::size_t SIGMOID_SUMS_ROWS = 4;
+	/*!
+	* sums[r] = sum of sigm(weights[i] * inputs[r * stride + i]) for SIGMOID_SUMS_ROWS rows of inputs: the outputs of one neuron
+	* of LayerConnection for several samples. Every loaded weight is used for all rows, and the rows are independent chains of work.
+	*/
+	using SigmoidSumsKernel = void (*)(const float* weights, const float* inputs, std::size_t stride, std::size_t size, float* sums);
+	/*! values[i] = sigm(values[i]) */
+	using SigmoidKernel = void (*)(float* values, std::size_t size);
+	/*! Sum of a[i] * b[i] accumulated in int32. Exact as long as size < 2^17. */
+	using DotInt8Kernel = std::int32_t (*)(const std::int8_t* a, const std::int8_t* b, std::size_t size);
+
+	struct KernelTable {
+		InstructionSet instructionSet;
+		DotKernel dot;
+		SigmoidSumKernel sumOfSigmoidProducts;
+		SigmoidKernel sigmoid;
+		DotInt8Kernel dotInt8;
+		SigmoidSumsKernel sumsOfSigmoidProducts;
+	};
+
+	namespace Scalar {
+		inline float sigmoid(float x) {
+			return 1.f / (1.f + std::exp(-x));
+		}
+
+		inline float dot(const float* a, const float* b, std::size_t size) {
+			return std::inner_product(a, a + size, b, 0.f);
+		}
+
+		inline float sumOfSigmoidProducts(const float* weights, const float* inputs, std::size_t size) {
+			float sum = 0.f;
+			for (std::size_t i = 0; i < size; ++i) {
+				sum += sigmoid(weights[i] * inputs[i]);
+			}
+			return sum;
+		}
+
+		inline void sumsOfSigmoidProducts(const float* weights, const float* inputs, std::size_t stride, std::size_t size, float* sums) {
+			for (std::size_t r = 0; r < SIGMOID_SUMS_ROWS; ++r) {
+				sums[r] = sumOfSigmoidProducts(weights, inputs + r * stride, size);
+			}
+		}
+
+		inline void sigmoid(float* values, std::size_t size) {
+			for (std::size_t i = 0; i < size; ++i) {
+				values[i] = sigmoid(values[i]);
+			}
+		}
+
+		inline std::int32_t dotInt8(const std::int8_t* a, const std::int8_t* b, std::size_t size) {
+			std::int32_t sum = 0;
+			for (std::size_t i = 0; i < size; ++i) {
+				sum += std::int32_t(a[i]) * b[i];
+			}
+			return sum;
+		}
+	}
+
+#ifdef NEURAL_NETWORK_X86
+	namespace ExpConstants {
+		constexpr float HI = 88.3762626647949f;
+		constexpr float LO = -88.3762626647949f;
+		constexpr float LOG2E = 1.44269504088896341f;
+		constexpr float C1 = 0.693359375f;
+		constexpr float C2 = -2.12194440e-4f;
+		constexpr float P0 = 1.9875691500E-4f;
+		constexpr float P1 = 1.3981999507E-3f;
+		constexpr float P2 = 8.3334519073E-3f;
+		constexpr float P3 = 4.1665795894E-2f;
+		constexpr float P4 = 1.6666665459E-1f;
+		constexpr float P5 = 5.0000001201E-1f;
+	}
+
+	namespace Avx2 {
+		NEURAL_NETWORK_TARGET_AVX2 inline __m256 exp(__m256 x) {
+			using namespace ExpConstants;
+			x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(LO)), _mm256_set1_ps(HI));
+			__m256 fx = _mm256_floor_ps(_mm256_fmadd_ps(x, _mm256_set1_ps(LOG2E), _mm256_set1_ps(0.5f)));
+			x = _mm256_fnmadd_ps(fx, _mm256_set1_ps(C1), x);
+			x = _mm256_fnmadd_ps(fx, _mm256_set1_ps(C2), x);
+			__m256 y = _mm256_set1_ps(P0);
+			y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(P1));
+			y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(P2));
+			y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(P3));
+			y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(P4));
+			y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(P5));
+			y = _mm256_fmadd_ps(y, _mm256_mul_ps(x, x), _mm256_add_ps(x, _mm256_set1_ps(1.f)));
+			__m256i exponent = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvttps_epi32(fx), _mm256_set1_epi32(127)), 23);
+			return _mm256_mul_ps(y, _mm256_castsi256_ps(exponent));
+		}
+
+		NEURAL_NETWORK_TARGET_AVX2 inline __m256 sigmoid(__m256 x) {
+			const __m256 one = _mm256_set1_ps(1.f);
+			return _mm256_div_ps(one, _mm256_add_ps(one, exp(_mm256_sub_ps(_mm256_setzero_ps(), x))));
+		}
+
+		NEURAL_NETWORK_TARGET_AVX2 inline float horizontalSum(__m256 x) {
+			__m128 sum = _mm_add_ps(_mm256_castps256_ps128(x), _mm256_extractf128_ps(x, 1));
+			sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+			sum = _mm_add_ss(sum, _mm_movehdup_ps(sum));
+			return _mm_cvtss_f32(sum);
+		}
+
+		NEURAL_NETWORK_TARGET_AVX2 inline float dot(const float* a, const float* b, std::size_t size) {
+			__m256 sum0 = _mm256_setzero_ps();
+			__m256 sum1 = _mm256_setzero_ps();
+			std::size_t i = 0;
+			for (; i + 16 <= size; i += 16) {
+				sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), sum0);
+				sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), sum1);
+			}
+			for (; i + 8 <= size; i += 8) {
+				sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), sum0);
+			}
+			if (i < size) {
+				const __m256i mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(size - i)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+				sum1 = _mm256_fmadd_ps(_mm256_maskload_ps(a + i, mask), _mm256_maskload_ps(b + i, mask), sum1);
+			}
+			return horizontalSum(_mm256_add_ps(sum0, sum1));
+		}
+
+		NEURAL_NETWORK_TARGET_AVX2 inline float sumOfSigmoidProducts(const float* weights, const float* inputs, std::size_t size) {
+			__m256 sum = _mm256_setzero_ps();
+			std::size_t i = 0;
+			for (; i + 8 <= size; i += 8) {
+				sum = _mm256_add_ps(sum, sigmoid(_mm256_mul_ps(_mm256_loadu_ps(weights + i), _mm256_loadu_ps(inputs + i))));
+			}
+			if (i < size) {
+				// Masked lanes would add sigm(0) = 0.5, so they are cleared after the sigmoid.
+				const __m256i mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(size - i)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+				const __m256 products = _mm256_mul_ps(_mm256_maskload_ps(weights + i, mask), _mm256_maskload_ps(inputs + i, mask));
+				sum = _mm256_add_ps(sum, _mm256_and_ps(sigmoid(products), _mm256_castsi256_ps(mask)));
+			}
+			return horizontalSum(sum);
+		}
+
+		NEURAL_NETWORK_TARGET_AVX2 inline void sumsOfSigmoidProducts(const float* weights, const float* inputs, std::size_t stride, std::size_t size,
+																	 float* sums) {
+			static_assert(SIGMOID_SUMS_ROWS == 4, "The kernel is unrolled for 4 rows.");
+			const float* rows[4] = { inputs, inputs + stride, inputs + 2 * stride, inputs + 3 * stride };
+			__m256 sum[4] = { _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps() };
+			std::size_t i = 0;
+			for (; i + 8 <= size; i += 8) {
+				const __m256 w = _mm256_loadu_ps(weights + i);
+				for (int r = 0; r < 4; ++r) {
+					sum[r] = _mm256_add_ps(sum[r], sigmoid(_mm256_mul_ps(w, _mm256_loadu_ps(rows[r] + i))));
+				}
+			}
+			if (i < size) {
+				// Masked lanes would add sigm(0) = 0.5, so they are cleared after the sigmoid.
+				const __m256i mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(size - i)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+				const __m256 w = _mm256_maskload_ps(weights + i, mask);
+				for (int r = 0; r < 4; ++r) {
+					const __m256 products = _mm256_mul_ps(w, _mm256_maskload_ps(rows[r] + i, mask));
+					sum[r] = _mm256_add_ps(sum[r], _mm256_and_ps(sigmoid(products), _mm256_castsi256_ps(mask)));
+				}
+			}
+			for (int r = 0; r < 4; ++r) {
+				sums[r] = horizontalSum(sum[r]);
+			}
+		}
+
+		NEURAL_NETWORK_TARGET_AVX2 inline void sigmoid(float* values, std::size_t size) {
+			std::size_t i = 0;
+			for (; i + 8 <= size; i += 8) {
+				_mm256_storeu_ps(values + i, sigmoid(_mm256_loadu_ps(values + i)));
+			}
+			if (i < size) {
+				const __m256i mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(size - i)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+				_mm256_maskstore_ps(values + i, mask, sigmoid(_mm256_maskload_ps(values + i, mask)));
+			}
+		}
+
+		/*! Sign-extends 16 bytes to int16 and lets vpmaddwd multiply and add pairs into int32. */
+		NEURAL_NETWORK_TARGET_AVX2 inline std::int32_t dotInt8(const std::int8_t* a, const std::int8_t* b, std::size_t size) {
+			__m256i sum = _mm256_setzero_si256();
+			std::size_t i = 0;
+			for (; i + 16 <= size; i += 16) {
+				const __m256i a16 = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)));
+				const __m256i b16 = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i)));
+				sum = _mm256_add_epi32(sum, _mm256_madd_epi16(a16, b16));
+			}
+			__m128i sum128 = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+			sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, _MM_SHUFFLE(1, 0, 3, 2)));
+			sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, _MM_SHUFFLE(2, 3, 0, 1)));
+			std::int32_t result = _mm_cvtsi128_si32(sum128);
+			for (; i < size; ++i) {
+				result += std::int32_t(a[i]) * b[i];
+			}
+			return result;
+		}
+	}
+
+	namespace Avx512 {
+		NEURAL_NETWORK_TARGET_AVX512 inline __m512 exp(__m512 x) {
+			using namespace ExpConstants;
+			x = _mm512_min_ps(_mm512_max_ps(x, _mm512_set1_ps(LO)), _mm512_set1_ps(HI));
+			__m512 fx = _mm512_roundscale_ps(_mm512_fmadd_ps(x, _mm512_set1_ps(LOG2E), _mm512_set1_ps(0.5f)),
+											 _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+			x = _mm512_fnmadd_ps(fx, _mm512_set1_ps(C1), x);
+			x = _mm512_fnmadd_ps(fx, _mm512_set1_ps(C2), x);
+			__m512 y = _mm512_set1_ps(P0);
+			y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(P1));
+			y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(P2));
+			y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(P3));
+			y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(P4));
+			y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(P5));
+			y = _mm512_fmadd_ps(y, _mm512_mul_ps(x, x), _mm512_add_ps(x, _mm512_set1_ps(1.f)));
+			__m512i exponent = _mm512_slli_epi32(_mm512_add_epi32(_mm512_cvttps_epi32(fx), _mm512_set1_epi32(127)), 23);
+			return _mm512_mul_ps(y, _mm512_castsi512_ps(exponent));
+		}
+
+		NEURAL_NETWORK_TARGET_AVX512 inline __m512 sigmoid(__m512 x) {
+			const __m512 one = _mm512_set1_ps(1.f);
+			return _mm512_div_ps(one, _mm512_add_ps(one, exp(_mm512_sub_ps(_mm512_setzero_ps(), x))));
+		}
+
+		NEURAL_NETWORK_TARGET_AVX512 inline float dot(const float* a, const float* b, std::size_t size) {
+			__m512 sum0 = _mm512_setzero_ps();
+			__m512 sum1 = _mm512_setzero_ps();
+			std::size_t i = 0;
+			for (; i + 32 <= size; i += 32) {
+				sum0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), sum0);
+				sum1 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 16), _mm512_loadu_ps(b + i + 16), sum1);
+			}
+			for (; i + 16 <= size; i += 16) {
+				sum0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), sum0);
+			}
+			if (i < size) {
+				const __mmask16 mask = static_cast<__mmask16>((1u << (size - i)) - 1);
+				sum1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a + i), _mm512_maskz_loadu_ps(mask, b + i), sum1);
+			}
+			return _mm512_reduce_add_ps(_mm512_add_ps(sum0, sum1));
+		}
+
+		NEURAL_NETWORK_TARGET_AVX512 inline float sumOfSigmoidProducts(const float* weights, const float* inputs, std::size_t size) {
+			__m512 sum = _mm512_setzero_ps();
+			std::size_t i = 0;
+			for (; i + 16 <= size; i += 16) {
+				sum = _mm512_add_ps(sum, sigmoid(_mm512_mul_ps(_mm512_loadu_ps(weights + i), _mm512_loadu_ps(inputs + i))));
+			}
+			if (i < size) {
+				// Masked lanes would add sigm(0) = 0.5, so only the lanes that were loaded are added.
+				const __mmask16 mask = static_cast<__mmask16>((1u << (size - i)) - 1);
+				const __m512 products = _mm512_mul_ps(_mm512_maskz_loadu_ps(mask, weights + i), _mm512_maskz_loadu_ps(mask, inputs + i));
+				sum = _mm512_mask_add_ps(sum, mask, sum, sigmoid(products));
+			}
+			return _mm512_reduce_add_ps(sum);
+		}
+
+		NEURAL_NETWORK_TARGET_AVX512 inline void sumsOfSigmoidProducts(const float* weights, const float* inputs, std::size_t stride, std::size_t size,
+																	   float* sums) {
+			static_assert(SIGMOID_SUMS_ROWS == 4, "The kernel is unrolled for 4 rows.");
+			const float* rows[4] = { inputs, inputs + stride, inputs + 2 * stride, inputs + 3 * stride };
+			__m512 sum[4] = { _mm512_setzero_ps(), _mm512_setzero_ps(), _mm512_setzero_ps(), _mm512_setzero_ps() };
+			std::size_t i = 0;
+			for (; i + 16 <= size; i += 16) {
+				const __m512 w = _mm512_loadu_ps(weights + i);
+				for (int r = 0; r < 4; ++r) {
+					sum[r] = _mm512_add_ps(sum[r], sigmoid(_mm512_mul_ps(w, _mm512_loadu_ps(rows[r] + i))));
+				}
+			}
+			if (i < size) {
+				// Masked lanes would add sigm(0) = 0.5, so only the lanes that were loaded are added.
+				const __mmask16 mask = static_cast<__mmask16>((1u << (size - i)) - 1);
+				const __m512 w = _mm512_maskz_loadu_ps(mask, weights + i);
+				for (int r = 0; r < 4; ++r) {
+					const __m512 products = _mm512_mul_ps(w, _mm512_maskz_loadu_ps(mask, rows[r] + i));
+					sum[r] = _mm512_mask_add_ps(sum[r], mask, sum[r], sigmoid(products));
+				}
+			}
+			for (int r = 0; r < 4; ++r) {
+				sums[r] = _mm512_reduce_add_ps(sum[r]);
+			}
+		}
+
+		NEURAL_NETWORK_TARGET_AVX512 inline void sigmoid(float* values, std::size_t size) {
+			std::size_t i = 0;
+			for (; i + 16 <= size; i += 16) {
+				_mm512_storeu_ps(values + i, sigmoid(_mm512_loadu_ps(values + i)));
+			}
+			if (i < size) {
+				const __mmask16 mask = static_cast<__mmask16>((1u << (size - i)) - 1);
+				_mm512_mask_storeu_ps(values + i, mask, sigmoid(_mm512_maskz_loadu_ps(mask, values + i)));
+			}
+		}
+
+		NEURAL_NETWORK_TARGET_AVX512 inline std::int32_t dotInt8(const std::int8_t* a, const std::int8_t* b, std::size_t size) {
+			__m512i sum = _mm512_setzero_si512();
+			std::size_t i = 0;
+			for (; i + 16 <= size; i += 16) {
+				const __m512i a32 = _mm512_cvtepi8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)));
+				const __m512i b32 = _mm512_cvtepi8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i)));
+				sum = _mm512_add_epi32(sum, _mm512_mullo_epi32(a32, b32));
+			}
+			std::int32_t result = _mm512_reduce_add_epi32(sum);
+			for (; i < size; ++i) {
+				result += std::int32_t(a[i]) * b[i];
+			}
+			return result;
+		}
+	}
+
+	namespace Detail {
+		struct CpuFeatures {
+			bool avx2 = false;
+			bool avx512 = false;
+		};
+
+		inline CpuFeatures detectCpuFeatures() noexcept {
+			CpuFeatures features;
+#ifdef _MSC_VER
+			int info[4];
+			__cpuid(info, 1);
+			const bool osxsave = (info[2] & (1 << 27)) != 0;
+			const bool fma = (info[2] & (1 << 12)) != 0;
+			if (!osxsave)
+				return features;
+			const unsigned long long xcr0 = _xgetbv(0);
+			__cpuidex(info, 7, 0);
+			features.avx2 = fma && (info[1] & (1 << 5)) != 0 && (xcr0 & 0x6) == 0x6;
+			features.avx512 = (info[1] & (1 << 16)) != 0 && (xcr0 & 0xE6) == 0xE6;
+#else
+			__builtin_cpu_init();
+			features.avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+			features.avx512 = __builtin_cpu_supports("avx512f");
+#endif
+			return features;
+		}
+	}
+#endif
+
+	/*! Checks whether the running CPU can execute kernels built for the instruction set. */
+	inline bool isSupported(InstructionSet instructionSet) noexcept {
+#ifdef NEURAL_NETWORK_X86
+		static const Detail::CpuFeatures features = Detail::detectCpuFeatures();
+		switch (instructionSet) {
+		case InstructionSet::Avx2:
+			return features.avx2;
+		case InstructionSet::Avx512:
+			return features.avx512;
+		default:
+			return true;
+		}
+#else
+		return instructionSet == InstructionSet::Scalar;
+#endif
+	}
+
+	/*! Returns kernels for the given instruction set. The caller has to check `isSupported` first. */
+	inline KernelTable getKernels(InstructionSet instructionSet) noexcept {
+		switch (instructionSet) {
+#ifdef NEURAL_NETWORK_X86
+		case InstructionSet::Avx512:
+			return { InstructionSet::Avx512, &Avx512::dot, &Avx512::sumOfSigmoidProducts, &Avx512::sigmoid, &Avx512::dotInt8,
+					 &Avx512::sumsOfSigmoidProducts };
+		case InstructionSet::Avx2:
+			return { InstructionSet::Avx2, &Avx2::dot, &Avx2::sumOfSigmoidProducts, &Avx2::sigmoid, &Avx2::dotInt8,
+					 &Avx2::sumsOfSigmoidProducts };
+#endif
+		default:
+			return { InstructionSet::Scalar, &Scalar::dot, &Scalar::sumOfSigmoidProducts, &Scalar::sigmoid, &Scalar::dotInt8,
+					 &Scalar::sumsOfSigmoidProducts };
+		}
+	}
+
+	/*! Returns the fastest kernels supported by the running CPU. */
+	inline const KernelTable& getBestKernels() noexcept {
+		static const KernelTable kernels = [] {
+			if (isSupported(InstructionSet::Avx512))
+				return getKernels(InstructionSet::Avx512);
+			if (isSupported(InstructionSet::Avx2))
+				return getKernels(InstructionSet::Avx2);
+			return getKernels(InstructionSet::Scalar);
+		}();
+		return kernels;
+	}
+
+	inline float dot(const float* a, const float* b, std::size_t size) {
+		return getBestKernels().dot(a, b, size);
+	}
+
+	inline float sumOfSigmoidProducts(const float* weights, const float* inputs, std::size_t size) {
+		return getBestKernels().sumOfSigmoidProducts(weights, inputs, size);
+	}
+
+	inline void sigmoid(float* values, std::size_t size) {
+		getBestKernels().sigmoid(values, size);
+	}
+
+	inline std::int32_t dotInt8(const std::int8_t* a, const std::int8_t* b, std::size_t size) {
+		return getBestKernels().dotInt8(a, b, size);
+	}
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace NeuralNetwork {
+	/*!
+	* Whole file mapped into memory as a private copy-on-write mapping.
+	* Pages are shared with the page cache (and every other process mapping the same file)
+	* until somebody writes to them; writes are never carried back to the file.
+	*/
+	class MappedFile final {
+	public:
+		explicit MappedFile(const std::filesystem::path& path) {
+#ifdef _WIN32
+			file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (file == INVALID_HANDLE_VALUE)
+				throw std::runtime_error("Cannot open " + path.string());
+			LARGE_INTEGER fileSize;
+			if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+				CloseHandle(file);
+				throw std::runtime_error("Cannot map empty file " + path.string());
+			}
+			length = static_cast<std::size_t>(fileSize.QuadPart);
+			mapping = CreateFileMappingW(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+			data = mapping ? MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0) : nullptr;
+			if (!data) {
+				if (mapping)
+					CloseHandle(mapping);
+				CloseHandle(file);
+				throw std::runtime_error("Cannot map " + path.string());
+			}
+#else
+			const int descriptor = ::open(path.c_str(), O_RDONLY);
+			if (descriptor < 0)
+				throw std::runtime_error("Cannot open " + path.string());
+			struct stat status;
+			if (::fstat(descriptor, &status) != 0 || status.st_size == 0) {
+				::close(descriptor);
+				throw std::runtime_error("Cannot map empty file " + path.string());
+			}
+			length = static_cast<std::size_t>(status.st_size);
+			data = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, descriptor, 0);
+			::close(descriptor);
+			if (data == MAP_FAILED)
+				throw std::runtime_error("Cannot map " + path.string());
+#endif
+		}
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		~MappedFile() {
+#ifdef _WIN32
+			UnmapViewOfFile(data);
+			CloseHandle(mapping);
+			CloseHandle(file);
+#else
+			::munmap(data, length);
+#endif
+		}
+
+		std::byte* getData() const noexcept {
+			return static_cast<std::byte*>(data);
+		}
+
+		std::size_t size() const noexcept {
+			return length;
+		}
+
+	private:
+		void* data = nullptr;
+		std::size_t length = 0;
+#ifdef _WIN32
+		HANDLE file = INVALID_HANDLE_VALUE;
+		HANDLE mapping = nullptr;
+#endif
+	};
+}
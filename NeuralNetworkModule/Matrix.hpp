@@ -0,0 +1,239 @@
+#pragma once
+#include <cstddef>
+#include <cassert>
+#include <memory>
+#include <new>
+#include <span>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#ifdef NEURAL_NETWORK_PROFILING
+#include "Profiling.hpp"
+#endif
+
+namespace NeuralNetwork {
+	/*! Cache line size used for aligning weight buffers. */
+	constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+	/*!
+	* Allocator that returns memory aligned to the given boundary so that
+	* rows of a matrix start on a cache line and can be loaded with aligned vector loads.
+	*/
+	template<class T, std::size_t Alignment = CACHE_LINE_SIZE>
+	struct AlignedAllocator {
+		using value_type = T;
+
+		template<class U>
+		struct rebind {
+			using other = AlignedAllocator<U, Alignment>;
+		};
+
+		AlignedAllocator() noexcept = default;
+
+		template<class U>
+		AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+		T* allocate(std::size_t count) {
+#ifdef NEURAL_NETWORK_PROFILING
+			Profiling::countAllocation();
+#endif
+			return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(Alignment)));
+		}
+
+		void deallocate(T* pointer, std::size_t) noexcept {
+			::operator delete(pointer, std::align_val_t(Alignment));
+		}
+
+		template<class U>
+		bool operator==(const AlignedAllocator<U, Alignment>&) const noexcept {
+			return true;
+		}
+	};
+
+	template<class T>
+	using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+	/*!
+	* Non-owning row-major view over a matrix. Rows are `stride` elements apart,
+	* so a view can describe a sub-block of a bigger matrix.
+	*/
+	template<class T>
+	class MatrixView {
+	public:
+		MatrixView() noexcept : data(nullptr), rowsNumber(0), colsNumber(0), stride(0) {}
+		MatrixView(T* data, std::size_t rows, std::size_t cols) noexcept
+			: data(data), rowsNumber(rows), colsNumber(cols), stride(cols) {}
+		MatrixView(T* data, std::size_t rows, std::size_t cols, std::size_t stride) noexcept
+			: data(data), rowsNumber(rows), colsNumber(cols), stride(stride) {}
+
+		std::size_t rows() const noexcept {
+			return rowsNumber;
+		}
+
+		std::size_t cols() const noexcept {
+			return colsNumber;
+		}
+
+		std::size_t getStride() const noexcept {
+			return stride;
+		}
+
+		T* getData() const noexcept {
+			return data;
+		}
+
+		T& operator()(std::size_t row, std::size_t col) const noexcept {
+			assert(row < rowsNumber && col < colsNumber);
+			return data[row * stride + col];
+		}
+
+		std::span<T> row(std::size_t index) const noexcept {
+			assert(index < rowsNumber);
+			return { data + index * stride, colsNumber };
+		}
+
+		operator MatrixView<const T>() const noexcept {
+			return { data, rowsNumber, colsNumber, stride };
+		}
+
+	private:
+		T* data;
+		std::size_t rowsNumber;
+		std::size_t colsNumber;
+		std::size_t stride;
+	};
+
+	/*!
+	* Dense row-major matrix stored in a single contiguous, cache line aligned buffer.
+	* A matrix can also wrap memory it does not own (for example weights mapped from a model file),
+	* see Matrix::wrap. Copies always own their data; resize switches the matrix to its own buffer.
+	*/
+	template<class T>
+	class Matrix {
+	public:
+		Matrix() noexcept : rowsNumber(0), colsNumber(0), elements(nullptr) {}
+		Matrix(std::size_t rows, std::size_t cols, const T& value = T())
+			: rowsNumber(rows), colsNumber(cols), storage(rows * cols, value), elements(storage.data()) {}
+
+		Matrix(const Matrix& other)
+			: rowsNumber(other.rowsNumber), colsNumber(other.colsNumber),
+			  storage(other.elements, other.elements + other.size()), elements(storage.data()) {}
+
+		Matrix(Matrix&& other) noexcept
+			: rowsNumber(other.rowsNumber), colsNumber(other.colsNumber),
+			  storage(std::move(other.storage)), owner(std::move(other.owner)), elements(other.elements) {
+			other.rowsNumber = other.colsNumber = 0;
+			other.elements = nullptr;
+		}
+
+		Matrix& operator=(const Matrix& other) {
+			if (this != &other) {
+				storage.assign(other.elements, other.elements + other.size());
+				owner.reset();
+				elements = storage.data();
+				rowsNumber = other.rowsNumber;
+				colsNumber = other.colsNumber;
+			}
+			return *this;
+		}
+
+		Matrix& operator=(Matrix&& other) noexcept {
+			if (this != &other) {
+				storage = std::move(other.storage);
+				owner = std::move(other.owner);
+				elements = other.elements;
+				rowsNumber = other.rowsNumber;
+				colsNumber = other.colsNumber;
+				other.rowsNumber = other.colsNumber = 0;
+				other.elements = nullptr;
+			}
+			return *this;
+		}
+
+		/*!
+		* Makes a matrix over `rows * cols` elements at `data` without copying them.
+		* `owner` keeps the memory alive for as long as the matrix (or any of its moved-to instances) uses it.
+		*/
+		static Matrix wrap(T* data, std::size_t rows, std::size_t cols, std::shared_ptr<void> owner) {
+			Matrix matrix;
+			matrix.rowsNumber = rows;
+			matrix.colsNumber = cols;
+			matrix.elements = data;
+			matrix.owner = std::move(owner);
+			return matrix;
+		}
+
+		/*! True if the matrix uses memory it does not own. */
+		bool isWrapped() const noexcept {
+			return owner != nullptr;
+		}
+
+		std::size_t rows() const noexcept {
+			return rowsNumber;
+		}
+
+		std::size_t cols() const noexcept {
+			return colsNumber;
+		}
+
+		std::size_t size() const noexcept {
+			return rowsNumber * colsNumber;
+		}
+
+		T* getData() noexcept {
+			return elements;
+		}
+
+		const T* getData() const noexcept {
+			return elements;
+		}
+
+		T& operator()(std::size_t row, std::size_t col) noexcept {
+			assert(row < rowsNumber && col < colsNumber);
+			return elements[row * colsNumber + col];
+		}
+
+		const T& operator()(std::size_t row, std::size_t col) const noexcept {
+			assert(row < rowsNumber && col < colsNumber);
+			return elements[row * colsNumber + col];
+		}
+
+		std::span<T> row(std::size_t index) noexcept {
+			assert(index < rowsNumber);
+			return { elements + index * colsNumber, colsNumber };
+		}
+
+		std::span<const T> row(std::size_t index) const noexcept {
+			assert(index < rowsNumber);
+			return { elements + index * colsNumber, colsNumber };
+		}
+
+		MatrixView<T> view() noexcept {
+			return { elements, rowsNumber, colsNumber };
+		}
+
+		MatrixView<const T> view() const noexcept {
+			return { elements, rowsNumber, colsNumber };
+		}
+
+		/*! Changes the shape of the matrix. Existing values are not preserved in any meaningful order. */
+		void resize(std::size_t rows, std::size_t cols, const T& value = T()) {
+			rowsNumber = rows;
+			colsNumber = cols;
+			storage.assign(rows * cols, value);
+			owner.reset();
+			elements = storage.data();
+		}
+
+		void fill(const T& value) noexcept {
+			std::fill(elements, elements + size(), value);
+		}
+
+	private:
+		std::size_t rowsNumber;
+		std::size_t colsNumber;
+		AlignedVector<T> storage;
+		std::shared_ptr<void> owner;
+		T* elements;
+	};
+}
@@ -0,0 +1,174 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "Matrix.hpp"
+#include "MappedFile.hpp"
+
+/*!
+* Binary model file shared by both network implementations.
+*
+* Layout (little-endian):
+*   Header                       40 bytes, see ModelFile::Header
+*   LayerRecord[layersNumber]    24 bytes each: shape, layer type, activation and offset of the weights
+*   weights of every layer       row-major floats, each blob starting on a CACHE_LINE_SIZE boundary
+*
+* The checksum covers everything after the header. It is only verified when asked for, since hashing reads
+* the whole file; the header and layer records are always validated. Weights are never parsed on load:
+* the file is mapped copy-on-write and the matrices of the network point straight into the mapping,
+* so loading costs a few page table entries and many processes share the same physical pages.
+*/
+namespace NeuralNetwork::ModelFile {
+	constexpr char MAGIC[8] = { 'N', 'N', 'M', 'O', 'D', 'E', 'L', '\0' };
+	constexpr std::uint32_t VERSION = 1;
+	/*! Written as is, reads back differently on a machine with the other byte order. */
+	constexpr std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+	/*! Which network the file was saved from, so one cannot be loaded as the other. */
+	enum class ModelKind : std::uint32_t {
+		LayerConnections = 1,
+		CognitiveLayers = 2
+	};
+
+	struct Header {
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t byteOrder;
+		ModelKind kind;
+		std::uint32_t layersNumber;
+		std::uint64_t payloadSize;
+		std::uint64_t checksum;
+	};
+
+	struct LayerRecord {
+		std::uint32_t rows;
+		std::uint32_t cols;
+		/*! Meaning is up to the network, e.g. the neuron type of a CognitiveSystems layer. */
+		std::uint32_t type;
+		/*! Activations::IDENTIFIER of the layer's activation function; 0, the sigmoid, when the network has none. */
+		std::uint32_t activation;
+		std::uint64_t offset;
+	};
+
+	static_assert(sizeof(Header) == 40 && sizeof(LayerRecord) == 24, "Model file structures must not have padding.");
+
+	/*! Weights of one layer to be saved. */
+	struct LayerBlob {
+		MatrixView<const float> weights;
+		std::uint32_t type = 0;
+		std::uint32_t activation = 0;
+	};
+
+	/*! 64-bit FNV-1a over 8-byte words; `size` has to be a multiple of 8. */
+	inline std::uint64_t checksum(const std::byte* data, std::size_t size) noexcept {
+		std::uint64_t hash = 14695981039346656037ull;
+		for (std::size_t i = 0; i + sizeof(std::uint64_t) <= size; i += sizeof(std::uint64_t)) {
+			std::uint64_t word;
+			std::memcpy(&word, data + i, sizeof(word));
+			hash = (hash ^ word) * 1099511628211ull;
+		}
+		return hash;
+	}
+
+	inline std::size_t alignToCacheLine(std::size_t offset) noexcept {
+		return (offset + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+	}
+
+	inline void write(const std::filesystem::path& path, ModelKind kind, std::span<const LayerBlob> layers) {
+		std::size_t offset = alignToCacheLine(sizeof(Header) + layers.size() * sizeof(LayerRecord));
+		std::vector<LayerRecord> records;
+		records.reserve(layers.size());
+		for (const auto& layer : layers) {
+			records.push_back({ static_cast<std::uint32_t>(layer.weights.rows()), static_cast<std::uint32_t>(layer.weights.cols()),
+								layer.type, layer.activation, offset });
+			offset = alignToCacheLine(offset + layer.weights.rows() * layer.weights.cols() * sizeof(float));
+		}
+
+		std::vector<std::byte> file(offset);
+		std::memcpy(file.data() + sizeof(Header), records.data(), records.size() * sizeof(LayerRecord));
+		for (std::size_t l = 0; l < layers.size(); ++l) {
+			const auto& weights = layers[l].weights;
+			for (std::size_t r = 0; r < weights.rows(); ++r) {
+				std::memcpy(file.data() + records[l].offset + r * weights.cols() * sizeof(float), weights.row(r).data(), weights.cols() * sizeof(float));
+			}
+		}
+
+		Header header;
+		std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+		header.version = VERSION;
+		header.byteOrder = BYTE_ORDER_MARK;
+		header.kind = kind;
+		header.layersNumber = static_cast<std::uint32_t>(layers.size());
+		header.payloadSize = file.size() - sizeof(Header);
+		header.checksum = checksum(file.data() + sizeof(Header), header.payloadSize);
+		std::memcpy(file.data(), &header, sizeof(Header));
+
+		std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+		if (!stream.write(reinterpret_cast<const char*>(file.data()), file.size()))
+			throw std::runtime_error("Cannot write model file " + path.string());
+	}
+
+	/*!
+	* Model file mapped into memory. Matrices returned by getWeights keep the mapping alive.
+	* Pass `verifyChecksum` once for a file of unknown origin; later loads of the same file can skip it.
+	*/
+	class MappedModel {
+	public:
+		MappedModel(const std::filesystem::path& path, ModelKind expectedKind, bool verifyChecksum = false)
+			: file(std::make_shared<MappedFile>(path)) {
+			if (file->size() < sizeof(Header))
+				throw std::runtime_error("Model file is truncated.");
+			std::memcpy(&header, file->getData(), sizeof(Header));
+			if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0)
+				throw std::runtime_error("Not a model file.");
+			if (header.byteOrder != BYTE_ORDER_MARK)
+				throw std::runtime_error("Model file was written on a machine with a different byte order.");
+			if (header.version != VERSION)
+				throw std::runtime_error("Unsupported model file version " + std::to_string(header.version) + ".");
+			if (header.kind != expectedKind)
+				throw std::runtime_error("Model file was saved from a different kind of network.");
+			if (header.payloadSize != file->size() - sizeof(Header) || header.layersNumber * sizeof(LayerRecord) > header.payloadSize)
+				throw std::runtime_error("Model file is truncated.");
+			if (verifyChecksum && checksum(file->getData() + sizeof(Header), header.payloadSize) != header.checksum)
+				throw std::runtime_error("Model file checksum mismatch.");
+
+			records.resize(header.layersNumber);
+			std::memcpy(records.data(), file->getData() + sizeof(Header), records.size() * sizeof(LayerRecord));
+			for (const auto& record : records) {
+				if (record.offset % CACHE_LINE_SIZE != 0 || record.offset > file->size()
+					|| std::uint64_t(record.rows) * record.cols > (file->size() - record.offset) / sizeof(float))
+					throw std::runtime_error("Model file has a corrupted layer record.");
+			}
+		}
+
+		std::size_t getLayersNumber() const noexcept {
+			return records.size();
+		}
+
+		std::uint32_t getLayerType(std::size_t layer) const {
+			return records.at(layer).type;
+		}
+
+		std::uint32_t getLayerActivation(std::size_t layer) const {
+			return records.at(layer).activation;
+		}
+
+		/*! Weights of the layer pointing into the mapping. Writing to them touches only this process' copy of the page. */
+		Matrix<float> getWeights(std::size_t layer) const {
+			const auto& record = records.at(layer);
+			return Matrix<float>::wrap(reinterpret_cast<float*>(file->getData() + record.offset), record.rows, record.cols, file);
+		}
+
+	private:
+		std::shared_ptr<MappedFile> file;
+		Header header;
+		std::vector<LayerRecord> records;
+	};
+}
@@ -1,51 +1,20 @@
+#pragma once
 #include <iostream>
 #include <vector>
 #include <cassert>
 #include <cmath>
 #include <numeric>
 #include <algorithm>
-
-template<class T>
-std::vector<T> operator-(const std::vector<T>& v1, const std::vector<T>& v2) {
-	assert(v1.size() == v2.size());
-	std::vector<T> result;
-	result.reserve(std::min(v1.size(), v2.size()));
-	std::transform(v1.begin(), v1.end(), v2.begin(), std::back_inserter(result), [](const T& t1, const T& t2) {
-		return t1 - t2;
-	});
-	return result;
-}
-
-template<class T>
-std::vector<T> operator-(const std::vector<T>& v1, const T& val) {
-	std::vector<T> result;
-	result.reserve(v1.size());
-	std::transform(v1.begin(), v1.end(), std::back_inserter(result), [&val](const T& t1) {
-		return t1 - val;
-	});
-	return result;
-}
-
-template<class T>
-std::vector<T> operator*(const std::vector<T>& v1, const std::vector<T>& v2) {
-	assert(v1.size() == v2.size());
-	std::vector<T> result;
-	result.reserve(std::min(v1.size(), v2.size()));
-	std::transform(v1.begin(), v1.end(), v2.begin(), std::back_inserter(result), [](const T& t1, const T& t2) {
-		return t1 * t2;
-	});
-	return result;
-}
-
-template<class T>
-std::vector<T> operator*(const std::vector<T>& v1, const T& val) {
-	std::vector<T> result;
-	result.reserve(v1.size());
-	std::transform(v1.begin(), v1.end(), std::back_inserter(result), [&val](const T& t1) {
-		return t1 * val;
-	});
-	return result;
-}
+#include <stdexcept>
+#include <span>
+#include <filesystem>
+#include "Matrix.hpp"
+#include "Kernels.hpp"
+#include "Gemm.hpp"
+#include "VectorExpressions.hpp"
+#include "ModelFile.hpp"
+#include "Optimizers.hpp"
+#include "Profiling.hpp"
 
 namespace NeuralNetwork {
 	class NeuralNetwork;
@@ -54,24 +23,37 @@ namespace NeuralNetwork {
 	using Signal = float;
 	using Error = float;
 
-	using Weights = std::vector<std::vector<Weight>>;
+	/*! Weights of a layer connection: row i holds the weights of all inputs of the i-th neuron on the next layer. */
+	using Weights = Matrix<Weight>;
 	using Signals = std::vector<Signal>;
-	using Errors = std::vector<std::vector<Error>>;
+	using Errors = std::vector<Error>;
 
 	inline float sigm(float x) {
 		return 1.f / (1.f + std::exp(-x));
 	}
 
+	/*! sigm(x) / (1 - sigm(x)), which is exactly exp(x): one exp and no division. */
 	inline float sigmDx(float x) {
-		float sigmVal = sigm(x);
-		return sigmVal / (1 - sigmVal);
+		return std::exp(x);
 	}
 
-	inline std::vector<float> sigmDx(std::vector<float> xs) {
-		for (auto& value : xs) {
-			value = sigmDx(value);
+	/*! sigmDx as a function object, so it can be passed to Expressions::map without picking an overload. */
+	inline constexpr auto sigmDxOf = [](float x) {
+		return sigmDx(x);
+	};
+
+	/*! Writes sigmDx of every value into `result`, which may be `xs` itself. */
+	inline void sigmDx(std::span<const float> xs, std::span<float> result) {
+		assert(xs.size() == result.size());
+		for (std::size_t i = 0; i < xs.size(); ++i) {
+			result[i] = sigmDx(xs[i]);
 		}
-		return xs;
+	}
+
+	inline std::vector<float> sigmDx(const std::vector<float>& xs) {
+		std::vector<float> result(xs.size());
+		sigmDx(xs, result);
+		return result;
 	}
 
 	class LayerConnection {
@@ -79,50 +61,92 @@ namespace NeuralNetwork {
 		LayerConnection(const int neuronsOnThisLayer, const int neuronsOnNextLayer) :
 			neuronNumber(neuronsOnThisLayer),
 			nextLayerNeuronNumber(neuronsOnNextLayer),
-			inputs(neuronsOnThisLayer, 1.f),
-			outputs(neuronsOnThisLayer, 1.f),
-			weights(neuronsOnThisLayer, std::vector<Weight>(neuronsOnNextLayer, 1.f)) {}
+			weights(neuronsOnNextLayer, neuronsOnThisLayer, 1.f) {}
 
 		std::vector<Signal> getOutputs(const std::vector<Signal>& inputSignals) const {
-			inputs = inputSignals;
 			std::vector<Signal> outputSignals(nextLayerNeuronNumber, 0.f);
+			getOutputs(inputSignals, outputSignals);
+			return outputSignals;
+		}
 
-			if (inputSignals.size() != neuronNumber)
+		/*! Writes outputs for `inputSignals` into `outputSignals`. Does not modify the layer, so it is safe to call from many threads. */
+		void getOutputs(std::span<const Signal> inputSignals, std::span<Signal> outputSignals) const {
+			if (inputSignals.size() != static_cast<std::size_t>(neuronNumber))
 				throw std::runtime_error("Input signals count is not exual to the neurons number in the layer.");
+			if (outputSignals.size() != static_cast<std::size_t>(nextLayerNeuronNumber))
+				throw std::runtime_error("Output signals count is not equal to the neurons number in the next layer.");
 
+			const auto sumOfSigmoidProducts = Kernels::getBestKernels().sumOfSigmoidProducts;
 			for (int i = 0; i < nextLayerNeuronNumber; ++i) {
-				for (int j = 0; j < neuronNumber; ++j) {
-					outputSignals[i] += sigm(weights[j][i] * inputs[j]);
-				}
+				outputSignals[i] = sumOfSigmoidProducts(weights.row(i).data(), inputSignals.data(), neuronNumber);
 			}
-			LayerConnection::outputs = std::move(outputSignals);
-			return outputs;
 		}
 
-		const std::vector<Signal>& getInputSignals() const {
-			if (inputs.size() == 0)
-				throw std::runtime_error("Signals are not set yet.");
-			return inputs;
+		int getNeuronNumber() const noexcept {
+			return neuronNumber;
 		}
 
-		const std::vector<Signal>& getOutputSiganls() const {
-			if (outputs.size() == 0)
-				throw std::runtime_error("Outputs are not set yet.");
-			return outputs;
+		int getNextLayerNeuronNumber() const noexcept {
+			return nextLayerNeuronNumber;
 		}
 
+		/*!
+		* Batched version of getOutputs: every row of `inputSignals` is a sample, the result for it is written
+		* to the same row of `outputSignals`. Samples are processed in blocks that stay in cache while every row
+		* of weights is applied to them, and each loaded weight is used for Kernels::SIGMOID_SUMS_ROWS samples at once.
+		*/
+		void getOutputs(MatrixView<const Signal> inputSignals, MatrixView<Signal> outputSignals) const {
+			if (inputSignals.cols() != static_cast<std::size_t>(neuronNumber) || outputSignals.cols() != static_cast<std::size_t>(nextLayerNeuronNumber)
+				|| inputSignals.rows() != outputSignals.rows())
+				throw std::runtime_error("Batch shape does not match the layer.");
+
+			const auto& kernels = Kernels::getBestKernels();
+			constexpr std::size_t ROWS = Kernels::SIGMOID_SUMS_ROWS;
+			float sums[ROWS];
+			for (std::size_t n0 = 0; n0 < inputSignals.rows(); n0 += Gemm::BLOCK_SIZE) {
+				const std::size_t n1 = std::min(n0 + Gemm::BLOCK_SIZE, inputSignals.rows());
+				for (int i = 0; i < nextLayerNeuronNumber; ++i) {
+					const Weight* neuronWeights = weights.row(i).data();
+					std::size_t n = n0;
+					for (; n + ROWS <= n1; n += ROWS) {
+						kernels.sumsOfSigmoidProducts(neuronWeights, inputSignals.row(n).data(), inputSignals.getStride(), neuronNumber, sums);
+						for (std::size_t r = 0; r < ROWS; ++r) {
+							outputSignals(n + r, i) = sums[r];
+						}
+					}
+					for (; n < n1; ++n) {
+						outputSignals(n, i) = kernels.sumOfSigmoidProducts(neuronWeights, inputSignals.row(n).data(), neuronNumber);
+					}
+				}
+			}
+		}
+
+		/*! Weight of the connection from the neuron `from` on this layer to the neuron `to` on the next layer. */
+		Weight getWeight(const int from, const int to) const noexcept {
+			return weights(to, from);
+		}
 
 #ifdef TEST
+		/*! Takes weights in the [neuron on this layer][neuron on the next layer] form. */
 		void setWeights(const std::vector<std::vector<Weight>>& weights) {
-			LayerConnection::weights = weights;
 			assert(neuronNumber == weights.size());
-			for (const auto& w : weights)
-				assert(w.size() == nextLayerNeuronNumber);
+			for (int j = 0; j < neuronNumber; ++j) {
+				assert(weights[j].size() == nextLayerNeuronNumber);
+				for (int i = 0; i < nextLayerNeuronNumber; ++i) {
+					LayerConnection::weights(i, j) = weights[j][i];
+				}
+			}
 		}
 #endif
 
 	private:
-		std::vector<std::vector<Weight>>& getWeights() noexcept {
+		/*! Connection over already existing weights, e.g. mapped from a model file. */
+		explicit LayerConnection(Weights&& weights) :
+			neuronNumber(static_cast<int>(weights.cols())),
+			nextLayerNeuronNumber(static_cast<int>(weights.rows())),
+			weights(std::move(weights)) {}
+
+		Weights& getWeights() noexcept {
 			return weights;
 		}
 
@@ -131,9 +155,46 @@ namespace NeuralNetwork {
 
 		const int neuronNumber;
 		const int nextLayerNeuronNumber;
-		std::vector<std::vector<Weight>> weights;
-		mutable std::vector<Signal> inputs;
-		mutable std::vector<Signal> outputs;
+		Weights weights;
+	};
+
+	/*!
+	* Signals of every layer for one pass through a network: getSignals(0) holds the inputs,
+	* getSignals(i) the outputs of the i-th layer connection. The workspace is owned by the caller,
+	* so one const network can serve many threads at once, each with its own workspace.
+	* backPropagation learns from the signals the last feedForward left in the workspace and keeps
+	* its deltas in the workspace too, so once the workspace is shaped a training step does not allocate.
+	*/
+	class Workspace {
+	public:
+		Workspace() = default;
+
+		const Signals& getSignals(std::size_t layer) const {
+			if (layer >= signals.size())
+				throw std::runtime_error("Workspace has no signals for the layer.");
+			return signals[layer];
+		}
+
+		const Signals& getOutputs() const {
+			if (signals.empty())
+				throw std::runtime_error("Signals are not set yet.");
+			return signals.back();
+		}
+
+	private:
+		friend class NeuralNetwork;
+
+		std::vector<Signals> signals;
+		/*! deltas[i] has the size of signals[i]: errors of the neurons multiplied by sigmDx of their signals. */
+		std::vector<Errors> deltas;
+	};
+
+	/*! Outputs of every layer connection for a batch of samples, owned by the caller like Workspace. */
+	class BatchWorkspace {
+	private:
+		friend class NeuralNetwork;
+
+		std::vector<Matrix<Signal>> activations;
 	};
 
 	class NeuralNetwork {
@@ -147,54 +208,235 @@ namespace NeuralNetwork {
 			}
 		}
 
-		std::vector<float> feedForward(std::vector<Signal> signals) {
-			for (auto& layerConnection : layerConnections) {
-				signals = layerConnection.getOutputs(signals);
+		/*! Saves the weights of every layer connection to a binary model file, see ModelFile.hpp. */
+		void save(const std::filesystem::path& path) const {
+			std::vector<ModelFile::LayerBlob> blobs;
+			blobs.reserve(layerConnections.size());
+			for (const auto& layer : layerConnections) {
+				blobs.push_back({ layer.weights.view() });
+			}
+			ModelFile::write(path, ModelFile::ModelKind::LayerConnections, blobs);
+		}
+
+		/*!
+		* Maps a model file saved by `save`. Weights are used in place, without parsing or copying;
+		* training the loaded network copies only the pages it changes and never modifies the file.
+		* The checksum, which reads the whole file, is verified only with `verifyChecksum`.
+		*/
+		static NeuralNetwork load(const std::filesystem::path& path, bool verifyChecksum = false) {
+			const ModelFile::MappedModel model(path, ModelFile::ModelKind::LayerConnections, verifyChecksum);
+			if (model.getLayersNumber() == 0)
+				throw std::runtime_error("Model file has no layers.");
+
+			std::vector<LayerConnection> layerConnections;
+			layerConnections.reserve(model.getLayersNumber());
+			for (std::size_t l = 0; l < model.getLayersNumber(); ++l) {
+				auto weights = model.getWeights(l);
+				if (l != 0 && weights.cols() != layerConnections.back().weights.rows())
+					throw std::runtime_error("Model file has layers of mismatching sizes.");
+				layerConnections.push_back(LayerConnection(std::move(weights)));
 			}
-			return signals;
+			return NeuralNetwork(std::move(layerConnections));
+		}
+
+		const std::vector<LayerConnection>& getLayerConnections() const noexcept {
+			return layerConnections;
 		}
 
+		/*! Creates a workspace sized for this network. */
+		Workspace createWorkspace() const {
+			Workspace workspace;
+			shapeWorkspace(workspace);
+			return workspace;
+		}
+
+		/*!
+		* Runs signals through the network using only the caller's workspace. The network is not modified,
+		* so concurrent calls are safe as long as every thread passes its own workspace.
+		* Returns the outputs, which stay valid until the next call with the same workspace.
+		*/
+		const Signals& feedForward(const Signals& inputSignals, Workspace& workspace) const {
+			shapeWorkspace(workspace);
+			workspace.signals.front().assign(inputSignals.begin(), inputSignals.end());
+			for (std::size_t l = 0; l < layerConnections.size(); ++l) {
+				const auto& layer = layerConnections[l];
+				NEURAL_NETWORK_PROFILE("NeuralNetwork", l, Forward, 2 * layer.weights.size(),
+									   sizeof(Weight) * (layer.weights.size() + layer.neuronNumber + layer.nextLayerNeuronNumber));
+				layer.getOutputs(workspace.signals[l], workspace.signals[l + 1]);
+			}
+			return workspace.signals.back();
+		}
+
+		/*! Runs signals through the network, remembering them in the network's own workspace for backPropagation. */
+		std::vector<float> feedForward(std::vector<Signal> signals) {
+			return feedForward(signals, trainingWorkspace);
+		}
+
+		/*! Learns from the signals of the last feedForward(signals) call. */
 		void backPropagation(const std::vector<Signal>& actuals, const std::vector<Signal>& expected, const float learningRate) {
-			Errors errors = std::move(teachLastLayer(actuals, expected, learningRate));
-			
-			for (auto layer = layerConnections.rbegin() + 1; layer != layerConnections.rend(); ++layer) {
-				auto deltas = std::move(errors * sigmDx(layer->outputs));
-				std::transform(layer->weights.begin(), layer->weights.end(), deltas.begin(), layer->weights.begin(),
-				[&layer, learningRate](std::vector<Weight>& neuronWeights, std::vector<float>& deltas) {
-					return neuronWeights - layer->inputs * deltas * learningRate;
-				});
-
-				errors.clear();
-				std::transform(layer->weights.begin(),
-							   layer->weights.end(),
-							   deltas.begin(),
-							   std::back_inserter(errors),
-							   [](const std::vector<Weight>& weights, const std::vector<float>& delta) {
-								   return weights * delta;
-							   });
+			backPropagation(trainingWorkspace, actuals, expected, learningRate);
+		}
+
+		/*! Learns from the signals that the last feedForward left in `workspace`, keeping its deltas there as well. */
+		void backPropagation(Workspace& workspace, const std::vector<Signal>& expected, const float learningRate) {
+			backPropagation(workspace, workspace.getOutputs(), expected, learningRate);
+		}
+
+		/*! Runs a batch of samples (one per row) through the network and returns one row of outputs per sample. */
+		Matrix<Signal> feedForward(const Matrix<Signal>& batch) const {
+			BatchWorkspace workspace;
+			feedForwardBatch(batch.view(), workspace.activations);
+			return std::move(workspace.activations.back());
+		}
+
+		/*!
+		* Runs a batch of samples (one per row) through the network using only the caller's workspace,
+		* so concurrent calls are safe and repeated calls with batches of the same size do not allocate.
+		* Returns one row of outputs per sample, valid until the next call with the same workspace.
+		*/
+		const Matrix<Signal>& feedForward(MatrixView<const Signal> batch, BatchWorkspace& workspace) const {
+			feedForwardBatch(batch, workspace.activations);
+			return workspace.activations.back();
+		}
+
+		/*!
+		* Trains the network on a mini-batch: `inputs` and `expected` hold one sample per row.
+		* Gradients of all samples are accumulated with matrix-matrix products and applied once,
+		* averaged over the batch, so `learningRate` means the same for any batch size.
+		* Unlike backPropagation, errors for previous layers are computed with the weights the batch started with.
+		*/
+		void trainBatch(const Matrix<Signal>& inputs, const Matrix<Signal>& expected, const float learningRate) {
+			Optimizers::SGD optimizer(learningRate);
+			trainBatch(inputs, expected, optimizer);
+		}
+
+		/*! trainBatch that lets `optimizer` turn the gradients of the batch into weight updates, one step per batch. */
+		void trainBatch(const Matrix<Signal>& inputs, const Matrix<Signal>& expected, Optimizers::IOptimizer& optimizer) {
+			if (inputs.rows() != expected.rows())
+				throw std::runtime_error("Inputs and expected signals have different number of samples.");
+
+			std::vector<Matrix<Signal>> activations;
+			feedForwardBatch(inputs.view(), activations);
+			const auto& actuals = activations.back();
+			if (expected.cols() != actuals.cols())
+				throw std::runtime_error("Expected signals count is not equal to the neurons number in the last layer.");
+
+			const std::size_t batchSize = inputs.rows();
+			optimizer.beginStep();
+			Matrix<Error> deltas(batchSize, actuals.cols());
+			for (std::size_t n = 0; n < batchSize; ++n) {
+				for (std::size_t i = 0; i < actuals.cols(); ++i) {
+					deltas(n, i) = (actuals(n, i) - expected(n, i)) * sigmDx(actuals(n, i));
+				}
+			}
+
+			for (std::size_t l = layerConnections.size(); l-- > 0;) {
+				auto& layer = layerConnections[l];
+				const auto& layerInputs = l == 0 ? inputs : activations[l - 1];
+
+				Weights gradients(layer.nextLayerNeuronNumber, layer.neuronNumber, 0.f);
+				{
+					NEURAL_NETWORK_PROFILE("NeuralNetwork", l, Backward, (l != 0 ? 4 : 2) * batchSize * layer.weights.size(),
+										   sizeof(Weight) * (2 * layer.weights.size() + batchSize * (layer.neuronNumber + layer.nextLayerNeuronNumber)));
+					Gemm::transposedMultiply(deltas.view(), layerInputs.view(), gradients.view());
+
+					if (l != 0) {
+						Matrix<Error> errors(batchSize, layer.neuronNumber, 0.f);
+						Gemm::multiply(deltas.view(), layer.weights.view(), errors.view());
+						for (std::size_t n = 0; n < batchSize; ++n) {
+							for (int j = 0; j < layer.neuronNumber; ++j) {
+								errors(n, j) *= sigmDx(layerInputs(n, j));
+							}
+						}
+						deltas = std::move(errors);
+					}
+				}
+
+				NEURAL_NETWORK_PROFILE("NeuralNetwork", l, Update, 2 * layer.weights.size(), sizeof(Weight) * 3 * layer.weights.size());
+				optimizer.update(l, { layer.weights.getData(), layer.weights.size() }, { gradients.getData(), gradients.size() }, batchSize);
 			}
 		}
 
 	private:
-		Errors teachLastLayer(const Signals& actual, const Signals& expected, const float learningRate) {
-			std::vector<Error> lastLayerErrors = actual - expected;
-			auto& lastLayer = layerConnections.back();
-			auto deltas = lastLayerErrors * sigmDx(lastLayer.outputs);
+		explicit NeuralNetwork(std::vector<LayerConnection>&& layerConnections) : layerConnections(std::move(layerConnections)) {}
+
+		/*! Fills `activations` with outputs of every layer connection for the batch. */
+		void feedForwardBatch(MatrixView<const Signal> batch, std::vector<Matrix<Signal>>& activations) const {
+			activations.resize(layerConnections.size());
+			MatrixView<const Signal> layerInputs = batch;
+			for (std::size_t l = 0; l < layerConnections.size(); ++l) {
+				const auto& layer = layerConnections[l];
+				NEURAL_NETWORK_PROFILE("NeuralNetwork", l, Forward, 2 * batch.rows() * layer.weights.size(),
+									   sizeof(Weight) * (layer.weights.size() + batch.rows() * (layer.neuronNumber + layer.nextLayerNeuronNumber)));
+				if (activations[l].rows() != batch.rows() || activations[l].cols() != static_cast<std::size_t>(layer.nextLayerNeuronNumber))
+					activations[l].resize(batch.rows(), layer.nextLayerNeuronNumber);
+				layer.getOutputs(layerInputs, activations[l].view());
+				layerInputs = activations[l].view();
+			}
+		}
 
-			for (int i = 0; i < lastLayer.weights.size(); ++i) {
-				lastLayer.weights[i] = std::move(lastLayer.weights[i] - deltas * lastLayer.inputs[i] * learningRate);
+		void backPropagation(Workspace& workspace, const Signals& actuals, const Signals& expected, const float learningRate) {
+			if (workspace.signals.size() != layerConnections.size() + 1)
+				throw std::runtime_error("Workspace does not hold signals of a pass through this network.");
+
+			if (actuals.size() != expected.size() || actuals.size() != workspace.signals.back().size())
+				throw std::runtime_error("Expected signals count is not equal to the neurons number in the last layer.");
+
+			auto& deltas = workspace.deltas;
+			{
+				NEURAL_NETWORK_PROFILE("NeuralNetwork", layerConnections.size() - 1, Backward, 2 * actuals.size(), sizeof(Signal) * 4 * actuals.size());
+				Expressions::assign(deltas.back(), (actuals - expected) * Expressions::map(workspace.signals.back(), sigmDxOf));
+			}
+			for (std::size_t l = layerConnections.size(); l-- > 0;) {
+				auto& layer = layerConnections[l];
+				// Errors of the input signals are of no use, so the first layer does not compute them.
+				const std::span<Error> errorsForPreviousLayer = l != 0 ? std::span<Error>(deltas[l]) : std::span<Error>();
+				{
+					// teachLayer computes the errors for the previous layer in the same pass, they are counted here too.
+					NEURAL_NETWORK_PROFILE("NeuralNetwork", l, Update, (l != 0 ? 5 : 3) * layer.weights.size(),
+										   sizeof(Weight) * (2 * layer.weights.size() + layer.neuronNumber + layer.nextLayerNeuronNumber));
+					teachLayer(layer, deltas[l + 1], workspace.signals[l], learningRate, errorsForPreviousLayer);
+				}
+				if (l != 0) {
+					NEURAL_NETWORK_PROFILE("NeuralNetwork", l - 1, Backward, layer.neuronNumber, sizeof(Signal) * 3 * layer.neuronNumber);
+					Expressions::assign(deltas[l], deltas[l] * Expressions::map(workspace.signals[l], sigmDxOf));
+				}
 			}
+		}
 
-			Errors errorsForNextLayer;
-			for (auto& newWeights : lastLayer.weights) {
-				errorsForNextLayer.push_back(newWeights * deltas);
+		void shapeWorkspace(Workspace& workspace) const {
+			if (workspace.signals.size() == layerConnections.size() + 1)
+				return;
+			workspace.signals.resize(layerConnections.size() + 1);
+			workspace.deltas.resize(layerConnections.size() + 1);
+			workspace.signals.front().resize(layerConnections.front().neuronNumber);
+			workspace.deltas.front().resize(layerConnections.front().neuronNumber);
+			for (std::size_t l = 0; l < layerConnections.size(); ++l) {
+				workspace.signals[l + 1].resize(layerConnections[l].nextLayerNeuronNumber);
+				workspace.deltas[l + 1].resize(layerConnections[l].nextLayerNeuronNumber);
 			}
+		}
+
+		/*!
+		* Corrects weights of the layer by its deltas and writes errors for the neurons of this layer
+		* into `errorsForPreviousLayer`, unless it is empty.
+		* Both passes walk the weight matrix row by row, so the memory is read sequentially.
+		*/
+		static void teachLayer(LayerConnection& layer, std::span<const Error> deltas, std::span<const Signal> layerInputs, const float learningRate,
+							   std::span<Error> errorsForPreviousLayer) {
+			auto& weights = layer.getWeights();
+			std::fill(errorsForPreviousLayer.begin(), errorsForPreviousLayer.end(), 0.f);
 
-			return errorsForNextLayer;
+			for (int i = 0; i < layer.nextLayerNeuronNumber; ++i) {
+				auto neuronWeights = weights.row(i);
+				Expressions::assign(neuronWeights, neuronWeights - layerInputs * deltas[i] * learningRate);
+				if (!errorsForPreviousLayer.empty())
+					Gemm::axpy(deltas[i], neuronWeights.data(), errorsForPreviousLayer.data(), errorsForPreviousLayer.size());
+			}
 		}
 
 	private:
-
 		std::vector<LayerConnection> layerConnections;
+		Workspace trainingWorkspace;
 	};
 }
\ No newline at end of file
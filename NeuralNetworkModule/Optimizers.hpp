@@ -0,0 +1,150 @@
+#pragma once
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <span>
+#include <vector>
+#include "Matrix.hpp"
+#include "Gemm.hpp"
+
+/*!
+* Rules for turning gradients into weight updates. An optimizer is given the gradients of one weight
+* buffer (a layer) summed over `samples` samples and updates the weights in a single fused pass,
+* reading and writing its own per-weight state in the same loop. The state of every buffer is one
+* contiguous array of the weights' shape, allocated on the first update of that buffer.
+*/
+namespace NeuralNetwork::Optimizers {
+	class IOptimizer {
+	public:
+		/*! Called once per optimization step, before the buffers of that step are updated. */
+		virtual void beginStep() {}
+
+		/*! `buffer` identifies the weights (e.g. the layer index), so that their state is found on the next step. */
+		virtual void update(std::size_t buffer, std::span<float> weights, std::span<const float> gradientsSum, std::size_t samples) = 0;
+
+		virtual ~IOptimizer() = default;
+	};
+
+	/*! Plain gradient descent with a fixed learning rate; has no state. */
+	class SGD final : public IOptimizer {
+	public:
+		explicit SGD(float learningRate) noexcept : learningRate(learningRate) {}
+
+		void update(std::size_t, std::span<float> weights, std::span<const float> gradientsSum, std::size_t samples) override {
+			Gemm::axpy(-learningRate / samples, gradientsSum.data(), weights.data(), weights.size());
+		}
+
+	private:
+		float learningRate;
+	};
+
+	namespace Detail {
+		/*! State arrays of an optimizer, `Arrays` per weight buffer. */
+		template<std::size_t Arrays>
+		class State {
+		public:
+			/*! Returns the state of `buffer`, zeroing it when the buffer is seen for the first time or changed its size. */
+			std::array<float*, Arrays> get(std::size_t buffer, std::size_t size) {
+				if (buffer >= buffers.size())
+					buffers.resize(buffer + 1);
+				auto& state = buffers[buffer];
+				if (state.size() != size * Arrays)
+					state.assign(size * Arrays, 0.f);
+				std::array<float*, Arrays> arrays;
+				for (std::size_t a = 0; a < Arrays; ++a) {
+					arrays[a] = state.data() + a * size;
+				}
+				return arrays;
+			}
+
+		private:
+			std::vector<AlignedVector<float>> buffers;
+		};
+	}
+
+	/*! SGD with momentum: v = momentum * v + g; w -= learningRate * v. */
+	class Momentum final : public IOptimizer {
+	public:
+		explicit Momentum(float learningRate, float momentum = 0.9f) noexcept : learningRate(learningRate), momentum(momentum) {}
+
+		void update(std::size_t buffer, std::span<float> weights, std::span<const float> gradientsSum, std::size_t samples) override {
+			const auto [velocities] = state.get(buffer, weights.size());
+			const float scale = 1.f / samples;
+			for (std::size_t i = 0; i < weights.size(); ++i) {
+				velocities[i] = momentum * velocities[i] + gradientsSum[i] * scale;
+				weights[i] -= learningRate * velocities[i];
+			}
+		}
+
+	private:
+		float learningRate;
+		float momentum;
+		Detail::State<1> state;
+	};
+
+	/*! Divides the step of every weight by the running root mean square of its gradients. */
+	class RMSProp final : public IOptimizer {
+	public:
+		explicit RMSProp(float learningRate, float decay = 0.9f, float epsilon = 1e-8f) noexcept
+			: learningRate(learningRate), decay(decay), epsilon(epsilon) {}
+
+		void update(std::size_t buffer, std::span<float> weights, std::span<const float> gradientsSum, std::size_t samples) override {
+			const auto [squares] = state.get(buffer, weights.size());
+			const float scale = 1.f / samples;
+			for (std::size_t i = 0; i < weights.size(); ++i) {
+				const float gradient = gradientsSum[i] * scale;
+				squares[i] = decay * squares[i] + (1.f - decay) * gradient * gradient;
+				weights[i] -= learningRate * gradient / (std::sqrt(squares[i]) + epsilon);
+			}
+		}
+
+	private:
+		float learningRate;
+		float decay;
+		float epsilon;
+		Detail::State<1> state;
+	};
+
+	/*!
+	* Adam: running means of gradients and of their squares with bias correction.
+	* The correction is folded into the step size once per step, so the per-weight loop stays short.
+	*/
+	class Adam final : public IOptimizer {
+	public:
+		explicit Adam(float learningRate, float beta1 = 0.9f, float beta2 = 0.999f, float epsilon = 1e-8f) noexcept
+			: learningRate(learningRate), beta1(beta1), beta2(beta2), epsilon(epsilon) {}
+
+		void beginStep() override {
+			++steps;
+			beta1Power *= beta1;
+			beta2Power *= beta2;
+		}
+
+		void update(std::size_t buffer, std::span<float> weights, std::span<const float> gradientsSum, std::size_t samples) override {
+			const auto [means, squares] = state.get(buffer, weights.size());
+			const float scale = 1.f / samples;
+			const float step = learningRate * std::sqrt(1.f - beta2Power) / (1.f - beta1Power);
+			const float correctedEpsilon = epsilon * std::sqrt(1.f - beta2Power);
+			for (std::size_t i = 0; i < weights.size(); ++i) {
+				const float gradient = gradientsSum[i] * scale;
+				means[i] = beta1 * means[i] + (1.f - beta1) * gradient;
+				squares[i] = beta2 * squares[i] + (1.f - beta2) * gradient * gradient;
+				weights[i] -= step * means[i] / (std::sqrt(squares[i]) + correctedEpsilon);
+			}
+		}
+
+		std::size_t getSteps() const noexcept {
+			return steps;
+		}
+
+	private:
+		float learningRate;
+		float beta1;
+		float beta2;
+		float epsilon;
+		std::size_t steps = 0;
+		float beta1Power = 1.f;
+		float beta2Power = 1.f;
+		Detail::State<2> state;
+	};
+}
@@ -0,0 +1,273 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+/*!
+* Opt-in instrumentation of training and inference. Defining NEURAL_NETWORK_PROFILING makes both networks
+* record, per layer and per phase, wall time, floating point operations, bytes of weights and signals
+* touched and heap allocations. Without it NEURAL_NETWORK_PROFILE expands to nothing and its arguments
+* are never evaluated, so the instrumentation costs nothing.
+*
+* FLOPs count multiplications and additions only; exp and other transcendental functions are not counted.
+* Allocations are counted by AlignedAllocator and by whoever calls Profiling::countAllocation,
+* e.g. a replaced global operator new.
+*
+* Every thread records into its own counters, so instrumented parallel training does not contend on a lock.
+* When a thread ends its counters are added to a total of ended threads and freed, so short-lived thread pools
+* (e.g. one per learn call) do not make memory or snapshot() grow over a long job.
+* Read the results with snapshot() once learn, backPropagation or trainBatch has returned.
+*/
+namespace NeuralNetwork::Profiling {
+	enum class Phase {
+		Forward, Backward, Update
+	};
+
+	inline const char* getPhaseName(Phase phase) noexcept {
+		switch (phase) {
+		case Phase::Forward:
+			return "forward";
+		case Phase::Backward:
+			return "backward";
+		default:
+			return "update";
+		}
+	}
+
+	struct Entry {
+		/*! Which network the layer belongs to, e.g. "NeuralNetwork" or "CognitiveNetwork". */
+		std::string_view network;
+		std::size_t layer = 0;
+		Phase phase = Phase::Forward;
+		std::uint64_t calls = 0;
+		std::uint64_t nanoseconds = 0;
+		std::uint64_t flops = 0;
+		std::uint64_t bytes = 0;
+		std::uint64_t allocations = 0;
+
+		/*! FLOPs per byte: low values mean the layer waits for memory, high ones that it waits for arithmetic. */
+		double getArithmeticIntensity() const noexcept {
+			return bytes > 0 ? static_cast<double>(flops) / bytes : 0;
+		}
+	};
+
+	namespace Detail {
+		inline thread_local std::uint64_t threadAllocations = 0;
+
+		/*! Counters of one thread. Only that thread writes them; relaxed atomics let snapshot read them at any time. */
+		struct ThreadCounters {
+			struct Counter {
+				std::string_view network;
+				std::size_t layer;
+				Phase phase;
+				std::atomic<std::uint64_t> calls{ 0 }, nanoseconds{ 0 }, flops{ 0 }, bytes{ 0 }, allocations{ 0 };
+			};
+
+			/*! Counters live in unique_ptrs, so they do not move when the vector grows while snapshot reads them. */
+			std::vector<std::unique_ptr<Counter>> counters;
+			std::mutex mutex;
+		};
+
+		class Registry {
+		public:
+			static Registry& getInstance() {
+				static Registry registry;
+				return registry;
+			}
+
+			/*! Counters of the calling thread, owned by the registry until the thread ends. */
+			ThreadCounters& getThreadCounters() {
+				thread_local const ThreadRegistration registration(*this);
+				return *registration.counters;
+			}
+
+			/*! Threads whose counters are kept separately, i.e. those that recorded something and have not ended. */
+			std::size_t getLiveThreadsNumber() {
+				std::lock_guard lock(mutex);
+				return threads.size();
+			}
+
+			std::vector<Entry> snapshot() {
+				std::lock_guard lock(mutex);
+				std::vector<Entry> entries = retired;
+				for (const auto& thread : threads) {
+					std::lock_guard threadLock(thread->mutex);
+					accumulate(entries, *thread);
+				}
+				std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+					return std::tie(a.network, a.layer, a.phase) < std::tie(b.network, b.layer, b.phase);
+				});
+				return entries;
+			}
+
+			void reset() {
+				std::lock_guard lock(mutex);
+				retired.clear();
+				for (const auto& thread : threads) {
+					std::lock_guard threadLock(thread->mutex);
+					for (const auto& counter : thread->counters) {
+						counter->calls = counter->nanoseconds = counter->flops = counter->bytes = counter->allocations = 0;
+					}
+				}
+			}
+
+		private:
+			/*! Adds the counters of a thread to the registry on its first record and retires them when it ends. */
+			struct ThreadRegistration {
+				explicit ThreadRegistration(Registry& registry) : registry(registry), counters(new ThreadCounters) {
+					std::lock_guard lock(registry.mutex);
+					registry.threads.emplace_back(counters);
+				}
+
+				ThreadRegistration(const ThreadRegistration&) = delete;
+				ThreadRegistration& operator=(const ThreadRegistration&) = delete;
+
+				~ThreadRegistration() {
+					registry.retire(counters);
+				}
+
+				Registry& registry;
+				ThreadCounters* counters;
+			};
+
+			static void accumulate(std::vector<Entry>& entries, const ThreadCounters& thread) {
+				for (const auto& counter : thread.counters) {
+					auto entry = std::find_if(entries.begin(), entries.end(), [&](const Entry& e) {
+						return e.network == counter->network && e.layer == counter->layer && e.phase == counter->phase;
+					});
+					if (entry == entries.end())
+						entry = entries.insert(entries.end(), Entry{ counter->network, counter->layer, counter->phase });
+					entry->calls += counter->calls.load(std::memory_order_relaxed);
+					entry->nanoseconds += counter->nanoseconds.load(std::memory_order_relaxed);
+					entry->flops += counter->flops.load(std::memory_order_relaxed);
+					entry->bytes += counter->bytes.load(std::memory_order_relaxed);
+					entry->allocations += counter->allocations.load(std::memory_order_relaxed);
+				}
+			}
+
+			/*! Adds the counters of an ending thread to `retired` and frees them. */
+			void retire(ThreadCounters* counters) {
+				std::lock_guard lock(mutex);
+				accumulate(retired, *counters);
+				std::erase_if(threads, [&](const auto& thread) { return thread.get() == counters; });
+			}
+
+			std::mutex mutex;
+			std::vector<std::unique_ptr<ThreadCounters>> threads;
+			/*! Sums of the counters of threads that have ended. */
+			std::vector<Entry> retired;
+		};
+
+		inline void add(std::atomic<std::uint64_t>& counter, std::uint64_t value) noexcept {
+			counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+		}
+
+		inline void record(std::string_view network, std::size_t layer, Phase phase, std::uint64_t nanoseconds,
+						   std::uint64_t flops, std::uint64_t bytes, std::uint64_t allocations) {
+			auto& thread = Registry::getInstance().getThreadCounters();
+			auto counter = std::find_if(thread.counters.begin(), thread.counters.end(), [&](const auto& c) {
+				return c->layer == layer && c->phase == phase && c->network == network;
+			});
+			if (counter == thread.counters.end()) {
+				auto created = std::make_unique<ThreadCounters::Counter>();
+				created->network = network;
+				created->layer = layer;
+				created->phase = phase;
+				std::lock_guard lock(thread.mutex);
+				counter = thread.counters.insert(thread.counters.end(), std::move(created));
+			}
+			add((*counter)->calls, 1);
+			add((*counter)->nanoseconds, nanoseconds);
+			add((*counter)->flops, flops);
+			add((*counter)->bytes, bytes);
+			add((*counter)->allocations, allocations);
+		}
+	}
+
+	/*! Counts one heap allocation of the calling thread towards the phase being measured. */
+	inline void countAllocation() noexcept {
+		++Detail::threadAllocations;
+	}
+
+	/*! Measures the time and allocations from its construction to its destruction. Use through NEURAL_NETWORK_PROFILE. */
+	class Scope {
+	public:
+		Scope(std::string_view network, std::size_t layer, Phase phase, std::uint64_t flops, std::uint64_t bytes) noexcept
+			: network(network), layer(layer), phase(phase), flops(flops), bytes(bytes),
+			  allocationsAtStart(Detail::threadAllocations), start(std::chrono::steady_clock::now()) {}
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+		~Scope() {
+			const auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+			Detail::record(network, layer, phase, static_cast<std::uint64_t>(nanoseconds), flops, bytes, Detail::threadAllocations - allocationsAtStart);
+		}
+
+	private:
+		std::string_view network;
+		std::size_t layer;
+		Phase phase;
+		std::uint64_t flops;
+		std::uint64_t bytes;
+		std::uint64_t allocationsAtStart;
+		std::chrono::steady_clock::time_point start;
+	};
+
+	/*! Counters of all threads summed per network, layer and phase. */
+	inline std::vector<Entry> snapshot() {
+		return Detail::Registry::getInstance().snapshot();
+	}
+
+	inline void reset() {
+		Detail::Registry::getInstance().reset();
+	}
+
+	inline void writeJson(std::ostream& stream, const std::vector<Entry>& entries) {
+		stream << "{\"layers\": [\n";
+		for (std::size_t i = 0; i < entries.size(); ++i) {
+			const auto& entry = entries[i];
+			stream << "  {\"network\": \"" << entry.network << "\", \"layer\": " << entry.layer << ", \"phase\": \"" << getPhaseName(entry.phase)
+				   << "\", \"calls\": " << entry.calls << ", \"nanoseconds\": " << entry.nanoseconds << ", \"flops\": " << entry.flops
+				   << ", \"bytes\": " << entry.bytes << ", \"allocations\": " << entry.allocations << '}' << (i + 1 < entries.size() ? "," : "") << '\n';
+		}
+		stream << "]}\n";
+	}
+
+	inline void writeTable(std::ostream& stream, const std::vector<Entry>& entries) {
+		stream << std::left << std::setw(20) << "network" << std::right << std::setw(6) << "layer" << std::setw(10) << "phase"
+			   << std::setw(12) << "calls" << std::setw(12) << "ms" << std::setw(10) << "GFLOP/s" << std::setw(10) << "GB/s"
+			   << std::setw(10) << "FLOP/B" << std::setw(10) << "allocs" << '\n';
+		for (const auto& entry : entries) {
+			const double seconds = entry.nanoseconds * 1e-9;
+			stream << std::left << std::setw(20) << entry.network << std::right << std::setw(6) << entry.layer
+				   << std::setw(10) << getPhaseName(entry.phase) << std::setw(12) << entry.calls << std::fixed << std::setprecision(3)
+				   << std::setw(12) << seconds * 1e3 << std::setprecision(2)
+				   << std::setw(10) << (seconds > 0 ? entry.flops / seconds * 1e-9 : 0)
+				   << std::setw(10) << (seconds > 0 ? entry.bytes / seconds * 1e-9 : 0)
+				   << std::setw(10) << entry.getArithmeticIntensity() << std::setw(10) << entry.allocations << '\n';
+		}
+	}
+}
+
+#define NEURAL_NETWORK_PROFILE_CONCAT_(a, b) a##b
+#define NEURAL_NETWORK_PROFILE_CONCAT(a, b) NEURAL_NETWORK_PROFILE_CONCAT_(a, b)
+
+#ifdef NEURAL_NETWORK_PROFILING
+/*! Profiles the rest of the enclosing block as `phase` (Forward, Backward or Update) of `layer` of `network`. */
+#define NEURAL_NETWORK_PROFILE(network, layer, phase, flops, bytes) \
+	const ::NeuralNetwork::Profiling::Scope NEURAL_NETWORK_PROFILE_CONCAT(profilingScope, __LINE__)( \
+		network, layer, ::NeuralNetwork::Profiling::Phase::phase, static_cast<std::uint64_t>(flops), static_cast<std::uint64_t>(bytes))
+#else
+#define NEURAL_NETWORK_PROFILE(network, layer, phase, flops, bytes) static_cast<void>(0)
+#endif
@@ -0,0 +1,116 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include "Matrix.hpp"
+#include "Kernels.hpp"
+
+/*!
+* Symmetric int8 quantization: a real value v is stored as round(v / scale) clamped to [-127, 127].
+* A product of a quantized weight row and a quantized signal vector is accumulated exactly in int32
+* and turned back into a float with a single multiplication by both scales.
+*/
+namespace NeuralNetwork::Quantization {
+	constexpr float INT8_LIMIT = 127.f;
+
+	enum class ScaleGranularity {
+		/*! One scale for the whole matrix. */
+		PerLayer,
+		/*! One scale per row, i.e. per neuron. Keeps small rows precise next to large ones. */
+		PerRow
+	};
+
+	inline float scaleFor(float maxAbsoluteValue) noexcept {
+		return maxAbsoluteValue > 0.f ? maxAbsoluteValue / INT8_LIMIT : 1.f;
+	}
+
+	inline std::int8_t quantize(float value, float scale) noexcept {
+		return static_cast<std::int8_t>(std::clamp(std::nearbyint(value / scale), -INT8_LIMIT, INT8_LIMIT));
+	}
+
+	/*! Quantizes `values` into `quantized` with a scale picked from their range and returns the scale. */
+	inline float quantizeSignals(std::span<const float> values, std::span<std::int8_t> quantized) {
+		if (values.size() != quantized.size())
+			throw std::runtime_error("Quantized signals buffer has a wrong size.");
+		float maxAbsoluteValue = 0.f;
+		for (float value : values) {
+			maxAbsoluteValue = std::max(maxAbsoluteValue, std::abs(value));
+		}
+		const float scale = scaleFor(maxAbsoluteValue);
+		for (std::size_t i = 0; i < values.size(); ++i) {
+			quantized[i] = quantize(values[i], scale);
+		}
+		return scale;
+	}
+
+	/*! Row-major int8 matrix with a scale per row (all rows share the value for ScaleGranularity::PerLayer). */
+	class QuantizedMatrix {
+	public:
+		QuantizedMatrix() noexcept : rowsNumber(0), colsNumber(0) {}
+
+		QuantizedMatrix(MatrixView<const float> matrix, ScaleGranularity granularity)
+			: rowsNumber(matrix.rows()), colsNumber(matrix.cols()), values(matrix.rows() * matrix.cols()), scales(matrix.rows()) {
+			float layerMax = 0.f;
+			for (std::size_t r = 0; r < rowsNumber; ++r) {
+				float rowMax = 0.f;
+				for (float value : matrix.row(r)) {
+					rowMax = std::max(rowMax, std::abs(value));
+				}
+				scales[r] = rowMax;
+				layerMax = std::max(layerMax, rowMax);
+			}
+			for (std::size_t r = 0; r < rowsNumber; ++r) {
+				scales[r] = scaleFor(granularity == ScaleGranularity::PerLayer ? layerMax : scales[r]);
+				const auto row = matrix.row(r);
+				for (std::size_t c = 0; c < colsNumber; ++c) {
+					values[r * colsNumber + c] = quantize(row[c], scales[r]);
+				}
+			}
+		}
+
+		std::size_t rows() const noexcept {
+			return rowsNumber;
+		}
+
+		std::size_t cols() const noexcept {
+			return colsNumber;
+		}
+
+		std::span<const std::int8_t> row(std::size_t index) const noexcept {
+			return { values.data() + index * colsNumber, colsNumber };
+		}
+
+		float getScale(std::size_t row) const noexcept {
+			return scales[row];
+		}
+
+		float dequantize(std::size_t row, std::size_t col) const noexcept {
+			return values[row * colsNumber + col] * scales[row];
+		}
+
+		/*! Bytes taken by the quantized values and their scales. */
+		std::size_t getMemorySize() const noexcept {
+			return values.size() * sizeof(std::int8_t) + scales.size() * sizeof(float);
+		}
+
+		/*! outputs[r] = row(r) . signals, where `signals` were quantized with `signalsScale`. */
+		void multiply(std::span<const std::int8_t> signals, float signalsScale, std::span<float> outputs) const {
+			if (signals.size() != colsNumber || outputs.size() != rowsNumber)
+				throw std::runtime_error("Signals do not match the quantized matrix.");
+			const auto dotInt8 = Kernels::getBestKernels().dotInt8;
+			for (std::size_t r = 0; r < rowsNumber; ++r) {
+				outputs[r] = static_cast<float>(dotInt8(values.data() + r * colsNumber, signals.data(), colsNumber)) * scales[r] * signalsScale;
+			}
+		}
+
+	private:
+		std::size_t rowsNumber;
+		std::size_t colsNumber;
+		AlignedVector<std::int8_t> values;
+		std::vector<float> scales;
+	};
+}
@@ -0,0 +1,189 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "FlatDataSet.hpp"
+
+/*!
+* Binary file of training samples, written and read sequentially so datasets can be far larger than RAM.
+*
+* Layout (little-endian):
+*   Header                       32 bytes, see SampleFile::Header
+*   samples                      inputsNumber inputs followed by expectedNumber expected outputs, as floats
+*
+* Samples are interleaved, so recorders can append them one at a time; Reader splits them into
+* the columns of a FlatDataSet chunk by chunk.
+*/
+namespace NeuralNetwork::SampleFile {
+	constexpr char MAGIC[8] = { 'N', 'N', 'S', 'A', 'M', 'P', 'L', '\0' };
+	constexpr std::uint32_t VERSION = 1;
+	constexpr std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+	/*! Size of the stream buffers: large sequential reads and writes instead of many small ones. */
+	constexpr std::size_t STREAM_BUFFER_SIZE = std::size_t(1) << 20;
+
+	struct Header {
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t byteOrder;
+		std::uint32_t inputsNumber;
+		std::uint32_t expectedNumber;
+		std::uint64_t samplesNumber;
+	};
+
+	static_assert(sizeof(Header) == 32, "Sample file header must not have padding.");
+
+	/*! Appends samples to a new file. The number of samples is written to the header by close or the destructor. */
+	class Writer {
+	public:
+		Writer(const std::filesystem::path& path, std::size_t inputsNumber, std::size_t expectedNumber)
+			: buffer(STREAM_BUFFER_SIZE), path(path) {
+			std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+			header.version = VERSION;
+			header.byteOrder = BYTE_ORDER_MARK;
+			header.inputsNumber = static_cast<std::uint32_t>(inputsNumber);
+			header.expectedNumber = static_cast<std::uint32_t>(expectedNumber);
+			header.samplesNumber = 0;
+
+			stream.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+			stream.open(path, std::ios::binary | std::ios::trunc);
+			if (!stream.write(reinterpret_cast<const char*>(&header), sizeof(Header)))
+				throw std::runtime_error("Cannot write sample file " + path.string());
+		}
+
+		Writer(const Writer&) = delete;
+		Writer& operator=(const Writer&) = delete;
+
+		~Writer() {
+			try {
+				close();
+			}
+			catch (const std::exception&) {
+			}
+		}
+
+		void write(std::span<const float> inputs, std::span<const float> expected) {
+			if (inputs.size() != header.inputsNumber || expected.size() != header.expectedNumber)
+				throw std::runtime_error("Sample has a different size than the sample file.");
+			stream.write(reinterpret_cast<const char*>(inputs.data()), inputs.size_bytes());
+			stream.write(reinterpret_cast<const char*>(expected.data()), expected.size_bytes());
+			if (!stream)
+				throw std::runtime_error("Cannot write sample file " + path.string());
+			++header.samplesNumber;
+		}
+
+		void write(const FlatDataSet& dataset) {
+			for (std::size_t n = 0; n < dataset.size(); ++n) {
+				write(dataset.getInputs(n), dataset.getExpected(n));
+			}
+		}
+
+		std::uint64_t getSamplesNumber() const noexcept {
+			return header.samplesNumber;
+		}
+
+		void close() {
+			if (!stream.is_open())
+				return;
+			stream.seekp(0);
+			stream.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+			stream.close();
+			if (!stream)
+				throw std::runtime_error("Cannot write sample file " + path.string());
+		}
+
+	private:
+		std::vector<char> buffer;
+		std::ofstream stream;
+		std::filesystem::path path;
+		Header header;
+	};
+
+	/*!
+	* Reads a sample file front to back in chunks, so only one chunk has to fit in memory.
+	* Reading into the same FlatDataSet again reuses its memory.
+	*/
+	class Reader {
+	public:
+		explicit Reader(const std::filesystem::path& path) : buffer(STREAM_BUFFER_SIZE), path(path) {
+			stream.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+			stream.open(path, std::ios::binary);
+			if (!stream.read(reinterpret_cast<char*>(&header), sizeof(Header)))
+				throw std::runtime_error("Cannot read sample file " + path.string());
+			if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0)
+				throw std::runtime_error("Not a sample file.");
+			if (header.byteOrder != BYTE_ORDER_MARK)
+				throw std::runtime_error("Sample file was written on a machine with a different byte order.");
+			if (header.version != VERSION)
+				throw std::runtime_error("Unsupported sample file version " + std::to_string(header.version) + ".");
+			if (header.inputsNumber == 0 || header.expectedNumber == 0)
+				throw std::runtime_error("Sample file has empty samples.");
+			if (std::filesystem::file_size(path) != sizeof(Header) + header.samplesNumber * getSampleSize() * sizeof(float))
+				throw std::runtime_error("Sample file is truncated.");
+		}
+
+		std::size_t getInputsNumber() const noexcept {
+			return header.inputsNumber;
+		}
+
+		std::size_t getExpectedNumber() const noexcept {
+			return header.expectedNumber;
+		}
+
+		std::uint64_t getSamplesNumber() const noexcept {
+			return header.samplesNumber;
+		}
+
+		/*! Goes back to the first sample, e.g. for the next epoch. */
+		void rewind() {
+			stream.clear();
+			stream.seekg(sizeof(Header));
+			samplesRead = 0;
+		}
+
+		/*!
+		* Replaces the contents of `chunk` with up to `maxSamples` next samples.
+		* Returns false, leaving `chunk` empty, when there are no samples left.
+		*/
+		bool read(FlatDataSet& chunk, std::size_t maxSamples) {
+			if (chunk.getInputsNumber() != header.inputsNumber || chunk.getExpectedNumber() != header.expectedNumber)
+				chunk = FlatDataSet(header.inputsNumber, header.expectedNumber);
+			chunk.clear();
+
+			const std::size_t samples = static_cast<std::size_t>(std::min<std::uint64_t>(maxSamples, header.samplesNumber - samplesRead));
+			if (samples == 0)
+				return false;
+
+			const std::size_t sampleSize = getSampleSize();
+			records.resize(samples * sampleSize);
+			if (!stream.read(reinterpret_cast<char*>(records.data()), records.size() * sizeof(float)))
+				throw std::runtime_error("Cannot read sample file " + path.string());
+
+			chunk.reserve(samples);
+			for (std::size_t n = 0; n < samples; ++n) {
+				const float* record = records.data() + n * sampleSize;
+				chunk.add({ record, header.inputsNumber }, { record + header.inputsNumber, header.expectedNumber });
+			}
+			samplesRead += samples;
+			return true;
+		}
+
+	private:
+		std::size_t getSampleSize() const noexcept {
+			return std::size_t(header.inputsNumber) + header.expectedNumber;
+		}
+
+	private:
+		std::vector<char> buffer;
+		std::ifstream stream;
+		std::filesystem::path path;
+		Header header;
+		std::uint64_t samplesRead = 0;
+		std::vector<float> records;
+	};
+}
@@ -0,0 +1,305 @@
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <span>
+#include <vector>
+#include <utility>
+#include <type_traits>
+
+/*!
+* Lazy element-wise vector algebra.
+* `a - b * c * 0.5f` does not compute anything by itself: it builds a small expression object
+* that remembers its operands. The whole expression is evaluated in a single loop when it is
+* assigned with `Expressions::assign` (no allocations at all) or converted to a std::vector
+* (exactly one allocation for the result).
+*
+* Operands can be std::vector, std::span, scalars or other expressions. Temporary vectors
+* are moved into the expression, so `auto e = v * makeVector();` does not dangle;
+* named vectors and spans are referenced and have to outlive the expression.
+*/
+namespace NeuralNetwork::Expressions {
+	/*! Base of all expression types, used only for detection. */
+	struct ExpressionBase {};
+
+	template<class T>
+	concept IsExpression = std::is_base_of_v<ExpressionBase, std::remove_cvref_t<T>>;
+
+	template<class T>
+	struct IsVectorType : std::false_type {};
+
+	template<class T, class Allocator>
+	struct IsVectorType<std::vector<T, Allocator>> : std::true_type {};
+
+	template<class T>
+	struct IsSpanType : std::false_type {};
+
+	template<class T, std::size_t Extent>
+	struct IsSpanType<std::span<T, Extent>> : std::true_type {};
+
+	template<class T>
+	concept VectorOperand = IsExpression<T>
+		|| IsVectorType<std::remove_cvref_t<T>>::value
+		|| IsSpanType<std::remove_cvref_t<T>>::value;
+
+	template<class T>
+	concept ScalarOperand = std::is_arithmetic_v<std::remove_cvref_t<T>>;
+
+	/*!
+	* Scalar that combines with the elements of V without changing their type: a float vector times 2 is fine,
+	* an int vector times 0.5f does not compile instead of silently becoming a multiplication by 0.
+	*/
+	template<class T, class V>
+	concept ScalarOperandFor = ScalarOperand<T>
+		&& std::is_same_v<std::common_type_t<std::remove_cvref_t<T>, typename std::remove_cvref_t<V>::value_type>,
+						  typename std::remove_cvref_t<V>::value_type>;
+
+	/*! Named vector or span: referenced, not copied. */
+	template<class T>
+	class Reference : public ExpressionBase {
+	public:
+		using value_type = T;
+		static constexpr bool isConstant = false;
+
+		Reference(const T* data, std::size_t size) noexcept : data(data), length(size) {}
+
+		T operator[](std::size_t index) const noexcept {
+			return data[index];
+		}
+
+		std::size_t size() const noexcept {
+			return length;
+		}
+
+	private:
+		const T* data;
+		std::size_t length;
+	};
+
+	/*! Temporary vector that was moved into the expression. */
+	template<class T, class Allocator>
+	class Owned : public ExpressionBase {
+	public:
+		using value_type = T;
+		static constexpr bool isConstant = false;
+
+		explicit Owned(std::vector<T, Allocator>&& values) noexcept : values(std::move(values)) {}
+
+		T operator[](std::size_t index) const noexcept {
+			return values[index];
+		}
+
+		std::size_t size() const noexcept {
+			return values.size();
+		}
+
+	private:
+		std::vector<T, Allocator> values;
+	};
+
+	/*! Scalar broadcast to every element. */
+	template<class T>
+	class Constant : public ExpressionBase {
+	public:
+		using value_type = T;
+		static constexpr bool isConstant = true;
+
+		explicit Constant(T value) noexcept : value(value) {}
+
+		T operator[](std::size_t) const noexcept {
+			return value;
+		}
+
+	private:
+		T value;
+	};
+
+	template<class Left, class Right, class Operation>
+	class BinaryExpression : public ExpressionBase {
+	public:
+		using value_type = std::conditional_t<Left::isConstant, typename Right::value_type, typename Left::value_type>;
+		static constexpr bool isConstant = false;
+
+		BinaryExpression(Left left, Right right) : left(std::move(left)), right(std::move(right)) {
+			if constexpr (!Left::isConstant && !Right::isConstant)
+				assert(BinaryExpression::left.size() == BinaryExpression::right.size());
+		}
+
+		value_type operator[](std::size_t index) const noexcept {
+			return Operation{}(left[index], right[index]);
+		}
+
+		std::size_t size() const noexcept {
+			if constexpr (Left::isConstant)
+				return right.size();
+			else
+				return left.size();
+		}
+
+		template<class Allocator>
+		operator std::vector<value_type, Allocator>() const {
+			std::vector<value_type, Allocator> result(size());
+			for (std::size_t i = 0; i < result.size(); ++i) {
+				result[i] = (*this)[i];
+			}
+			return result;
+		}
+
+	private:
+		Left left;
+		Right right;
+	};
+
+	template<class Argument, class Function>
+	class MapExpression : public ExpressionBase {
+	public:
+		using value_type = typename Argument::value_type;
+		static constexpr bool isConstant = false;
+
+		MapExpression(Argument argument, Function function) : argument(std::move(argument)), function(std::move(function)) {}
+
+		value_type operator[](std::size_t index) const {
+			return function(argument[index]);
+		}
+
+		std::size_t size() const noexcept {
+			return argument.size();
+		}
+
+		template<class Allocator>
+		operator std::vector<value_type, Allocator>() const {
+			std::vector<value_type, Allocator> result(size());
+			for (std::size_t i = 0; i < result.size(); ++i) {
+				result[i] = (*this)[i];
+			}
+			return result;
+		}
+
+	private:
+		Argument argument;
+		Function function;
+	};
+
+	/*! Wraps any supported operand into an expression node. */
+	template<class V>
+	auto makeOperand(V&& value) {
+		using Type = std::remove_cvref_t<V>;
+		if constexpr (IsExpression<Type>) {
+			return Type(std::forward<V>(value));
+		}
+		else if constexpr (IsSpanType<Type>::value) {
+			return Reference<std::remove_const_t<typename Type::element_type>>(value.data(), value.size());
+		}
+		else if constexpr (std::is_rvalue_reference_v<V&&>) {
+			return Owned<typename Type::value_type, typename Type::allocator_type>(std::move(value));
+		}
+		else {
+			return Reference<typename Type::value_type>(value.data(), value.size());
+		}
+	}
+
+	template<class Operation, class L, class R>
+	auto makeBinary(L&& left, R&& right) {
+		auto leftOperand = makeOperand(std::forward<L>(left));
+		auto rightOperand = makeOperand(std::forward<R>(right));
+		return BinaryExpression<decltype(leftOperand), decltype(rightOperand), Operation>(std::move(leftOperand), std::move(rightOperand));
+	}
+
+	template<class Operation, class L, class T>
+	auto makeBinaryWithScalar(L&& left, T value) {
+		auto leftOperand = makeOperand(std::forward<L>(left));
+		using ValueType = typename decltype(leftOperand)::value_type;
+		return BinaryExpression<decltype(leftOperand), Constant<ValueType>, Operation>(std::move(leftOperand), Constant<ValueType>(static_cast<ValueType>(value)));
+	}
+
+	template<class Operation, class T, class R>
+	auto makeBinaryWithScalarLeft(T value, R&& right) {
+		auto rightOperand = makeOperand(std::forward<R>(right));
+		using ValueType = typename decltype(rightOperand)::value_type;
+		return BinaryExpression<Constant<ValueType>, decltype(rightOperand), Operation>(Constant<ValueType>(static_cast<ValueType>(value)), std::move(rightOperand));
+	}
+
+	/*! Lazily applies `function` to every element. */
+	template<VectorOperand V, class Function>
+	auto map(V&& value, Function function) {
+		auto operand = makeOperand(std::forward<V>(value));
+		return MapExpression<decltype(operand), Function>(std::move(operand), std::move(function));
+	}
+
+	/*! Evaluates the expression into `destination` in one loop. `destination` may be one of the operands. */
+	template<class Destination, VectorOperand E>
+	void assign(Destination&& destination, E&& expression) {
+		const auto operand = makeOperand(std::forward<E>(expression));
+		assert(destination.size() == operand.size());
+		auto* data = destination.data();
+		const std::size_t size = destination.size();
+		for (std::size_t i = 0; i < size; ++i) {
+			data[i] = operand[i];
+		}
+	}
+
+	struct Plus {
+		template<class T>
+		T operator()(T a, T b) const noexcept { return a + b; }
+	};
+
+	struct Minus {
+		template<class T>
+		T operator()(T a, T b) const noexcept { return a - b; }
+	};
+
+	struct Multiplies {
+		template<class T>
+		T operator()(T a, T b) const noexcept { return a * b; }
+	};
+
+	struct Divides {
+		template<class T>
+		T operator()(T a, T b) const noexcept { return a / b; }
+	};
+
+	template<VectorOperand L, VectorOperand R>
+	auto operator+(L&& left, R&& right) {
+		return makeBinary<Plus>(std::forward<L>(left), std::forward<R>(right));
+	}
+
+	template<VectorOperand L, ScalarOperandFor<L> T>
+	auto operator+(L&& left, T value) {
+		return makeBinaryWithScalar<Plus>(std::forward<L>(left), value);
+	}
+
+	template<VectorOperand L, VectorOperand R>
+	auto operator-(L&& left, R&& right) {
+		return makeBinary<Minus>(std::forward<L>(left), std::forward<R>(right));
+	}
+
+	template<VectorOperand L, ScalarOperandFor<L> T>
+	auto operator-(L&& left, T value) {
+		return makeBinaryWithScalar<Minus>(std::forward<L>(left), value);
+	}
+
+	template<VectorOperand L, VectorOperand R>
+	auto operator*(L&& left, R&& right) {
+		return makeBinary<Multiplies>(std::forward<L>(left), std::forward<R>(right));
+	}
+
+	template<VectorOperand L, ScalarOperandFor<L> T>
+	auto operator*(L&& left, T value) {
+		return makeBinaryWithScalar<Multiplies>(std::forward<L>(left), value);
+	}
+
+	template<VectorOperand R, ScalarOperandFor<R> T>
+	auto operator*(T value, R&& right) {
+		return makeBinaryWithScalarLeft<Multiplies>(value, std::forward<R>(right));
+	}
+
+	template<VectorOperand L, ScalarOperandFor<L> T>
+	auto operator/(L&& left, T value) {
+		return makeBinaryWithScalar<Divides>(std::forward<L>(left), value);
+	}
+}
+
+/*! Makes the operators visible for std::vector and std::span operands, which ADL would not find. */
+using NeuralNetwork::Expressions::operator+;
+using NeuralNetwork::Expressions::operator-;
+using NeuralNetwork::Expressions::operator*;
+using NeuralNetwork::Expressions::operator/;
@@ -1,8 +1,110 @@
 #include "pch.h"
 #include "NeuralNetwork.hpp"
+#include "FixedNetwork.hpp"
+#include "CognitiveSystem.hpp"
+#include "QuantizedCognitiveSystem.hpp"
+#include "FlatDataSet.hpp"
+#include "SampleFile.hpp"
+#include "Training.hpp"
+#include "SensorSystem.hpp"
+#include "Entities.hpp"
+#include "Simulator.hpp"
+#include "ObjectPool.hpp"
+#include "Evolution.hpp"
+#include "Headless.hpp"
+#include "Snapshot.hpp"
+#include <thread>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <random>
+#include <algorithm>
 
 //constexpr float MUL_CONST = 1000;
 
+/*! Counts heap allocations of the whole test binary, see the ZeroAllocation test. */
+static std::atomic<size_t> allocationsCount = 0;
+
+namespace {
+	/*!
+	* Every form of operator new ends up here, aligned ones (AlignedAllocator, so Matrix and AlignedVector) included.
+	* The pointer returned by malloc is kept right before the block, so every form of operator delete frees it the same way.
+	*/
+	void* allocate(std::size_t size, std::size_t alignment) {
+		++allocationsCount;
+#ifdef NEURAL_NETWORK_PROFILING
+		NeuralNetwork::Profiling::countAllocation();
+#endif
+		alignment = std::max(alignment, std::size_t(__STDCPP_DEFAULT_NEW_ALIGNMENT__));
+		void* block = std::malloc(size + alignment);
+		if (!block)
+			throw std::bad_alloc();
+		const auto address = (reinterpret_cast<std::uintptr_t>(block) + alignment) & ~(std::uintptr_t(alignment) - 1);
+		auto* pointer = reinterpret_cast<void*>(address);
+		static_cast<void**>(pointer)[-1] = block;
+		return pointer;
+	}
+
+	void deallocate(void* pointer) noexcept {
+		if (pointer)
+			std::free(static_cast<void**>(pointer)[-1]);
+	}
+}
+
+void* operator new(std::size_t size) {
+	return allocate(size, 0);
+}
+
+void* operator new[](std::size_t size) {
+	return allocate(size, 0);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+	return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+	return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* pointer) noexcept {
+	deallocate(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+	deallocate(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+	deallocate(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept {
+	deallocate(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept {
+	deallocate(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept {
+	deallocate(pointer);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept {
+	deallocate(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept {
+	deallocate(pointer);
+}
+
 TEST(LayerConnection_getOutputs, NEURAL_NETWORK_TESTS) {
 	using namespace std;
 	NeuralNetwork::LayerConnection layer(4, 3);
@@ -30,4 +132,1199 @@ TEST(NeuralNetwork_feedForward, NEURAL_NETWORK_TESTS) {
 	for (auto res : resultAfter)
 		std::cout << res << std::endl;
 	EXPECT_TRUE(true);
-}
\ No newline at end of file
+}
+
+TEST(NeuralNetwork_backPropagation, NEURAL_NETWORK_TESTS) {
+	NeuralNetwork::NeuralNetwork network{ 3, 2, 2, 1 };
+	std::vector<NeuralNetwork::Signal> inputs{ 1.f, 2.f, 3.f };
+	std::vector<NeuralNetwork::Signal> expected{ 1.f };
+
+	auto before = network.feedForward(inputs);
+	network.backPropagation(before, expected, 0.1f);
+	auto after = network.feedForward(inputs);
+
+	EXPECT_LT(std::abs(after[0] - expected[0]), std::abs(before[0] - expected[0]));
+}
+
+TEST(Kernels_vectorizedMatchScalar, NEURAL_NETWORK_TESTS) {
+	using namespace NeuralNetwork::Kernels;
+	std::vector<float> weights(103), inputs(103), values(103);
+	for (int i = 0; i < 103; ++i) {
+		weights[i] = std::sin(i * 0.37f) * 4.f;
+		inputs[i] = std::cos(i * 0.11f) * 3.f;
+		values[i] = (i - 51) * 0.5f;
+	}
+
+	const auto scalar = getKernels(InstructionSet::Scalar);
+	const float expectedSum = scalar.sumOfSigmoidProducts(weights.data(), inputs.data(), weights.size());
+	const float expectedDot = scalar.dot(weights.data(), inputs.data(), weights.size());
+	auto expectedSigmoid = values;
+	scalar.sigmoid(expectedSigmoid.data(), expectedSigmoid.size());
+
+	for (auto instructionSet : { InstructionSet::Avx2, InstructionSet::Avx512 }) {
+		if (!isSupported(instructionSet))
+			continue;
+		const auto kernels = getKernels(instructionSet);
+		EXPECT_NEAR(kernels.sumOfSigmoidProducts(weights.data(), inputs.data(), weights.size()), expectedSum, std::abs(expectedSum) * KERNEL_TOLERANCE);
+		EXPECT_NEAR(kernels.dot(weights.data(), inputs.data(), weights.size()), expectedDot, std::abs(expectedDot) * KERNEL_TOLERANCE);
+		auto actualSigmoid = values;
+		kernels.sigmoid(actualSigmoid.data(), actualSigmoid.size());
+		for (size_t i = 0; i < values.size(); ++i)
+			EXPECT_NEAR(actualSigmoid[i], expectedSigmoid[i], KERNEL_TOLERANCE);
+
+		// Rows shorter than a vector are done by the masked tails alone, which must not touch what follows.
+		auto shortSigmoid = values;
+		kernels.sigmoid(shortSigmoid.data(), 5);
+		EXPECT_NEAR(shortSigmoid[4], expectedSigmoid[4], KERNEL_TOLERANCE);
+		EXPECT_EQ(shortSigmoid[5], values[5]);
+		EXPECT_NEAR(kernels.sumOfSigmoidProducts(weights.data(), inputs.data(), 5), scalar.sumOfSigmoidProducts(weights.data(), inputs.data(), 5),
+					KERNEL_TOLERANCE * 5);
+	}
+}
+
+TEST(NeuralNetwork_trainBatch, NEURAL_NETWORK_TESTS) {
+	NeuralNetwork::NeuralNetwork network{ 3, 4, 2 };
+	// Not a multiple of the rows the batched kernel handles at once, so the remaining rows are checked too.
+	NeuralNetwork::Matrix<NeuralNetwork::Signal> inputs(7, 3), expected(7, 2, 1.f);
+	NeuralNetwork::BatchWorkspace workspace;
+	for (size_t n = 0; n < inputs.rows(); ++n)
+		for (size_t j = 0; j < inputs.cols(); ++j)
+			inputs(n, j) = 0.1f * (n + j);
+
+	const auto error = [&] {
+		auto outputs = network.feedForward(inputs);
+		const auto& workspaceOutputs = network.feedForward(inputs.view(), workspace);
+		float sum = 0.f;
+		for (size_t n = 0; n < outputs.rows(); ++n) {
+			auto single = network.feedForward(std::vector<NeuralNetwork::Signal>(inputs.row(n).begin(), inputs.row(n).end()));
+			for (size_t i = 0; i < outputs.cols(); ++i) {
+				EXPECT_NEAR(outputs(n, i), single[i], 1e-4f);
+				EXPECT_EQ(workspaceOutputs(n, i), outputs(n, i));
+				sum += std::abs(outputs(n, i) - expected(n, i));
+			}
+		}
+		return sum;
+	};
+
+	const float before = error();
+	network.trainBatch(inputs, expected, 0.1f);
+	EXPECT_LT(error(), before);
+}
+
+TEST(CognitiveNeuralNetwork_trainBatch, NEURAL_NETWORK_TESTS) {
+	CognitiveSystems::NeuralNetwork network(CognitiveSystems::Topology(2, { 3 }, 1));
+	CognitiveSystems::NeuralNetwork::Batch inputs(4, 2), expected(4, 1);
+	const float samples[4][3] = { {0.f, 0.f, 0.2f}, {0.f, 1.f, 0.4f}, {1.f, 0.f, 0.4f}, {1.f, 1.f, 0.6f} };
+	for (size_t n = 0; n < 4; ++n) {
+		inputs(n, 0) = samples[n][0];
+		inputs(n, 1) = samples[n][1];
+		expected(n, 0) = samples[n][2];
+	}
+
+	auto outputs = network.feedForward(inputs);
+	for (size_t n = 0; n < 4; ++n)
+		EXPECT_NEAR(outputs(n, 0), network.feedForward({ inputs(n, 0), inputs(n, 1) })[0], 1e-5f);
+
+	const float before = network.trainBatch(inputs, expected, 0.5f)[0];
+	float after = before;
+	for (int epoch = 0; epoch < 20; ++epoch)
+		after = network.trainBatch(inputs, expected, 0.5f)[0];
+	EXPECT_LT(after, before);
+}
+
+template<class V, class T>
+concept CanScale = requires(V vector, T scalar) { vector * scalar; scalar * vector; vector / scalar; };
+
+TEST(VectorExpressions_assign, NEURAL_NETWORK_TESTS) {
+	std::vector<float> weights{ 1.f, 2.f, 3.f };
+	const std::vector<float> inputs{ 1.f, 0.f, -1.f };
+	const std::vector<float> deltas{ 2.f, 2.f, 2.f };
+
+	NeuralNetwork::Expressions::assign(weights, weights - inputs * deltas * 0.5f);
+	EXPECT_EQ(weights, (std::vector<float>{ 0.f, 2.f, 4.f }));
+
+	auto lazy = inputs * std::vector<float>{ 3.f, 3.f, 3.f } + 1.f;
+	std::vector<float> evaluated = lazy;
+	EXPECT_EQ(evaluated, (std::vector<float>{ 4.f, 1.f, -2.f }));
+
+	// Scalars that would be truncated to the element type are rejected.
+	static_assert(CanScale<std::vector<float>, int> && CanScale<std::vector<float>, float> && CanScale<std::vector<int>, int>);
+	static_assert(!CanScale<std::vector<int>, float> && !CanScale<std::vector<int>, double> && !CanScale<std::vector<float>, double>);
+}
+
+TEST(NeuralNetwork_concurrentInference, NEURAL_NETWORK_TESTS) {
+	const NeuralNetwork::NeuralNetwork network{ 8, 16, 4 };
+	const CognitiveSystems::NeuralNetwork brain(CognitiveSystems::Topology(8, { 16 }, 4));
+
+	std::vector<NeuralNetwork::Signal> inputs(8);
+	for (int i = 0; i < 8; ++i)
+		inputs[i] = 0.1f * i;
+
+	NeuralNetwork::Workspace workspace;
+	const auto expected = network.feedForward(inputs, workspace);
+	CognitiveSystems::Workspace brainWorkspace;
+	const auto brainExpected = brain.feedForward(inputs, brainWorkspace);
+
+	std::vector<std::thread> threads;
+	std::vector<int> mismatches(4, 0);
+	for (int t = 0; t < 4; ++t) {
+		threads.emplace_back([&, t] {
+			auto threadWorkspace = network.createWorkspace();
+			CognitiveSystems::Workspace threadBrainWorkspace;
+			for (int i = 0; i < 1000; ++i) {
+				mismatches[t] += network.feedForward(inputs, threadWorkspace) != expected;
+				mismatches[t] += brain.feedForward(inputs, threadBrainWorkspace) != brainExpected;
+			}
+		});
+	}
+	for (auto& thread : threads)
+		thread.join();
+
+	for (int mismatch : mismatches)
+		EXPECT_EQ(mismatch, 0);
+}
+
+TEST(CognitiveNeuralNetwork_parallelLearnIsDeterministic, NEURAL_NETWORK_TESTS) {
+	CognitiveSystems::NeuralNetwork::DataSet dataset;
+	for (int i = 0; i < 200; ++i) {
+		const float x = (i % 20) * 0.05f, y = (i / 20) * 0.1f;
+		dataset.emplace_back(std::vector<float>{ x, y }, std::vector<float>{ 0.5f * (x + y) });
+	}
+
+	CognitiveSystems::ParallelTrainingOptions options;
+	options.batchSize = 64;
+	options.shardSize = 8;
+
+	std::vector<std::vector<float>> results;
+	for (size_t threads : { 1, 3 }) {
+		CognitiveSystems::NeuralNetwork network(CognitiveSystems::Topology(2, { 4 }, 1));
+		options.threadsNumber = threads;
+		const auto statistics = network.learn(dataset, 3, 0.5f, options);
+		EXPECT_EQ(statistics.samples, 600);
+		CognitiveSystems::Workspace workspace;
+		results.push_back(network.feedForward({ 0.3f, 0.4f }, workspace));
+	}
+	EXPECT_EQ(results[0], results[1]);
+}
+
+TEST(CognitiveLayer_neuronViews, NEURAL_NETWORK_TESTS) {
+	CognitiveSystems::NeuralNetwork network(CognitiveSystems::Topology(2, { 3 }, 1));
+	const auto outputs = network.feedForward({ 0.2f, 0.7f });
+
+	auto& layers = network.getLayers();
+	const auto& hidden = layers[1];
+	ASSERT_EQ(hidden.getSize(), 3);
+	size_t index = 0;
+	for (auto neuron : hidden.getNeurons()) {
+		EXPECT_EQ(neuron.getWeights().data(), hidden.getWeights().row(index).data());
+		EXPECT_FLOAT_EQ(neuron.getOutput(), hidden.getOutputs()[index]);
+		EXPECT_FLOAT_EQ(neuron.activate(hidden.getInputs()), hidden.getOutputs()[index]);
+		++index;
+	}
+	EXPECT_EQ(index, hidden.getSize());
+	EXPECT_FLOAT_EQ(layers.back().getOutputs()[0], outputs[0]);
+}
+
+TEST(ModelFile_saveAndMap, NEURAL_NETWORK_TESTS) {
+	const auto directory = std::filesystem::temp_directory_path();
+	const auto networkPath = directory / "neural_network_model_test.bin";
+	const auto brainPath = directory / "cognitive_network_model_test.bin";
+
+	NeuralNetwork::NeuralNetwork network({ 3, 5, 2 });
+	for (int i = 0; i < 20; ++i) {
+		auto outputs = network.feedForward({ 0.1f, 0.4f, 0.9f });
+		network.backPropagation(outputs, { 0.3f, 0.6f }, 0.05f);
+	}
+	network.save(networkPath);
+
+	CognitiveSystems::NeuralNetwork brain(CognitiveSystems::Topology(3, { 4, 4 }, 2));
+	brain.backPropagation({ 0.2f, 0.7f }, { 0.1f, 0.4f, 0.9f }, 0.5f);
+	brain.save(brainPath);
+
+	const std::vector<float> inputs{ 0.5f, 0.2f, 0.8f };
+	{
+		auto loaded = NeuralNetwork::NeuralNetwork::load(networkPath);
+		auto workspace = network.createWorkspace();
+		auto loadedWorkspace = loaded.createWorkspace();
+		EXPECT_EQ(loaded.feedForward(inputs, loadedWorkspace), network.feedForward(inputs, workspace));
+
+		auto loadedBrain = CognitiveSystems::NeuralNetwork::load(brainPath);
+		EXPECT_EQ(loadedBrain.getTopology().getHiddenLayers(), std::vector<int>({ 4, 4 }));
+		EXPECT_TRUE(loadedBrain.getLayers()[1].getWeights().isWrapped());
+		CognitiveSystems::Workspace brainWorkspace, loadedBrainWorkspace;
+		EXPECT_EQ(loadedBrain.feedForward(inputs, loadedBrainWorkspace), brain.feedForward(inputs, brainWorkspace));
+
+		// Training a mapped network must not change the file.
+		loadedBrain.backPropagation({ 0.9f, 0.9f }, inputs, 0.5f);
+		EXPECT_NE(loadedBrain.feedForward(inputs, loadedBrainWorkspace), brain.feedForward(inputs, brainWorkspace));
+		auto reloadedBrain = CognitiveSystems::NeuralNetwork::load(brainPath);
+		EXPECT_EQ(reloadedBrain.feedForward(inputs, loadedBrainWorkspace), brain.feedForward(inputs, brainWorkspace));
+
+		EXPECT_THROW(CognitiveSystems::NeuralNetwork::load(networkPath), std::runtime_error);
+	}
+
+	{
+		std::fstream file(networkPath, std::ios::in | std::ios::out | std::ios::binary);
+		file.seekp(-4, std::ios::end);
+		file.write("\x7f\x7f\x7f\x7f", 4);
+	}
+	EXPECT_NO_THROW(NeuralNetwork::NeuralNetwork::load(networkPath));
+	EXPECT_THROW(NeuralNetwork::NeuralNetwork::load(networkPath, true), std::runtime_error);
+
+	{
+		// A layer record whose weights would end past the file, with an offset near the end of the address space.
+		std::fstream file(networkPath, std::ios::in | std::ios::out | std::ios::binary);
+		const std::uint64_t offset = ~std::uint64_t(0) / NeuralNetwork::CACHE_LINE_SIZE * NeuralNetwork::CACHE_LINE_SIZE;
+		const std::uint32_t shape[2] = { 8, 4 };
+		file.seekp(sizeof(NeuralNetwork::ModelFile::Header) + offsetof(NeuralNetwork::ModelFile::LayerRecord, rows));
+		file.write(reinterpret_cast<const char*>(shape), sizeof(shape));
+		file.seekp(sizeof(NeuralNetwork::ModelFile::Header) + offsetof(NeuralNetwork::ModelFile::LayerRecord, offset));
+		file.write(reinterpret_cast<const char*>(&offset), sizeof(offset));
+	}
+	EXPECT_THROW(NeuralNetwork::ModelFile::MappedModel(networkPath, NeuralNetwork::ModelFile::ModelKind::LayerConnections), std::runtime_error);
+
+	std::filesystem::remove(networkPath);
+	std::filesystem::remove(brainPath);
+}
+
+TEST(QuantizedNeuralNetwork_drift, NEURAL_NETWORK_TESTS) {
+	std::vector<std::int8_t> a(75), b(75);
+	for (int i = 0; i < 75; ++i) {
+		a[i] = static_cast<std::int8_t>((i * 37) % 255 - 127);
+		b[i] = static_cast<std::int8_t>((i * 91) % 255 - 127);
+	}
+	const auto expectedDot = NeuralNetwork::Kernels::Scalar::dotInt8(a.data(), b.data(), a.size());
+	for (auto set : { NeuralNetwork::Kernels::InstructionSet::Avx2, NeuralNetwork::Kernels::InstructionSet::Avx512 }) {
+		if (NeuralNetwork::Kernels::isSupported(set)) {
+			EXPECT_EQ(NeuralNetwork::Kernels::getKernels(set).dotInt8(a.data(), b.data(), a.size()), expectedDot);
+		}
+	}
+
+	CognitiveSystems::NeuralNetwork::DataSet dataset;
+	std::vector<std::vector<float>> inputs;
+	for (int i = 0; i < 64; ++i) {
+		std::vector<float> sample{ (i % 8) * 0.1f, (i / 8) * 0.1f, ((i * 5) % 7) * 0.1f };
+		dataset.emplace_back(sample, std::vector<float>{ 0.2f + 0.5f * sample[0], 0.8f - 0.5f * sample[1] });
+		inputs.push_back(sample);
+	}
+	CognitiveSystems::NeuralNetwork network(CognitiveSystems::Topology(3, { 64, 64 }, 2));
+	CognitiveSystems::ParallelTrainingOptions options;
+	options.threadsNumber = 1;
+	options.batchSize = 16;
+	network.learn(dataset, 20, 0.5f, options);
+
+	for (auto granularity : { CognitiveSystems::ScaleGranularity::PerLayer, CognitiveSystems::ScaleGranularity::PerRow }) {
+		const CognitiveSystems::QuantizedNeuralNetwork quantized(network, granularity);
+		const auto report = quantized.compare(network, inputs);
+		EXPECT_EQ(report.samples, inputs.size());
+		EXPECT_LT(report.maxAbsoluteError, 0.02f);
+		EXPECT_LT(report.quantizedWeightsBytes * 3, report.floatWeightsBytes);
+	}
+}
+
+TEST(NeuralNetwork_trainingStepDoesNotAllocate, NEURAL_NETWORK_TESTS) {
+	const std::vector<float> inputs{ 0.1f, 0.5f, 0.3f, 0.9f };
+	const std::vector<float> expected{ 0.2f, 0.7f };
+
+	NeuralNetwork::NeuralNetwork network({ 4, 8, 8, 2 });
+	auto workspace = network.createWorkspace();
+	NeuralNetwork::BatchWorkspace networkBatchWorkspace;
+	CognitiveSystems::NeuralNetwork brain(CognitiveSystems::Topology(4, { 8, 8 }, 2));
+
+	NeuralNetwork::Matrix<float> batchInputs(16, 4, 0.3f), batchExpected(16, 2, 0.6f);
+	auto gradients = brain.createGradients();
+	CognitiveSystems::BatchWorkspace batchWorkspace;
+
+	// Aligned allocations, those of Matrix and of the workspaces, are counted too.
+	size_t allocationsBefore = allocationsCount;
+	{
+		NeuralNetwork::Matrix<float> matrix(4, 4);
+		std::unique_ptr<int[]> array(new int[4]);
+	}
+	EXPECT_EQ(allocationsCount - allocationsBefore, 2);
+
+	auto step = [&] {
+		network.feedForward(inputs, workspace);
+		network.backPropagation(workspace, expected, 0.1f);
+		network.feedForward(batchInputs.view(), networkBatchWorkspace);
+		brain.trainStep(expected, inputs, 0.1f);
+		brain.computeGradients(batchInputs, batchExpected, gradients, batchWorkspace);
+	};
+	step();
+
+	allocationsBefore = allocationsCount;
+	for (int i = 0; i < 100; ++i) {
+		step();
+	}
+	EXPECT_EQ(allocationsCount - allocationsBefore, 0);
+}
+
+TEST(FixedNetwork_matchesNeuralNetwork, NEURAL_NETWORK_TESTS) {
+	using Brain = NeuralNetwork::FixedNetwork<3, 5, 4, 2>;
+	static_assert(std::is_trivially_copyable_v<Brain>);
+	static_assert(sizeof(Brain) == (3 * 5 + 5 * 4 + 4 * 2) * sizeof(float));
+
+	NeuralNetwork::NeuralNetwork network({ 3, 5, 4, 2 });
+	auto workspace = network.createWorkspace();
+	for (int i = 0; i < 10; ++i) {
+		network.feedForward({ 0.1f * i, 0.4f, 0.9f }, workspace);
+		network.backPropagation(workspace, { 0.3f, 0.6f }, 0.05f);
+	}
+
+	auto brain = Brain::fromNetwork(network);
+	Brain::Workspace brainWorkspace;
+	for (int i = 0; i < 10; ++i) {
+		const std::vector<float> inputs{ 0.5f, 0.05f * i, 0.2f };
+		const auto& expected = network.feedForward(inputs, workspace);
+		const auto actual = brain.feedForward({ inputs[0], inputs[1], inputs[2] }, brainWorkspace);
+		for (size_t k = 0; k < expected.size(); ++k) {
+			EXPECT_NEAR(actual[k], expected[k], std::abs(expected[k]) * NeuralNetwork::Kernels::KERNEL_TOLERANCE * 10);
+		}
+
+		network.backPropagation(workspace, { 0.7f, 0.2f }, 0.05f);
+		brain.backPropagation(brainWorkspace, { 0.7f, 0.2f }, 0.05f);
+	}
+	EXPECT_NEAR(brain.getWeight(1, 3, 2), network.getLayerConnections()[1].getWeight(3, 2), 1e-4f);
+
+	using SmallerBrain = NeuralNetwork::FixedNetwork<3, 4, 2>;
+	EXPECT_THROW(SmallerBrain::fromNetwork(network), std::runtime_error);
+}
+
+template<class Activation>
+static void expectDerivativeFromOutput(std::initializer_list<float> xs, float tolerance) {
+	constexpr float step = 1e-3f;
+	for (float x : xs) {
+		const float numeric = (Activation::activate(x + step) - Activation::activate(x - step)) / (2 * step);
+		EXPECT_NEAR(Activation::derivative(Activation::activate(x)), numeric, tolerance) << x;
+	}
+}
+
+TEST(Activations_policies, NEURAL_NETWORK_TESTS) {
+	namespace Activations = NeuralNetwork::Activations;
+	float maxError = 0.f;
+	for (double x = -20.0; x <= 20.0; x += 1e-3) {
+		const double exact = 1.0 / (1.0 + std::exp(-x));
+		maxError = std::max(maxError, static_cast<float>(std::abs(Activations::FastSigmoid::activate(static_cast<float>(x)) - exact)));
+	}
+	EXPECT_LT(maxError, Activations::FastSigmoid::MAX_ERROR);
+	std::vector<float> values{ -20.f, -3.3f, -0.1f, 0.f, 0.4f, 2.7f, 9.f, 20.f, 1.1f };
+	auto activated = values;
+	Activations::FastSigmoid::activate(activated.data(), activated.size());
+	for (size_t i = 0; i < values.size(); ++i)
+		EXPECT_NEAR(activated[i], 1.0 / (1.0 + std::exp(-values[i])), Activations::FastSigmoid::MAX_ERROR);
+
+	static_assert(Activations::LeakyReLU<0.2f>::IDENTIFIER != Activations::LeakyReLU<0.01f>::IDENTIFIER);
+	static_assert(Activations::LeakyReLU<>::IDENTIFIER > Activations::ReLU::IDENTIFIER);
+
+	const auto xs = { -3.f, -0.7f, -0.1f, 0.2f, 1.5f, 4.f };
+	expectDerivativeFromOutput<Activations::Sigmoid>(xs, 1e-3f);
+	expectDerivativeFromOutput<Activations::FastSigmoid>(xs, 1e-2f);
+	expectDerivativeFromOutput<Activations::Tanh>(xs, 1e-3f);
+	expectDerivativeFromOutput<Activations::ReLU>(xs, 1e-3f);
+	expectDerivativeFromOutput<Activations::LeakyReLU<0.1f>>(xs, 1e-3f);
+
+	using TanhNetwork = CognitiveSystems::BasicNeuralNetwork<Activations::Tanh>;
+	TanhNetwork network(CognitiveSystems::Topology(2, { 3 }, 1));
+	TanhNetwork::Batch inputs(4, 2), expected(4, 1);
+	const float samples[4][3] = { {0.f, 0.f, -0.4f}, {0.f, 1.f, 0.2f}, {1.f, 0.f, 0.2f}, {1.f, 1.f, 0.6f} };
+	for (size_t n = 0; n < 4; ++n) {
+		inputs(n, 0) = samples[n][0];
+		inputs(n, 1) = samples[n][1];
+		expected(n, 0) = samples[n][2];
+	}
+	EXPECT_NEAR(network.feedForward(inputs)(3, 0), std::tanh(3 * std::tanh(2.f)), 1e-5f);
+
+	const float before = network.trainBatch(inputs, expected, 0.1f)[0];
+	float after = before;
+	for (int epoch = 0; epoch < 20; ++epoch)
+		after = network.trainBatch(inputs, expected, 0.1f)[0];
+	EXPECT_LT(after, before);
+
+	const auto path = std::filesystem::temp_directory_path() / "tanh_network_model_test.bin";
+	network.save(path);
+	EXPECT_NO_THROW(TanhNetwork::load(path));
+	EXPECT_THROW(CognitiveSystems::NeuralNetwork::load(path), std::runtime_error);
+	CognitiveSystems::BasicNeuralNetwork<Activations::LeakyReLU<0.2f>>(CognitiveSystems::Topology(2, { 3 }, 1)).save(path);
+	EXPECT_NO_THROW(CognitiveSystems::BasicNeuralNetwork<Activations::LeakyReLU<0.2f>>::load(path));
+	EXPECT_THROW(CognitiveSystems::BasicNeuralNetwork<Activations::LeakyReLU<0.01f>>::load(path), std::runtime_error);
+	std::filesystem::remove(path);
+}
+
+TEST(FlatDataSet_streamingLearnMatchesInMemory, NEURAL_NETWORK_TESTS) {
+	CognitiveSystems::NeuralNetwork::DataSet dataset;
+	for (int i = 0; i < 200; ++i) {
+		const float x = (i % 20) * 0.05f, y = (i / 20) * 0.1f;
+		dataset.emplace_back(std::vector<float>{ x, y }, std::vector<float>{ 0.5f * (x + y) });
+	}
+	const auto flatDataset = NeuralNetwork::FlatDataSet::from(dataset);
+	ASSERT_EQ(flatDataset.size(), dataset.size());
+	EXPECT_EQ(flatDataset.getInputs(21)[1], std::get<0>(dataset[21])[1]);
+	EXPECT_EQ(flatDataset.getExpected(10, 20)(3, 0), std::get<1>(dataset[13])[0]);
+
+	const auto path = std::filesystem::temp_directory_path() / "flat_dataset_samples_test.bin";
+	{
+		NeuralNetwork::SampleFile::Writer writer(path, 2, 1);
+		writer.write(flatDataset);
+	}
+
+	CognitiveSystems::ParallelTrainingOptions options;
+	options.threadsNumber = 2;
+	options.batchSize = 32;
+	options.shardSize = 8;
+	options.streamingChunkSize = 64;
+
+	CognitiveSystems::NeuralNetwork tuples(CognitiveSystems::Topology(2, { 4 }, 1));
+	CognitiveSystems::NeuralNetwork flat(CognitiveSystems::Topology(2, { 4 }, 1));
+	CognitiveSystems::NeuralNetwork streamed(CognitiveSystems::Topology(2, { 4 }, 1));
+	const auto expected = tuples.learn(dataset, 2, 0.5f, options);
+	const auto flatStatistics = flat.learn(flatDataset, 2, 0.5f, options);
+	NeuralNetwork::SampleFile::Reader reader(path);
+	EXPECT_EQ(reader.getSamplesNumber(), dataset.size());
+	const auto streamedStatistics = streamed.learn(reader, 2, 0.5f, options);
+
+	EXPECT_EQ(flatStatistics.samples, expected.samples);
+	EXPECT_EQ(streamedStatistics.samples, expected.samples);
+	EXPECT_EQ(streamedStatistics.errors, expected.errors);
+	for (size_t l = 0; l < tuples.getLayers().size(); ++l) {
+		const auto& weights = tuples.getLayers()[l].getWeights();
+		for (size_t i = 0; i < weights.size(); ++i) {
+			EXPECT_EQ(flat.getLayers()[l].getWeights().getData()[i], weights.getData()[i]);
+			EXPECT_EQ(streamed.getLayers()[l].getWeights().getData()[i], weights.getData()[i]);
+		}
+	}
+
+	std::filesystem::resize_file(path, std::filesystem::file_size(path) - 4);
+	EXPECT_THROW(NeuralNetwork::SampleFile::Reader{ path }, std::runtime_error);
+	std::filesystem::remove(path);
+}
+
+TEST(Optimizers_reduceErrorAndKeepSGD, NEURAL_NETWORK_TESTS) {
+	namespace Optimizers = NeuralNetwork::Optimizers;
+	CognitiveSystems::NeuralNetwork::Batch inputs(16, 2), expected(16, 1);
+	for (size_t n = 0; n < 16; ++n) {
+		inputs(n, 0) = (n % 4) * 0.25f;
+		inputs(n, 1) = (n / 4) * 0.25f;
+		expected(n, 0) = 0.2f + 0.3f * inputs(n, 0) + 0.4f * inputs(n, 1) * inputs(n, 1);
+	}
+
+	// SGD through the interface is exactly the learning rate overload.
+	CognitiveSystems::NeuralNetwork plain(CognitiveSystems::Topology(2, { 4 }, 1)), viaOptimizer = plain;
+	Optimizers::SGD sgd(0.5f);
+	for (int step = 0; step < 5; ++step) {
+		EXPECT_EQ(plain.trainBatch(inputs, expected, 0.5f), viaOptimizer.trainBatch(inputs, expected, sgd));
+	}
+
+	// The first Adam step moves every weight with a gradient by the learning rate.
+	CognitiveSystems::NeuralNetwork network(CognitiveSystems::Topology(2, { 4 }, 1));
+	const auto weightsBefore = network.getLayers()[2].getWeights();
+	Optimizers::Adam adam(0.01f);
+	network.trainBatch(inputs, expected, adam);
+	EXPECT_EQ(adam.getSteps(), 1);
+	for (size_t i = 0; i < weightsBefore.size(); ++i) {
+		EXPECT_NEAR(std::abs(network.getLayers()[2].getWeights().getData()[i] - weightsBefore.getData()[i]), 0.01f, 1e-5f);
+	}
+
+	Optimizers::Momentum momentum(0.5f);
+	Optimizers::RMSProp rmsProp(0.01f);
+	Optimizers::Adam freshAdam(0.01f);
+	for (Optimizers::IOptimizer* optimizer : std::initializer_list<Optimizers::IOptimizer*>{ &momentum, &rmsProp, &freshAdam }) {
+		CognitiveSystems::NeuralNetwork trained(CognitiveSystems::Topology(2, { 4 }, 1));
+		const float before = trained.trainBatch(inputs, expected, *optimizer)[0];
+		float after = before;
+		for (int step = 0; step < 50; ++step)
+			after = trained.trainBatch(inputs, expected, *optimizer)[0];
+		EXPECT_LT(after, before * 0.5f);
+	}
+
+	NeuralNetwork::NeuralNetwork moduleNetwork({ 2, 3, 1 });
+	Optimizers::Adam moduleAdam(0.01f);
+	const auto moduleBefore = moduleNetwork.feedForward({ 0.5f, 0.5f })[0];
+	for (int step = 0; step < 10; ++step)
+		moduleNetwork.trainBatch(inputs, expected, moduleAdam);
+	EXPECT_LT(std::abs(moduleNetwork.feedForward({ 0.5f, 0.5f })[0] - 0.5f), std::abs(moduleBefore - 0.5f));
+
+	CognitiveSystems::NeuralNetwork::DataSet dataset{ { { 0.f, 1.f }, { 0.5f } } };
+	CognitiveSystems::ParallelTrainingOptions options;
+	options.hogwild = true;
+	options.optimizer = &adam;
+	EXPECT_THROW(network.learn(dataset, 1, 0.1f, options), std::runtime_error);
+}
+
+TEST(Trainer_earlyStoppingRestoresBestWeights, NEURAL_NETWORK_TESTS) {
+	NeuralNetwork::FlatDataSet training(2, 1), validation(2, 1);
+	for (int i = 0; i < 100; ++i) {
+		const float x = (i % 10) * 0.1f, y = (i / 10) * 0.1f;
+		const float target = 0.2f + 0.3f * x + 0.4f * y * y;
+		(i % 5 == 0 ? validation : training).add(std::vector<float>{ x, y }, std::vector<float>{ target });
+	}
+
+	CognitiveSystems::TrainingOptions options;
+	options.maxEpochs = 1000;
+	options.patience = 3;
+	options.minImprovement = 1e-4f;
+	options.parallel.threadsNumber = 2;
+	options.parallel.batchSize = 16;
+	options.parallel.shardSize = 8;
+	std::vector<CognitiveSystems::EpochReport> reports;
+	options.onEpoch = [&](const CognitiveSystems::EpochReport& report) { reports.push_back(report); };
+
+	CognitiveSystems::NeuralNetwork network(CognitiveSystems::Topology(2, { 4 }, 1));
+	const float initialLoss = network.evaluate(validation)[0];
+	CognitiveSystems::Trainer trainer(options);
+	const auto result = trainer.train(network, training, validation, 2.f);
+
+	EXPECT_TRUE(result.stoppedEarly);
+	EXPECT_LT(result.epochs, options.maxEpochs);
+	ASSERT_EQ(reports.size(), result.epochs);
+	EXPECT_EQ(reports.back().epochsWithoutImprovement, options.patience);
+	EXPECT_EQ(result.bestEpoch, result.epochs - options.patience);
+	EXPECT_FLOAT_EQ(reports[result.bestEpoch - 1].validationLoss, result.bestValidationLoss);
+	EXPECT_FLOAT_EQ(network.evaluate(validation)[0], result.bestValidationLoss);
+	EXPECT_LT(result.bestValidationLoss, initialLoss);
+
+	options.targetLoss = initialLoss * 0.5f;
+	options.onEpoch = nullptr;
+	CognitiveSystems::NeuralNetwork targeted(CognitiveSystems::Topology(2, { 4 }, 1));
+	const auto targetedResult = CognitiveSystems::Trainer(options).train(targeted, training, validation, 2.f);
+	EXPECT_TRUE(targetedResult.reachedTarget);
+	EXPECT_LE(targetedResult.bestValidationLoss, options.targetLoss);
+
+	// The parallel learn reports every epoch and stops when asked to.
+	auto parallel = options.parallel;
+	std::vector<size_t> epochs;
+	parallel.onEpoch = [&](size_t epoch, const std::vector<float>& errors) {
+		epochs.push_back(epoch);
+		EXPECT_EQ(errors.size(), 1u);
+		return epoch < 3;
+	};
+	const auto statistics = targeted.learn(training, 10, 1.f, parallel);
+	EXPECT_EQ(epochs, std::vector<size_t>({ 1, 2, 3 }));
+	EXPECT_EQ(statistics.samples, 3 * training.size());
+
+	// backPropagation returns squared differences.
+	CognitiveSystems::NeuralNetwork stepped(CognitiveSystems::Topology(2, { 4 }, 1)), propagated = stepped;
+	const float diff = stepped.trainStep({ 0.3f }, { 0.5f, 0.5f }, 0.1f)[0];
+	EXPECT_FLOAT_EQ(propagated.backPropagation({ 0.3f }, { 0.5f, 0.5f }, 0.1f)[0], diff * diff);
+}
+
+TEST(Profiling_scopesAndExport, NEURAL_NETWORK_TESTS) {
+	namespace Profiling = NeuralNetwork::Profiling;
+	Profiling::reset();
+	for (int i = 0; i < 3; ++i) {
+		const Profiling::Scope scope("TestNetwork", 1, Profiling::Phase::Backward, 100, 50);
+		Profiling::countAllocation();
+	}
+	// Counters of threads that ended are kept as a total, not per thread.
+	const auto liveThreads = NeuralNetwork::Profiling::Detail::Registry::getInstance().getLiveThreadsNumber();
+	std::thread([] { const Profiling::Scope scope("TestNetwork", 1, Profiling::Phase::Backward, 100, 50); }).join();
+	EXPECT_EQ(NeuralNetwork::Profiling::Detail::Registry::getInstance().getLiveThreadsNumber(), liveThreads);
+	{
+		const Profiling::Scope scope("TestNetwork", 0, Profiling::Phase::Forward, 10, 40);
+	}
+
+	const auto entries = Profiling::snapshot();
+	const auto find = [&](std::size_t layer, Profiling::Phase phase) {
+		return std::find_if(entries.begin(), entries.end(), [&](const Profiling::Entry& entry) {
+			return entry.network == "TestNetwork" && entry.layer == layer && entry.phase == phase;
+		});
+	};
+	const auto backward = find(1, Profiling::Phase::Backward);
+	ASSERT_NE(backward, entries.end());
+	EXPECT_EQ(backward->calls, 4);
+	EXPECT_EQ(backward->flops, 400);
+	EXPECT_EQ(backward->bytes, 200);
+	EXPECT_EQ(backward->allocations, 3);
+	EXPECT_DOUBLE_EQ(backward->getArithmeticIntensity(), 2.0);
+	ASSERT_NE(find(0, Profiling::Phase::Forward), entries.end());
+	EXPECT_LT(find(0, Profiling::Phase::Forward), backward);
+
+	std::ostringstream json, table;
+	Profiling::writeJson(json, entries);
+	Profiling::writeTable(table, entries);
+	EXPECT_NE(json.str().find("{\"network\": \"TestNetwork\", \"layer\": 1, \"phase\": \"backward\", \"calls\": 4"), std::string::npos);
+	EXPECT_NE(table.str().find("backward"), std::string::npos);
+
+#ifndef NEURAL_NETWORK_PROFILING
+	// Disabled instrumentation does not even evaluate its arguments.
+	int evaluated = 0;
+	NEURAL_NETWORK_PROFILE("TestNetwork", 0, Forward, ++evaluated, ++evaluated);
+	EXPECT_EQ(evaluated, 0);
+#endif
+}
+
+TEST(SpatialGrid_radiusQueryMatchesBruteForce, NEURAL_NETWORK_TESTS) {
+	std::mt19937 random(18);
+	std::uniform_int_distribution<int> coordinate(-1000, 1000);
+	std::vector<Objects::Food> foods;
+	foods.reserve(500);
+	Positioning::SpatialGrid grid(100);
+	for (int i = 0; i < 500; ++i) {
+		foods.emplace_back(1).setLocation(coordinate(random), coordinate(random));
+		grid.insert(foods.back());
+	}
+	EXPECT_EQ(grid.size(), 500);
+	EXPECT_EQ(foods[0].getY(), foods[0].getCoordinates().y);
+
+	const auto bruteForce = [&](const Positioning::Coordinates& center, double radius) {
+		std::vector<Positioning::Object2D*> found;
+		for (auto& food : foods) {
+			if (food.getDistance(center) <= radius)
+				found.push_back(&food);
+		}
+		return found;
+	};
+	const auto sorted = [](std::vector<Positioning::Object2D*> objects) {
+		std::sort(objects.begin(), objects.end());
+		return objects;
+	};
+
+	// Objects crossing cell borders, also around 0 where the cells are rounded towards negative infinity.
+	for (int step = 0; step < 20; ++step) {
+		for (size_t i = 0; i < foods.size(); i += 3) {
+			foods[i].move(coordinate(random) / 10, coordinate(random) / 10);
+		}
+		foods[step].setLocation(-step, step - 10);
+
+		const Positioning::Coordinates center{ coordinate(random), coordinate(random) };
+		for (double radius : { 0.0, 99.0, 100.0, 250.0, 333.5 }) {
+			std::vector<Positioning::Object2D*> found;
+			grid.query(center, radius, found);
+			EXPECT_EQ(sorted(found), sorted(bruteForce(center, radius)));
+		}
+	}
+
+	SensorSystems::SimpleSensorSystem sensorSystem;
+	std::vector<Positioning::Object2D> copies(foods.begin(), foods.end());
+	const Positioning::Coordinates position{ 10, -20 };
+	EXPECT_EQ(sensorSystem.analyze(position, grid).size(), sensorSystem.analyze(position, copies).size());
+
+	// Copies are not in the grid, destroyed objects leave it.
+	EXPECT_EQ(grid.size(), 500);
+	foods.pop_back();
+	EXPECT_EQ(grid.size(), 499);
+	grid.remove(foods[0]);
+	grid.remove(foods[0]);
+	EXPECT_EQ(grid.size(), 498);
+	std::vector<Positioning::Object2D*> all;
+	grid.query({ 0, 0 }, 10000, all);
+	EXPECT_EQ(all.size(), 498);
+}
+
+TEST(Entities_handlesAndSystems, NEURAL_NETWORK_TESTS) {
+	Entities::World world;
+	const auto worm = world.createWorm({ 0, 0 }, { 100, 5, 30, 10, 20 });
+	const auto victim = world.createWorm({ 3, 4 }, { 50, 1, 10, 1, 0 });
+	const auto apple = world.createFood({ 1, 1 }, 40);
+	const auto wall = world.createWall({ -5, 0 });
+	EXPECT_EQ(world.size(), 4);
+	EXPECT_EQ(world.getKind(apple), Entities::Kind::Food);
+	EXPECT_EQ(world.getCoordinates(victim).y, 4);
+
+	// Interactions are dispatched by kind, food is eaten and destroyed.
+	Entities::Systems::interact(world, worm, victim);
+	EXPECT_EQ(world.getWorms().health[world.getRow(victim)], 20);
+	Entities::Systems::interact(world, victim, worm);
+	EXPECT_EQ(world.getWorms().health[world.getRow(worm)], 90);
+	Entities::Systems::interact(world, worm, apple);
+	EXPECT_FALSE(world.isAlive(apple));
+	EXPECT_THROW(world.getRow(apple), std::runtime_error);
+	EXPECT_EQ(world.getWorms().health[world.getRow(worm)], 100);
+	EXPECT_EQ(world.getWorms().energy[world.getRow(worm)], 20 + 40 - Entities::Systems::ENERGY_REQUIRED_FOR_REGENERATION);
+
+	// A reused slot does not revive old handles.
+	const auto pear = world.createFood({ 7, 7 }, 1);
+	EXPECT_EQ(pear.index, apple.index);
+	EXPECT_NE(pear, apple);
+	EXPECT_FALSE(world.isAlive(apple));
+	EXPECT_EQ(world.getCoordinates(pear).x, 7);
+
+	// Column systems.
+	auto& worms = world.getWorms();
+	Entities::Systems::steerTowards(worms, world.getRow(worm), world.getCoordinates(wall));
+	Entities::Systems::steerTowards(worms, world.getRow(victim), { 3, 100 });
+	Entities::Systems::move(worms);
+	EXPECT_EQ(world.getCoordinates(worm).x, -5);
+	EXPECT_EQ(world.getCoordinates(worm).y, 0);
+	EXPECT_EQ(world.getCoordinates(victim).y, 5);
+	worms.health[world.getRow(worm)] = 95;
+	worms.health[world.getRow(victim)] = 10;
+	Entities::Systems::regenerate(worms);
+	EXPECT_EQ(worms.health[world.getRow(worm)], 100);
+	EXPECT_EQ(worms.energy[world.getRow(worm)], 46 - Entities::Systems::ENERGY_REQUIRED_FOR_REGENERATION);
+	EXPECT_EQ(worms.health[world.getRow(victim)], 10);
+
+	// Destroying a row moves the last one into it, handles follow.
+	const auto third = world.createWorm({ 9, 9 }, {});
+	worms.health[world.getRow(worm)] = 0;
+	EXPECT_EQ(Entities::Systems::removeDead(world), 1);
+	EXPECT_FALSE(world.isAlive(worm));
+	EXPECT_EQ(worms.size(), 2);
+	EXPECT_EQ(world.getCoordinates(third).x, 9);
+	EXPECT_EQ(world.getCoordinates(victim).x, 3);
+	EXPECT_EQ(world.size(), 4);
+}
+
+TEST(Simulator_tickIsDeterministic, NEURAL_NETWORK_TESTS) {
+	const auto createWorld = [](Entities::World& world) {
+		std::mt19937 random(20);
+		std::uniform_int_distribution<int> coordinate(-2000, 2000);
+		std::uniform_int_distribution<int> trait(1, 20);
+		for (int i = 0; i < 2000; ++i) {
+			world.createWorm({ coordinate(random), coordinate(random) }, { 5 * trait(random), trait(random), trait(random), trait(random), 50 });
+		}
+		for (int i = 0; i < 3000; ++i) {
+			world.createFood({ coordinate(random), coordinate(random) }, trait(random));
+		}
+		for (int i = 0; i < 100; ++i) {
+			world.createWall({ coordinate(random), coordinate(random) });
+		}
+	};
+	Entities::World sequentialWorld, parallelWorld;
+	createWorld(sequentialWorld);
+	createWorld(parallelWorld);
+	Entities::Simulator sequential(1, { 250.0, 64 });
+	Entities::Simulator parallel(4, { 250.0, 7 });
+
+	Entities::TickStatistics total;
+	for (int tick = 0; tick < 60; ++tick) {
+		const auto expected = sequential.tick(sequentialWorld);
+		const auto actual = parallel.tick(parallelWorld);
+		EXPECT_EQ(actual.eaten, expected.eaten);
+		EXPECT_EQ(actual.attacks, expected.attacks);
+		EXPECT_EQ(actual.died, expected.died);
+		total.eaten += actual.eaten;
+		total.died += actual.died;
+	}
+	EXPECT_GT(total.eaten, 0);
+	EXPECT_GT(total.died, 0);
+
+	const auto& expected = sequentialWorld.getWorms();
+	const auto& actual = parallelWorld.getWorms();
+	EXPECT_EQ(actual.entities, expected.entities);
+	EXPECT_EQ(actual.x, expected.x);
+	EXPECT_EQ(actual.y, expected.y);
+	EXPECT_EQ(actual.health, expected.health);
+	EXPECT_EQ(actual.energy, expected.energy);
+	EXPECT_EQ(parallelWorld.getFood().entities, sequentialWorld.getFood().entities);
+
+	Entities::CellIndex index;
+	index.build(parallelWorld, 100);
+	EXPECT_EQ(index.size(), parallelWorld.size());
+	for (size_t row = 0; row < actual.size(); row += 97) {
+		const auto center = actual.getCoordinates(row);
+		std::vector<Entities::Sighting> found;
+		index.query(center, 150.0, found);
+		size_t expectedFound = 0;
+		for (size_t food = 0; food < parallelWorld.getFood().size(); ++food) {
+			expectedFound += center.getDistance(parallelWorld.getFood().getCoordinates(food)) <= 150.0;
+		}
+		for (size_t worm = 0; worm < actual.size(); ++worm) {
+			expectedFound += center.getDistance(actual.getCoordinates(worm)) <= 150.0;
+		}
+		for (size_t wall = 0; wall < parallelWorld.getWalls().size(); ++wall) {
+			expectedFound += center.getDistance(parallelWorld.getWalls().getCoordinates(wall)) <= 150.0;
+		}
+		EXPECT_EQ(found.size(), expectedFound);
+	}
+}
+
+TEST(Simulator_resolvesConflicts, NEURAL_NETWORK_TESTS) {
+	Entities::World world;
+	const auto far = world.createWorm({ -3, 0 }, { 100, 3, 10, 1, 0 });
+	const auto near = world.createWorm({ 2, 0 }, { 100, 3, 10, 1, 0 });
+	const auto apple = world.createFood({ 0, 0 }, 30);
+	const auto lonely = world.createWorm({ 1000, 1000 }, { 100, 3, 10, 1, 0 });
+
+	Entities::Simulator simulator(2, { 10.0, 1 });
+	const auto statistics = simulator.tick(world);
+	EXPECT_EQ(simulator.getTargets()[world.getRow(far)], apple);
+	EXPECT_EQ(simulator.getTargets()[world.getRow(near)], apple);
+	EXPECT_EQ(simulator.getTargets()[world.getRow(lonely)], Entities::Entity{});
+	// Both reached the apple, the one that was closer eats it.
+	EXPECT_EQ(statistics.eaten, 1);
+	EXPECT_FALSE(world.isAlive(apple));
+	EXPECT_EQ(world.getWorms().energy[world.getRow(near)], 30);
+	EXPECT_EQ(world.getWorms().energy[world.getRow(far)], 0);
+
+	// Without food they attack each other at the same time.
+	const auto statisticsOfFight = simulator.tick(world);
+	EXPECT_EQ(statisticsOfFight.attacks, 2);
+	EXPECT_EQ(world.getWorms().health[world.getRow(near)], 90);
+	EXPECT_EQ(world.getWorms().health[world.getRow(far)], 90);
+}
+
+TEST(Simulator_batchedBrainsMatchPerWormInference, NEURAL_NETWORK_TESTS) {
+	constexpr auto FEATURES = static_cast<int>(Entities::Senses::FEATURES_NUMBER);
+	constexpr auto ACTIONS = static_cast<int>(Entities::Senses::ACTIONS_NUMBER);
+	CognitiveSystems::NeuralNetwork hunter(CognitiveSystems::Topology(FEATURES, { 16 }, ACTIONS));
+	CognitiveSystems::NeuralNetwork wanderer(CognitiveSystems::Topology(FEATURES, { 8, 8 }, ACTIONS));
+	// Same topology as the hunter, other weights: its worms share batches with the hunter's.
+	CognitiveSystems::NeuralNetwork stalker(CognitiveSystems::Topology(FEATURES, { 16 }, ACTIONS));
+	std::mt19937 weightsRandom(1);
+	std::uniform_real_distribution<float> weight(-2.f, 2.f);
+	for (auto* brain : { &hunter, &wanderer, &stalker }) {
+		for (auto& layer : brain->getModifiableLayers()) {
+			auto& weights = layer.getModifiableWeights();
+			std::generate(weights.getData(), weights.getData() + weights.size(), [&] { return weight(weightsRandom); });
+		}
+	}
+
+	const auto createWorld = [](Entities::World& world) {
+		std::mt19937 random(21);
+		std::uniform_int_distribution<int> coordinate(-1500, 1500);
+		for (int i = 0; i < 1500; ++i) {
+			Entities::WormTraits traits{ 100, 5, 10, 1, 50 };
+			traits.brain = i % 3;
+			world.createWorm({ coordinate(random), coordinate(random) }, traits);
+			world.createFood({ coordinate(random), coordinate(random) }, 10);
+		}
+		world.createWall({ 0, 0 });
+	};
+
+	Entities::World world, parallelWorld;
+	createWorld(world);
+	createWorld(parallelWorld);
+	Entities::Simulator simulator(1, { 250.0, 100 });
+	Entities::Simulator parallel(3, { 250.0, 100 });
+	simulator.setBrains({ &hunter, &wanderer, &stalker });
+	parallel.setBrains({ &hunter, &wanderer, &stalker });
+	EXPECT_THROW(simulator.setBrains({ &hunter, nullptr }), std::runtime_error);
+
+	// Decisions of the batched pass are those of every worm's own forward pass.
+	Entities::CellIndex index;
+	index.build(world, 250);
+	const auto& worms = world.getWorms();
+	std::vector<std::array<Entities::Sighting, Entities::Senses::KINDS_NUMBER>> nearest(worms.size());
+	std::vector<std::vector<float>> features(worms.size(), std::vector<float>(FEATURES));
+	for (size_t row = 0; row < worms.size(); ++row) {
+		std::vector<Entities::Sighting> perception;
+		index.query(worms.getCoordinates(row), 250.0, perception);
+		std::erase_if(perception, [&](const Entities::Sighting& sighting) { return sighting.entity == worms.entities[row]; });
+		Entities::Senses::extract(worms, row, perception, 250.0, features[row], nearest[row]);
+	}
+	simulator.tick(world);
+	parallel.tick(parallelWorld);
+
+	CognitiveSystems::Workspace workspace;
+	size_t moving = 0;
+	for (size_t row = 0; row < worms.size(); ++row) {
+		const auto& brain = worms.brain[row] == 0 ? hunter : worms.brain[row] == 1 ? wanderer : stalker;
+		const auto scores = brain.feedForward(features[row], workspace);
+		auto expected = Entities::Entity{};
+		float best = scores[static_cast<size_t>(Entities::Senses::Action::Stay)];
+		for (size_t kind = 0; kind < Entities::Senses::KINDS_NUMBER; ++kind) {
+			if (nearest[row][kind].entity.index != Entities::Entity::INVALID_INDEX && scores[kind] > best) {
+				best = scores[kind];
+				expected = nearest[row][kind].entity;
+			}
+		}
+		EXPECT_EQ(simulator.getTargets()[row], expected);
+		moving += expected.index != Entities::Entity::INVALID_INDEX;
+	}
+	EXPECT_GT(moving, 0);
+
+	for (int tick = 0; tick < 20; ++tick) {
+		simulator.tick(world);
+		parallel.tick(parallelWorld);
+	}
+	EXPECT_EQ(parallelWorld.getWorms().x, world.getWorms().x);
+	EXPECT_EQ(parallelWorld.getWorms().energy, world.getWorms().energy);
+
+	world.createWorm({ 0, 0 }, { 100, 5, 10, 1, 50, 3 });
+	EXPECT_THROW(simulator.tick(world), std::runtime_error);
+}
+
+TEST(ObjectPool_handlesAndReuse, NEURAL_NETWORK_TESTS) {
+	Utils::ObjectPool<Objects::Food, 4> pool;
+	Positioning::SpatialGrid grid(10);
+	std::vector<Utils::ObjectPool<Objects::Food, 4>::Handle> handles;
+	for (int i = 0; i < 10; ++i) {
+		handles.push_back(pool.spawn(i + 1));
+		auto* food = pool.get(handles.back());
+		food->setLocation(i, 0);
+		grid.insert(*food);
+	}
+	EXPECT_EQ(pool.size(), 10);
+	EXPECT_EQ(pool.getCapacity(), 12);
+	// New slabs don't move objects that are already in the pool.
+	const auto* first = pool.get(handles[0]);
+	for (int i = 0; i < 100; ++i) {
+		pool.despawn(pool.spawn(1));
+	}
+	EXPECT_EQ(pool.get(handles[0]), first);
+	EXPECT_EQ(pool.getCapacity(), 12);
+	EXPECT_EQ(pool.getHandle(*pool.get(handles[3])), handles[3]);
+
+	// Eaten food is reclaimed and leaves the grid, handles to it become stale.
+	EXPECT_EQ(pool.get(handles[2])->getNutrition(), 3);
+	EXPECT_EQ(pool.get(handles[5])->getNutrition(), 6);
+	EXPECT_EQ(pool.despawnIf([](const Objects::Food& food) { return food.shallDestruct(); }), 2);
+	EXPECT_EQ(pool.size(), 8);
+	EXPECT_EQ(grid.size(), 8);
+	EXPECT_EQ(pool.get(handles[2]), nullptr);
+	EXPECT_FALSE(pool.isAlive(handles[5]));
+	pool.despawn(handles[5]);
+	EXPECT_EQ(pool.size(), 8);
+
+	// Freed slots are reused without growing the pool, with a new generation.
+	const auto reused = pool.spawn(42);
+	EXPECT_EQ(reused.index, handles[5].index);
+	EXPECT_NE(reused, handles[5]);
+	EXPECT_EQ(pool.get(handles[5]), nullptr);
+	EXPECT_EQ(pool.getCapacity(), 12);
+
+	int nutrition = 0;
+	pool.forEach([&](Objects::Food& food) { nutrition += food.getNutrition(); });
+	EXPECT_EQ(nutrition, 1 + 2 + 4 + 5 + 7 + 8 + 9 + 10 + 42);
+	pool.clear();
+	EXPECT_EQ(pool.size(), 0);
+	EXPECT_EQ(grid.size(), 0);
+	// Despawning doesn't allocate, even when the objects span several slabs.
+	std::vector<Utils::ObjectPool<Objects::Food, 4>::Handle> many;
+	for (int i = 0; i < 1024; ++i) {
+		many.push_back(pool.spawn(1));
+	}
+	const size_t allocationsBefore = allocationsCount;
+	for (const auto handle : many) {
+		pool.despawn(handle);
+	}
+	EXPECT_EQ(allocationsCount - allocationsBefore, 0);
+	EXPECT_EQ(pool.size(), 0);
+
+	const Objects::Food outside(1);
+	EXPECT_THROW(pool.getHandle(outside), std::runtime_error);
+}
+
+TEST(Evolution_improvesAndIsDeterministic, NEURAL_NETWORK_TESTS) {
+	const CognitiveSystems::Topology topology(3, { 6 }, 2);
+	const std::vector<float> inputs{ 0.2f, 0.9f, 0.4f };
+	const std::vector<float> expected{ 0.9f, 0.1f };
+	const auto fitness = [&](const Evolution::Brain& brain, std::uint64_t) {
+		CognitiveSystems::Workspace workspace;
+		const auto outputs = brain.feedForward(inputs, workspace);
+		float error = 0;
+		for (size_t i = 0; i < expected.size(); ++i) {
+			error += (outputs[i] - expected[i]) * (outputs[i] - expected[i]);
+		}
+		return -error;
+	};
+
+	Evolution::EvolutionOptions options;
+	options.populationSize = 32;
+	options.threadsNumber = 1;
+	Evolution::Engine engine(topology, options, fitness);
+	options.threadsNumber = 3;
+	Evolution::Engine parallel(topology, options, fitness);
+	EXPECT_EQ(engine.getPopulation().getGenomeSize(), size_t(3 * 6 + 6 * 2));
+
+	const auto first = engine.step();
+	parallel.step();
+	Evolution::GenerationReport last;
+	for (int generation = 0; generation < 40; ++generation) {
+		last = engine.step();
+		parallel.step();
+	}
+	EXPECT_EQ(last.generation, 40);
+	EXPECT_GT(last.bestFitness, first.bestFitness);
+	for (size_t g = 0; g < engine.getPopulation().size(); ++g) {
+		const auto genome = engine.getPopulation().getGenome(g);
+		const auto parallelGenome = parallel.getPopulation().getGenome(g);
+		ASSERT_TRUE(std::equal(genome.begin(), genome.end(), parallelGenome.begin()));
+	}
+
+	Evolution::Brain best(topology);
+	engine.loadBest(best);
+	EXPECT_FLOAT_EQ(fitness(best, 0), last.bestFitness);
+
+	// Children are bred in the arenas of the population.
+	engine.evaluate();
+	const size_t allocationsBefore = allocationsCount;
+	engine.breed();
+	EXPECT_EQ(allocationsCount - allocationsBefore, 0);
+
+	// Brains are evaluated in worlds by default.
+	constexpr auto FEATURES = static_cast<int>(Entities::Senses::FEATURES_NUMBER);
+	constexpr auto ACTIONS = static_cast<int>(Entities::Senses::ACTIONS_NUMBER);
+	Evolution::WorldOptions world;
+	world.ticks = 20;
+	options.populationSize = 8;
+	Evolution::Engine worldEngine(CognitiveSystems::Topology(FEATURES, { 8 }, ACTIONS), options, Evolution::Engine::makeWorldFitness(world));
+	const auto report = worldEngine.step();
+	EXPECT_GE(report.bestFitness, report.meanFitness);
+	EXPECT_LE(report.bestFitness, static_cast<float>(world.food));
+	EXPECT_THROW(Evolution::Engine(topology, { 0 }, fitness), std::runtime_error);
+	options.elites = options.populationSize;
+	EXPECT_NO_THROW(Evolution::Engine(topology, options, fitness));
+	options.elites = 0;
+	options.mutationStrength = -1.f;
+	EXPECT_THROW(Evolution::Engine(topology, options, fitness), std::runtime_error);
+
+	// Without crossover and mutation strength every child is a copy of a parent.
+	options.mutationStrength = 0.f;
+	options.mutationRate = 1.f;
+	options.crossoverRate = 0.f;
+	Evolution::Engine copies(topology, options, fitness);
+	const Evolution::Population parents = copies.getPopulation();
+	copies.step();
+	for (size_t g = 0; g < copies.getPopulation().size(); ++g) {
+		const auto child = copies.getPopulation().getGenome(g);
+		bool isCopy = false;
+		for (size_t p = 0; p < parents.size() && !isCopy; ++p) {
+			const auto parent = parents.getGenome(p);
+			isCopy = std::equal(child.begin(), child.end(), parent.begin());
+		}
+		EXPECT_TRUE(isCopy);
+	}
+}
+
+TEST(HeadlessRunner_reportsAndIsReproducible, NEURAL_NETWORK_TESTS) {
+	Entities::HeadlessOptions options;
+	options.ticks = 250;
+	options.worms = 300;
+	options.food = 600;
+	options.walls = 5;
+	options.worldSize = 2000;
+	options.timestep = 0.5;
+	options.reportEvery = 100;
+	options.threadsNumber = 2;
+
+	std::vector<Entities::HeadlessReport> reports;
+	Entities::World world;
+	Entities::HeadlessRunner runner(options, [&](const Entities::HeadlessReport& report) { reports.push_back(report); });
+	runner.populate(world);
+	EXPECT_EQ(world.size(), 905);
+	const auto result = runner.run(world);
+
+	// Reports every 100 ticks, and one for the last ticks.
+	ASSERT_EQ(reports.size(), 3);
+	EXPECT_EQ(reports[0].tick, 100);
+	EXPECT_EQ(reports[1].tick, 200);
+	EXPECT_EQ(reports[2].tick, 250);
+	EXPECT_EQ(result.tick, 250);
+	EXPECT_DOUBLE_EQ(result.simulatedSeconds, 125.0);
+	EXPECT_GT(result.ticksPerSecond, 0);
+	EXPECT_GT(result.agentsPerSecond, result.ticksPerSecond);
+	EXPECT_GT(result.statistics.eaten, 0);
+	EXPECT_LE(result.food, options.food);
+	EXPECT_EQ(result.worms, world.getWorms().size());
+
+	// The same seed gives the same world, for any number of threads.
+	options.threadsNumber = 1;
+	Entities::World sameWorld;
+	Entities::HeadlessRunner sameRunner(options);
+	sameRunner.populate(sameWorld);
+	const auto sameResult = sameRunner.run(sameWorld);
+	EXPECT_EQ(sameResult.statistics.eaten, result.statistics.eaten);
+	EXPECT_EQ(sameResult.statistics.died, result.statistics.died);
+	ASSERT_EQ(sameWorld.getWorms().size(), world.getWorms().size());
+	EXPECT_EQ(sameWorld.getWorms().x, world.getWorms().x);
+	EXPECT_EQ(sameWorld.getWorms().y, world.getWorms().y);
+	EXPECT_EQ(sameWorld.getFood().x, world.getFood().x);
+
+	options.timestep = 0;
+	EXPECT_THROW(Entities::HeadlessRunner{ options }, std::runtime_error);
+}
+
+TEST(Snapshot_restoreAndResume, NEURAL_NETWORK_TESTS) {
+	const auto directory = std::filesystem::temp_directory_path();
+	const auto path = directory / "world_snapshot_test.bin";
+	const auto runPath = directory / "world_snapshot_run_test.bin";
+
+	constexpr auto FEATURES = static_cast<int>(Entities::Senses::FEATURES_NUMBER);
+	constexpr auto ACTIONS = static_cast<int>(Entities::Senses::ACTIONS_NUMBER);
+	CognitiveSystems::NeuralNetwork brain(CognitiveSystems::Topology(FEATURES, { 8, 6 }, ACTIONS));
+	brain.getModifiableLayers()[2].getModifiableWeights()(1, 3) = 0.25f;
+
+	Entities::World world;
+	std::vector<Entities::Entity> worms;
+	for (int i = 0; i < 50; ++i) {
+		worms.push_back(world.createWorm({ i, 2 * i }, { 100 + i, 2, 10, 1, 40 }));
+		world.createFood({ -i, i }, i + 1, i % 2 ? Objects::Food::FoodType::HardFood : Objects::Food::FoodType::SoftFood);
+	}
+	world.createWall({ 7, 7 });
+	world.destroy(worms[10]);
+	world.getWorms().energy[3] = 13;
+	const std::vector<const CognitiveSystems::NeuralNetwork*> brains{ &brain };
+	Entities::Snapshot::write(path, world, brains, 42);
+
+	// The restored world has the same columns, the same free slots and the same handles.
+	Entities::World restored;
+	restored.createWall({ 1, 1 });
+	auto result = Entities::Snapshot::restore(path, restored);
+	EXPECT_EQ(result.tick, 42);
+	EXPECT_EQ(restored.size(), world.size());
+	EXPECT_EQ(restored.getWorms().entities, world.getWorms().entities);
+	EXPECT_EQ(restored.getWorms().x, world.getWorms().x);
+	EXPECT_EQ(restored.getWorms().health, world.getWorms().health);
+	EXPECT_EQ(restored.getWorms().energy, world.getWorms().energy);
+	EXPECT_EQ(restored.getFood().nutrition, world.getFood().nutrition);
+	EXPECT_EQ(restored.getFood().foodType, world.getFood().foodType);
+	EXPECT_EQ(restored.getWalls().y, world.getWalls().y);
+	EXPECT_FALSE(restored.isAlive(worms[10]));
+	EXPECT_TRUE(restored.isAlive(worms[11]));
+	EXPECT_EQ(restored.getCoordinates(worms[11]).y, world.getCoordinates(worms[11]).y);
+	EXPECT_EQ(restored.createFood({ 0, 0 }, 1), world.createFood({ 0, 0 }, 1));
+	ASSERT_EQ(result.brains.size(), 1);
+	EXPECT_EQ(result.brains[0].getTopology().getHiddenLayers(), std::vector<int>({ 8, 6 }));
+	EXPECT_FLOAT_EQ(result.brains[0].getLayers()[2].getWeights()(1, 3), 0.25f);
+
+	{
+		std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+		file.seekp(-4, std::ios::end);
+		file.write("\x7f\x7f\x7f\x7f", 4);
+	}
+	const auto before = restored.size();
+	EXPECT_THROW(Entities::Snapshot::restore(path, restored), std::runtime_error);
+	EXPECT_EQ(restored.size(), before);
+
+	// A run resumed from a snapshot ends in the same world as the run that was not interrupted.
+	Entities::HeadlessOptions options;
+	options.worms = 200;
+	options.food = 400;
+	options.worldSize = 1500;
+	options.reportEvery = 0;
+	options.threadsNumber = 1;
+	options.ticks = 120;
+	Entities::World uninterrupted;
+	Entities::HeadlessRunner runner(options);
+	runner.populate(uninterrupted);
+	runner.run(uninterrupted);
+
+	options.ticks = 60;
+	options.snapshotEvery = 20;
+	options.snapshotPath = runPath;
+	Entities::World interrupted;
+	{
+		Entities::HeadlessRunner first(options);
+		first.populate(interrupted);
+		first.run(interrupted);
+	}
+	options.ticks = 120;
+	options.snapshotEvery = 0;
+	Entities::World resumed;
+	Entities::HeadlessRunner second(options);
+	EXPECT_EQ(second.resume(runPath, resumed), 60);
+	const auto report = second.run(resumed);
+	EXPECT_EQ(report.tick, 120);
+	EXPECT_EQ(resumed.getWorms().entities, uninterrupted.getWorms().entities);
+	EXPECT_EQ(resumed.getWorms().x, uninterrupted.getWorms().x);
+	EXPECT_EQ(resumed.getWorms().health, uninterrupted.getWorms().health);
+	EXPECT_EQ(resumed.getFood().x, uninterrupted.getFood().x);
+
+	// The writer writes in the background what the simulation submits.
+	{
+		Entities::Snapshot::Writer writer(path);
+		for (std::uint64_t tick = 1; tick <= 5; ++tick) {
+			world.getWorms().energy[0] = static_cast<int>(tick);
+			writer.submit(world, brains, tick);
+		}
+		writer.wait();
+		EXPECT_GE(writer.getWrittenNumber(), 1);
+	}
+	result = Entities::Snapshot::restore(path, restored);
+	EXPECT_EQ(result.tick, 5);
+	EXPECT_EQ(restored.getWorms().energy[0], 5);
+
+	std::filesystem::remove(path);
+	std::filesystem::remove(runPath);
+}